@@ -2,6 +2,7 @@
 #include "rank25p.h"
 #include "rank6p.h"
 #include "rank3p.h"
+#include "rank14p.h"
 #include "rrr.h"
 #include "rrr2.h"
 #include "rrr3.h"
@@ -28,6 +29,8 @@ struct RankBMFix: public SharedFixtureItf {
 			for (unsigned int j = 0; j < queries_cnt; ++j) {
 				queries.push_back(utils::rand32() % size);
 			}
+			queries64.assign(queries.begin(), queries.end());
+			results.resize(queries64.size());
 			Rank25pBuilder br25;
 			br25.build(ba, &r25);
 
@@ -37,6 +40,9 @@ struct RankBMFix: public SharedFixtureItf {
 			Rank3pBuilder br3;
 			br3.build(ba, &r3);
 
+			Rank14pBuilder br14;
+			br14.build(ba, &r14);
+
 			RRRBuilder brrr;
 			brrr.build(ba, &rr);
 
@@ -49,10 +55,13 @@ struct RankBMFix: public SharedFixtureItf {
 
 	void TearDown() {
 		queries.clear();
+		queries64.clear();
+		results.clear();
 		ba.clear();
 		r25.clear();
 		r6.clear();
 		r3.clear();
+		r14.clear();
 		rr.clear();
 		rr3.clear();
 		rr3.clear();
@@ -60,9 +69,11 @@ struct RankBMFix: public SharedFixtureItf {
 
 	BitArray ba;
 	vector<unsigned int> queries;
+	vector<uint64_t> queries64, results;
 	Rank25p r25;
 	Rank6p r6;
 	Rank3p r3;
+	Rank14p r14;
 	RRR rr;
 	RRR2 rr2;
 	RRR3_Rank rr3;
@@ -90,6 +101,10 @@ void rankbm_rank6(RankBMFix * fix) {
 	}
 }
 
+void rankbm_rank6_batch(RankBMFix * fix) {
+	fix->r6.rank_batch(fix->queries64.data(), fix->queries64.size(), fix->results.data());
+}
+
 void rankbm_rank3(RankBMFix * fix) {
 	unsigned int t = 0;
 	for (auto p : fix->queries) {
@@ -97,6 +112,13 @@ void rankbm_rank3(RankBMFix * fix) {
 	}
 }
 
+void rankbm_rank14(RankBMFix * fix) {
+	unsigned int t = 0;
+	for (auto p : fix->queries) {
+		t ^= fix->r14.rank(p);
+	}
+}
+
 void rankbm_rankrr(RankBMFix * fix) {
 	unsigned int t = 0;
 	for (auto p : fix->queries) {
@@ -124,7 +146,9 @@ BENCHMARK_SET(rank_benchmark) {
 	bm.n_samples = 3;
 	bm.add("rank25", rankbm_rank25, 15);
 	bm.add("rank6", rankbm_rank6, 15);
+	bm.add("rank6_batch", rankbm_rank6_batch, 15);
 	bm.add("rank3", rankbm_rank3, 15);
+	bm.add("rank14", rankbm_rank14, 15);
 	bm.add("rankrrr", rankbm_rankrr, 15);
 	bm.add("rankrrr2", rankbm_rankrr2, 15);
 	bm.add("rankrrr3", rankbm_rankrr3, 15);
@@ -44,30 +44,48 @@ public:
 	static BitArray adopt(size_t bitlen, StaticMemRegionPtr p);
 };
 
+/** Word access through a memory region. When the region is fully mapped (or can be
+mapped on request), its address is resolved once and words are read with plain loads;
+otherwise, e.g. for remote regions, every read goes through the region's virtual API. */
 struct MemRegionWordAccess: public WordAccessInterface {
 	MemRegionWordAccess() = default;
 	MemRegionWordAccess(const MemRegionWordAccess& other) = default;
-	MemRegionWordAccess(MemRegionWordAccess&& other): _data(std::move(other._data)) {};
-	MemRegionWordAccess(const StaticMemRegionPtr& o): _data(o) {}
-	MemRegionWordAccess(StaticMemRegionPtr&& o): _data(std::move(o)) {}
+	MemRegionWordAccess(MemRegionWordAccess&& other): _data(std::move(other._data)), _addr(other._addr) {};
+	MemRegionWordAccess(const StaticMemRegionPtr& o): _data(o) { map_direct(); }
+	MemRegionWordAccess(StaticMemRegionPtr&& o): _data(std::move(o)) { map_direct(); }
 	MemRegionWordAccess& operator=(const MemRegionWordAccess& other) = default;
-	MemRegionWordAccess& operator=(MemRegionWordAccess&& other) { _data = other._data; return *this; }
+	MemRegionWordAccess& operator=(MemRegionWordAccess&& other) { _data = other._data; _addr = other._addr; return *this; }
 
-	MemRegionWordAccess& operator=(const StaticMemRegionPtr& other) { _data = other; return *this; }
+	MemRegionWordAccess& operator=(const StaticMemRegionPtr& other) { _data = other; map_direct(); return *this; }
 
-	void load(InpArchive& ar) { _data = ar.load_mem_region(); }
+	void load(InpArchive& ar) { _data = ar.load_mem_region(); map_direct(); }
 	void save(OutArchive& ar) const { ar.save_mem(_data); }
 
-	uint64_t word(size_t i) const { return _data.getword(i); }
+	uint64_t word(size_t i) const { return (_addr != nullptr) ? _addr[i] : _data.getword(i); }
 	void setword(size_t i, uint64_t v) { _data.setword(i, v); }
 	uint8_t byte(size_t i) const {
 		/*uint64_t _word = this->getword(i / 8);
 		return (uint8_t)((_word >> (8*(i % 8))) & 0xFF);*/
+		if (_addr != nullptr) return ((const uint8_t*)_addr)[i];
 		return _data.getchar(i);
 	}
 
 	uint8_t popcntw(size_t i) const { return popcnt(word(i)); }
+	/** returns the address of the words, or nullptr if the region is not directly addressable */
+	const uint64_t* word_addr() const { return _addr; }
 	StaticMemRegionPtr _data;
+private:
+	const uint64_t* _addr = nullptr;
+	void map_direct() {
+		_addr = nullptr;
+		if (_data.is_null() || _data.size() == 0) return;
+		MemoryAccessType tp = _data.memory_type();
+		if (tp == MAP_ON_REQUEST && !_data.request_map(0, _data.size())) return;
+		if (tp != FULL_MAPPING && tp != MAP_ON_REQUEST) return;
+		const void* p = _data.get_addr();
+		if (p != nullptr && ((uintptr_t)p & 7) == 0)
+			_addr = (const uint64_t*)p;
+	}
 };
 
 
@@ -90,6 +108,7 @@ public:
 	void save_nocls(OutArchive& ar) const;
 
 	StaticMemRegionPtr data_ptr() const { return _data._data; }
+	const uint64_t* word_addr() const { return _data.word_addr(); }
 	friend class BitArrayBuilder;
 };
 
@@ -17,6 +17,8 @@ struct WordAccessInterface {
 		return (uint8_t)((_word >> (8*(i % 8))) & 0xFF);
 	}
 	virtual uint8_t popcntw(size_t i) const { return popcnt(word(i)); }
+	/** returns the address of the words if they can be read directly, otherwise nullptr */
+	virtual const uint64_t* word_addr() const { return nullptr; }
 };
 
 struct BitArrayInterface: public WordAccessInterface {
@@ -49,6 +51,22 @@ struct BitArrayInterface: public WordAccessInterface {
 	virtual std::string to_str() const;
 };
 
+/// reads words with plain loads from a directly addressable array
+struct DirectWordAccess {
+	explicit DirectWordAccess(const uint64_t* p): ptr(p) {}
+	uint64_t word(size_t i) const { return ptr[i]; }
+	uint8_t popcntw(size_t i) const { return popcnt(ptr[i]); }
+	const uint64_t* ptr;
+};
+
+/// reads words through the (virtual) BitArrayInterface
+struct InterfaceWordAccess {
+	explicit InterfaceWordAccess(const BitArrayInterface* b): bits(b) {}
+	uint64_t word(size_t i) const { return bits->word(i); }
+	uint8_t popcntw(size_t i) const { return bits->popcntw(i); }
+	const BitArrayInterface* bits;
+};
+
 /// BitArray
 template<typename WordAccess>
 class BitArrayGeneric: public BitArrayInterface {
@@ -43,7 +43,10 @@ void OByteStream::puts(const char *str, unsigned int len) {
 
 void OByteStream::build(BitArray *out) {
 	LocalMemAllocator alloc;
-	*out = BitArrayBuilder::adopt(os.size() * 8, alloc.move(os));
+	size_t len = os.size();
+	// the bit array is accessed by words, pads the last word
+	while (os.size() % 8 != 0) os.append((char)0);
+	*out = BitArrayBuilder::adopt(len * 8, alloc.move(os));
 }
 
 
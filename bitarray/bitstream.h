@@ -128,7 +128,11 @@ private:
 	uint16_t j;
 	size_t ptr;
 	const WordAccessInterface* data;
+	/// the words of `data' if they can be read directly, otherwise nullptr
+	const uint64_t* wptr;
 	MemRegionWordAccess _own_data;
+
+	uint64_t fetch(size_t i) const { return (wptr != nullptr) ? wptr[i] : data->word(i); }
 };
 
 
@@ -263,10 +267,11 @@ inline bool OBitStream::getbit(uint64_t pos) const { return (os.getword(pos / WO
 
 inline void IWBitStream::_init_(const WordAccessInterface* _data, size_t blen, size_t start_idx) {
 	data = _data;
+	wptr = data->word_addr();
 	ptr = (start_idx / WORDLEN);
 	this->blen = blen - start_idx + (start_idx % WORDLEN);
 	if (blen > 0) {
-		cur = data->word(ptr);
+		cur = fetch(ptr);
 		++ptr;
 	} else { cur = 0; }
 	nxt = 0;
@@ -282,6 +287,7 @@ inline void IWBitStream::clear() {
 	ptr = 0;
 	//_extracted = 0;
 	data = nullptr;
+	wptr = nullptr;
 }
 
 inline void IWBitStream::skipw(uint16_t len) {
@@ -296,7 +302,7 @@ inline void IWBitStream::skipw(uint16_t len) {
 	} else {
 		//fetch next word
 		if (blen > WORDLEN + j) {
-			nxt = data->word(ptr);
+			nxt = fetch(ptr);
 			++ptr;
 		} else nxt = 0;
 		j = WORDLEN + j - len;
@@ -322,7 +328,7 @@ inline void IWBitStream::skipw_other(uint16_t len) {
 	if (len > j) {
 		cur |= nxt >> (len - j);
 		len -= j;
-		nxt = data->word(ptr);
+		nxt = fetch(ptr);
 		++ptr;
 		j = WORDLEN;
 	}
@@ -334,6 +340,14 @@ inline void IWBitStream::skipw_other(uint16_t len) {
 
 
 inline unsigned int IWBitStream::scan_next1() {
+	// the next 1 bit is usually in the buffered word
+	if (cur != 0) {
+		unsigned int c = lsb_intr(cur);
+		if (c < blen) {
+			skipw(c + 1);
+			return c;
+		}
+	}
 	unsigned int c = 0;
 	while (j > 0) {
 		if (!getb()) c++;
@@ -0,0 +1,192 @@
+#include "rank14p.h"
+#include "bitop.h"
+#include "mem/local_mem.h"
+#include <stdexcept>
+#include <vector>
+
+namespace mscds {
+
+// allocates the line array aligned to cache lines, so that each line
+// occupies exactly one 64-byte cache line
+BitArray Rank14pBuilder::alloc_lines(size_t nwords) {
+	if (nwords == 0) return BitArray();
+	const size_t bytes = nwords * 8;
+	std::shared_ptr<char> raw(new char[bytes + 64], std::default_delete<char[]>());
+	char * p = raw.get();
+	p += (64 - ((uintptr_t)p % 64)) % 64;
+	std::shared_ptr<void> aligned(raw, p);
+	LocalMemAllocator alloc;
+	return BitArrayBuilder::adopt(nwords * 64, alloc.adoptMem(bytes, aligned));
+}
+
+void Rank14pBuilder::build(const BitArrayInterface& b, Rank14p * o) {
+	const uint64_t len = b.length();
+	if (len >= (1ULL << Rank14p::ABS_BITS)) throw std::runtime_error("bit array is too long");
+	o->clear();
+	const uint64_t nlines = (len + Rank14p::LINE_BITS - 1) / Rank14p::LINE_BITS;
+	o->lines = alloc_lines(nlines * Rank14p::LINE_WORDS);
+	o->bitlen = len;
+
+	std::vector<uint64_t> lrank(nlines), lrank0(nlines);
+	const size_t wc = b.word_count();
+	uint64_t cnt = 0;
+	size_t wi = 0;
+	for (uint64_t line = 0; line < nlines; ++line) {
+		lrank[line] = cnt;
+		lrank0[line] = line * Rank14p::LINE_BITS - cnt;
+		uint64_t sub = 0, sub1 = 0, sub2 = 0;
+		for (unsigned int j = 0; j < Rank14p::DATA_WORDS; ++j) {
+			if (j == 3) sub1 = sub;
+			if (j == 5) sub2 = sub;
+			uint64_t w = 0;
+			if (wi < wc) {
+				w = b.word(wi);
+				// clear the padding bits in the last word
+				if ((wi + 1) * 64 > len) w &= (~0ULL) >> ((wi + 1) * 64 - len);
+			}
+			o->lines.setword(line * Rank14p::LINE_WORDS + 1 + j, w);
+			sub += popcnt(w);
+			++wi;
+		}
+		o->lines.setword(line * Rank14p::LINE_WORDS, cnt | (sub1 << Rank14p::ABS_BITS) | (sub2 << (Rank14p::ABS_BITS + 8)));
+		cnt += sub;
+	}
+	o->onecnt = cnt;
+	o->hints = bsearch_hints(lrank.begin(), nlines, cnt, Rank14p::SELECT_RATE);
+	o->hints0 = bsearch_hints(lrank0.begin(), nlines, len - cnt, Rank14p::SELECT_RATE);
+}
+
+//------------------------------------------------------------------------
+
+void Rank14p::save(OutArchive& ar) const {
+	ar.startclass("Rank14p", 1);
+	ar.var("bit_len").save(bitlen);
+	ar.var("onecnt").save(onecnt);
+	lines.save(ar.var("lines"));
+	hints.save(ar.var("select_hints"));
+	hints0.save(ar.var("selectzero_hints"));
+	ar.endclass();
+}
+
+void Rank14p::load(InpArchive& ar) {
+	ar.loadclass("Rank14p");
+	ar.var("bit_len").load(bitlen);
+	ar.var("onecnt").load(onecnt);
+	lines.load(ar.var("lines"));
+	hints.load(ar.var("select_hints"));
+	hints0.load(ar.var("selectzero_hints"));
+	ar.endclass();
+	if (lines.word_count() != ((bitlen + LINE_BITS - 1) / LINE_BITS) * LINE_WORDS)
+		throw std::runtime_error("length mismatch");
+}
+
+void Rank14p::clear() {
+	lines.clear();
+	hints.clear();
+	hints0.clear();
+	bitlen = 0;
+	onecnt = 0;
+}
+
+std::string Rank14p::to_str() const {
+	std::string s;
+	for (uint64_t i = 0; i < bitlen; ++i)
+		s += access(i) ? '1' : '0';
+	return s;
+}
+
+bool Rank14p::access(uint64_t pos) const {
+	assert(pos < bitlen);
+	const uint64_t line = pos / LINE_BITS;
+	const unsigned int off = pos % LINE_BITS;
+	return ((dataword(line, off >> 6) >> (off & 63)) & 1) != 0;
+}
+
+uint64_t Rank14p::rank(uint64_t p) const {
+	assert(p <= bitlen);
+	if (p == bitlen) return onecnt;
+	const uint64_t line = p / LINE_BITS;
+	const unsigned int off = p % LINE_BITS;
+	const unsigned int j = off >> 6;
+	const uint64_t c = lines.word(line * LINE_WORDS);
+	uint64_t val = c & ABS_MASK;
+	unsigned int i = 0;
+	if (j >= 5) {
+		val += c >> (ABS_BITS + 8);
+		i = 5;
+	} else if (j >= 3) {
+		val += (c >> ABS_BITS) & 0xFF;
+		i = 3;
+	}
+	for (; i < j; ++i)
+		val += popcnt(dataword(line, i));
+	if ((off & 63) != 0)
+		val += popcnt(dataword(line, j) & ((1ULL << (off & 63)) - 1));
+	return val;
+}
+
+uint64_t Rank14p::selectline(uint64_t line, uint64_t d) const {
+	const uint64_t c = lines.word(line * LINE_WORDS);
+	const uint64_t sub1 = (c >> ABS_BITS) & 0xFF, sub2 = c >> (ABS_BITS + 8);
+	unsigned int j = 0;
+	if (d >= sub2) { d -= sub2; j = 5; }
+	else if (d >= sub1) { d -= sub1; j = 3; }
+	for (; j < DATA_WORDS; ++j) {
+		uint64_t w = dataword(line, j);
+		unsigned int wr = popcnt(w);
+		if (d < wr)
+			return line * LINE_BITS + j * 64 + selectword(w, d);
+		d -= wr;
+	}
+	assert(false);
+	return ~0ull;
+}
+
+uint64_t Rank14p::selectline0(uint64_t line, uint64_t d) const {
+	const uint64_t c = lines.word(line * LINE_WORDS);
+	const uint64_t sub1 = 3 * 64 - ((c >> ABS_BITS) & 0xFF), sub2 = 5 * 64 - (c >> (ABS_BITS + 8));
+	unsigned int j = 0;
+	if (d >= sub2) { d -= sub2; j = 5; }
+	else if (d >= sub1) { d -= sub1; j = 3; }
+	for (; j < DATA_WORDS; ++j) {
+		uint64_t w = ~dataword(line, j);
+		unsigned int wr = popcnt(w);
+		if (d < wr)
+			return line * LINE_BITS + j * 64 + selectword(w, d);
+		d -= wr;
+	}
+	assert(false);
+	return ~0ull;
+}
+
+uint64_t Rank14p::select(uint64_t r) const {
+	assert(r < onecnt);
+	// the answer is the last line with linerank() <= r,
+	// all lines before hints[k] have linerank() < k * 2^SELECT_RATE <= r
+	const uint64_t k = r >> SELECT_RATE;
+	uint64_t lo = hints[k], hi = hints[k + 1] + 1;
+	if (lo > 0) --lo;
+	if (hi > line_count()) hi = line_count();
+	while (hi - lo > 1) {
+		uint64_t mid = lo + (hi - lo) / 2;
+		if (linerank(mid) <= r) lo = mid;
+		else hi = mid;
+	}
+	return selectline(lo, r - linerank(lo));
+}
+
+uint64_t Rank14p::selectzero(uint64_t r) const {
+	assert(r < bitlen - onecnt);
+	const uint64_t k = r >> SELECT_RATE;
+	uint64_t lo = hints0[k], hi = hints0[k + 1] + 1;
+	if (lo > 0) --lo;
+	if (hi > line_count()) hi = line_count();
+	while (hi - lo > 1) {
+		uint64_t mid = lo + (hi - lo) / 2;
+		if (linerank0(mid) <= r) lo = mid;
+		else hi = mid;
+	}
+	return selectline0(lo, r - linerank0(lo));
+}
+
+}//namespace
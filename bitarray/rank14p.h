@@ -0,0 +1,97 @@
+#pragma once
+
+#ifndef __RANK_14P_H_
+#define __RANK_14P_H_
+
+/**
+\file
+Rank/Select data structure that interleaves the rank counters with the bits.
+
+Every 64-byte line stores one counter word followed by 7 words (448 bits) of
+the input bit vector, so a rank query touches only one cache line. The
+counter word stores the absolute rank of the line (46 bits) and two relative
+counts (after the 3rd and the 5th payload word), hence at most two `popcnt`
+are needed inside a line. The additional space is 1/7 (about 14%) of the input.
+
+Select queries use sampled hints (one every 512 1-bits or 0-bits) to narrow
+the binary search over the lines.
+
+Based on the "rank9" and "poppy" layouts.
+
+*/
+
+#include "bitarray.h"
+#include "rankselect.h"
+#include "../framework/archive.h"
+#include <cstdint>
+#include <string>
+
+
+namespace mscds {
+
+class Rank14pBuilder;
+
+/// Rank/Select data structure with counters and bits interleaved in cache lines
+class Rank14p: public RankSelectInterface {
+public:
+	Rank14p(): bitlen(0), onecnt(0) {}
+	/** counts the number of 1 in the range from 0 to (p-1) */
+	uint64_t rank(uint64_t p) const;
+	/** counts the number of 0 in the range from 0 to (p-1) */
+	uint64_t rankzero(uint64_t p) const { return p - rank(p); }
+	/** the position of the (r+1)-th 1-value (from left to right) */
+	uint64_t select(uint64_t r) const;
+	/** the position of the (r+1)-th 0-value (from left to right) */
+	uint64_t selectzero(uint64_t r) const;
+	/** returns the number of 1 in the whole array */
+	uint64_t one_count() const { return onecnt; }
+	/** returns the length of the array */
+	uint64_t length() const { return bitlen; }
+
+	/** returns the value p-th bit in the bit array */
+	bool access(uint64_t pos) const;
+	bool bit(uint64_t p) const { return access(p); }
+
+	void clear();
+	std::string to_str() const;
+
+	void load(InpArchive& ar);
+	void save(OutArchive& ar) const;
+
+	typedef Rank14pBuilder BuilderTp;
+private:
+	static const unsigned int LINE_WORDS = 8;
+	static const unsigned int DATA_WORDS = 7;
+	static const unsigned int LINE_BITS = DATA_WORDS * 64;
+	static const unsigned int ABS_BITS = 46;
+	static const uint64_t ABS_MASK = (1ULL << ABS_BITS) - 1;
+	/// one select hint every 2^SELECT_RATE 1-bits (or 0-bits)
+	static const unsigned int SELECT_RATE = 9;
+
+	uint64_t dataword(uint64_t line, unsigned int j) const { return lines.word(line * LINE_WORDS + 1 + j); }
+	uint64_t linerank(uint64_t line) const { return lines.word(line * LINE_WORDS) & ABS_MASK; }
+	uint64_t linerank0(uint64_t line) const { return line * LINE_BITS - linerank(line); }
+	uint64_t line_count() const { return lines.word_count() / LINE_WORDS; }
+
+	uint64_t selectline(uint64_t line, uint64_t d) const;
+	uint64_t selectline0(uint64_t line, uint64_t d) const;
+
+	friend class Rank14pBuilder;
+
+	BitArray lines;
+	FixedWArray hints, hints0;
+	uint64_t bitlen, onecnt;
+};
+
+/// Builder class for Rank14p
+class Rank14pBuilder {
+public:
+	static void build(const BitArrayInterface& b, Rank14p * o);
+	typedef Rank14p QueryTp;
+private:
+	static BitArray alloc_lines(size_t nwords);
+};
+
+}//namespace
+
+#endif //__RANK_14P_H_
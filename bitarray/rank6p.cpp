@@ -1,8 +1,11 @@
 #include "rank6p.h"
 #include "bitop.h"
+#include "utils/parallel.h"
 //#include "bitstream.h"
 #include <stdexcept>
 #include <algorithm>
+#include <numeric>
+#include <vector>
 
 namespace mscds {
 
@@ -11,20 +14,15 @@ uint64_t Rank6pBuilder::popcntwz(const BitArrayInterface* v, size_t idx) {
 	else return 0;
 }
 
-void Rank6pBuilder::build_aux(const BitArrayInterface *b, Rank6pAux * o) {
-	assert(b->length() <= (1ULL << 50));
-	o->bits = b;
-	uint64_t nc = ((o->bits->length() + 2047) / 2048) * 2;
-	o->inv = BitArrayBuilder::create(nc*64);
-	o->inv.fillzero();
-
-	uint64_t cnt = 0;
-	uint64_t pos = 0;
-	uint64_t i = 0;
-	while (i < o->bits->word_count()) {
+// writes the inventory of blocks [first..last), `cnt` is the rank at the start of `first`
+// returns the rank at the end of `last`
+uint64_t Rank6pBuilder::build_blocks(const BitArrayInterface* b, Rank6pAux * o, uint64_t first, uint64_t last, uint64_t cnt) {
+	uint64_t pos = first * 2;
+	uint64_t i = first * 32;
+	for (uint64_t blk = first; blk < last; ++blk) {
 		o->inv.setword(pos, cnt);
 		for (unsigned int k = 0; k < 4; k++)
-			cnt += popcntwz(o->bits, i+k);
+			cnt += popcntwz(b, i+k);
 
 		uint64_t overflow = 0;
 		for(unsigned int j = 1;  j < 8; j++) {
@@ -34,14 +32,52 @@ void Rank6pBuilder::build_aux(const BitArrayInterface *b, Rank6pAux * o) {
 			o->inv.setword(pos + 1, v2);
 			overflow |= ((val >> 9) & 3) << 2 * (j - 1);
 			for (unsigned int k = 0; k < 4; k++)
-				cnt += popcntwz(o->bits, i + j * 4 + k);
+				cnt += popcntwz(b, i + j * 4 + k);
 		}
 		uint64_t v = o->inv.word(pos);
 		v |= overflow << 50;
 		o->inv.setword(pos, v);
 		i += 8*4; pos += 2;
 	}
-	o->onecnt = cnt;
+	return cnt;
+}
+
+void Rank6pBuilder::build_aux(const BitArrayInterface *b, Rank6pAux * o) {
+	assert(b->length() <= (1ULL << 50));
+	o->set_bits(b);
+	uint64_t nc = ((o->bits->length() + 2047) / 2048) * 2;
+	o->inv = BitArrayBuilder::create(nc*64);
+	o->inv.fillzero();
+	o->onecnt = build_blocks(b, o, 0, nc / 2, 0);
+}
+
+void Rank6pBuilder::build_aux(const BitArrayInterface *b, Rank6pAux * o, unsigned int nthreads) {
+	nthreads = utils::resolve_threads(nthreads);
+	if (nthreads <= 1) {
+		build_aux(b, o);
+		return;
+	}
+	assert(b->length() <= (1ULL << 50));
+	o->set_bits(b);
+	const uint64_t nblk = (o->bits->length() + 2047) / 2048;
+	o->inv = BitArrayBuilder::create(nblk * 2 * 64);
+	o->inv.fillzero();
+	// count the 1-bits of each chunk of blocks
+	std::vector<uint64_t> cnts(nthreads + 1, 0);
+	utils::parallel_parts(nblk, nthreads, [&](unsigned int t, size_t st, size_t ed) {
+		uint64_t c = 0;
+		const size_t wed = std::min<size_t>(ed * 32, b->word_count());
+		for (size_t w = st * 32; w < wed; ++w)
+			c += b->popcntw(w);
+		cnts[t + 1] = c;
+	});
+	for (unsigned int t = 0; t < nthreads; ++t)
+		cnts[t + 1] += cnts[t];
+	// write the inventory of each chunk
+	utils::parallel_parts(nblk, nthreads, [&](unsigned int t, size_t st, size_t ed) {
+		build_blocks(b, o, st, ed, cnts[t]);
+	});
+	o->onecnt = cnts[nthreads];
 }
 
 void Rank6pBuilder::build(const BitArray &b, Rank6p *o) {
@@ -49,6 +85,11 @@ void Rank6pBuilder::build(const BitArray &b, Rank6p *o) {
 	build_aux(&o->own_bits, o);
 }
 
+void Rank6pBuilder::build(const BitArray &b, Rank6p *o, unsigned int nthreads) {
+	o->own_bits = b;
+	build_aux(&o->own_bits, o, nthreads);
+}
+
 /*
 void Rank6pBuilder::build(const BitArray &b, OutArchive &ar) {
 	ar.startclass("Rank6p", 1);
@@ -106,7 +147,7 @@ void Rank6pAux::load_aux(InpArchive &ar, const BitArrayInterface* b) {
 	ar.endclass();
 	if (b->length() != blen) throw std::runtime_error("length mismatch");
 	//if (b->count_one() != onecnt) throw std::runtime_error("count_one mismatch");
-	this->bits = b;
+	set_bits(b);
 }
 
 void Rank6p::save(OutArchive &ar) const {
@@ -146,11 +187,13 @@ void Rank6p::load(InpArchive &ar) {
 	ar.endclass();
 }
 
-bool Rank6pAux::bit(uint64_t p) const {
-	return bits->bit(p);
+uint64_t Rank6pAux::rank(const uint64_t p) const {
+	if (bwords != nullptr) return rank_w(DirectWordAccess(bwords), p);
+	else return rank_w(InterfaceWordAccess(bits), p);
 }
 
-uint64_t Rank6pAux::rank(const uint64_t p) const {
+template<typename Words>
+inline uint64_t Rank6pAux::rank_w(const Words& w, const uint64_t p) const {
 	assert(p <= bits->length());
 	if (p == bits->length()) return onecnt;
 	const uint64_t wpos = p >> 6; // div 64
@@ -158,8 +201,9 @@ uint64_t Rank6pAux::rank(const uint64_t p) const {
 
 	uint64_t val = (inv.word(blk) & 0x3FFFFFFFFFFFFULL) + subblkrank(blk, ((p >> 8) & 7ULL));
 	for (unsigned int i = 0; i < (unsigned int) (wpos & 3ULL); ++i)
-		val += bits->popcntw(i + (wpos & ~3ULL));
-	return val + word_rank(wpos, p & 63ULL);
+		val += w.popcntw(i + (wpos & ~3ULL));
+	const unsigned int off = p & 63ULL;
+	return (off > 0) ? val + popcnt(w.word(wpos) & ((1ULL << off) - 1)) : val;
 }
 
 uint64_t Rank6pAux::rankzero(uint64_t p) const {
@@ -171,10 +215,14 @@ uint64_t Rank6pAux::blkrank(size_t blk) const {
 }
 
 uint64_t Rank6pAux::subblkrank(size_t blk, unsigned int off) const {
+	return subblkrank(inv.word(blk), inv.word(blk + 1), off);
+}
+
+uint64_t Rank6pAux::subblkrank(uint64_t w0, uint64_t w1, unsigned int off) {
 	// off = [0..7]
-	const unsigned int hi = inv.word(blk) >> 50;
+	const unsigned int hi = w0 >> 50;
 	off = (off - 1) & 7;
-	uint64_t subblk_rank = (inv.word(blk + 1) >>  off * 9) & 0x1FFULL;
+	uint64_t subblk_rank = (w1 >>  off * 9) & 0x1FFULL;
 	subblk_rank |= ((hi >> off * 2) & 3ULL) << 9;
 	return subblk_rank;
 }
@@ -202,6 +250,12 @@ uint64_t Rank6pAux::select(const uint64_t r) const {
 }
 
 uint64_t Rank6pAux::selectblock(uint64_t blk, uint64_t d) const {
+	if (bwords != nullptr) return selectblock_w(DirectWordAccess(bwords), blk, d);
+	else return selectblock_w(InterfaceWordAccess(bits), blk, d);
+}
+
+template<typename Words>
+inline uint64_t Rank6pAux::selectblock_w(const Words& w, uint64_t blk, uint64_t d) const {
 	unsigned int j = 0;
 	for (unsigned int i = 0; i < 8; i++)
 		if (subblkrank(blk*2, i) <= d) j = i;
@@ -209,9 +263,9 @@ uint64_t Rank6pAux::selectblock(uint64_t blk, uint64_t d) const {
 	d = d - subblkrank(blk*2, j);
 	uint64_t widx = blk * 32 + j * 4;
 	for (unsigned int k = 0; k < 4; k++)  {
-		unsigned int wr = bits->popcntw(widx);
+		unsigned int wr = w.popcntw(widx);
 		if (d < wr)
-			return blk * 2048 + 256* j + 64 * k + selectword(bits->word(widx), d);
+			return blk * 2048 + 256* j + 64 * k + selectword(w.word(widx), d);
 		else
 			d -= wr;
 		widx += 1;
@@ -220,6 +274,118 @@ uint64_t Rank6pAux::selectblock(uint64_t blk, uint64_t d) const {
 	return ~0ull;
 }
 
+//------------------------------------------------------------------------
+// batch queries
+
+// number of queries to look ahead when prefetching inventory blocks
+static const size_t BATCH_PREFETCH_DIST = 8;
+
+static inline void prefetch_addr(const void* p) {
+#if defined(__GNUC__)
+	__builtin_prefetch(p);
+#endif
+}
+
+// returns the raw inventory words if the memory is mapped, otherwise nullptr
+const uint64_t* Rank6pAux::inv_addr() const {
+	StaticMemRegionPtr mem = inv.data_ptr();
+	if (mem.memory_type() == FULL_MAPPING)
+		return (const uint64_t*) mem.get_addr();
+	return nullptr;
+}
+
+// returns the last block in [lo..end) that has blkrank() <= r, requires blkrank(lo) <= r
+// uses exponential search starting at `lo`, so that monotone queries are cheap
+uint64_t Rank6pAux::find_block(uint64_t r, uint64_t lo) const {
+	const uint64_t end = inv.word_count() / 2;
+	uint64_t step = 1, hi = lo + 1;
+	while (hi < end && blkrank(hi) <= r) {
+		lo = hi;
+		step <<= 1;
+		hi = lo + step;
+	}
+	if (hi > end) hi = end;
+	while (hi - lo > 1) {
+		uint64_t mid = lo + (hi - lo) / 2;
+		if (blkrank(mid) <= r) lo = mid;
+		else hi = mid;
+	}
+	return lo;
+}
+
+void Rank6pAux::rank_ordered(const uint64_t* pos, const size_t* order, size_t n, uint64_t* out) const {
+	if (bwords != nullptr) rank_ordered_w(DirectWordAccess(bwords), pos, order, n, out);
+	else rank_ordered_w(InterfaceWordAccess(bits), pos, order, n, out);
+}
+
+template<typename Words>
+void Rank6pAux::rank_ordered_w(const Words& w, const uint64_t* pos, const size_t* order, size_t n, uint64_t* out) const {
+	const uint64_t len = bits->length();
+	const uint64_t* invp = inv_addr();
+	uint64_t cur_blk = ~0ull, w0 = 0, w1 = 0;
+	uint64_t cur_w = ~0ull, wrank = 0;
+	for (size_t k = 0; k < n; ++k) {
+		if (invp != nullptr && k + BATCH_PREFETCH_DIST < n) {
+			size_t f = order ? order[k + BATCH_PREFETCH_DIST] : k + BATCH_PREFETCH_DIST;
+			if (pos[f] < len) prefetch_addr(invp + ((pos[f] >> 10) & ~1ull));
+		}
+		const size_t qi = order ? order[k] : k;
+		const uint64_t p = pos[qi];
+		assert(p <= len);
+		if (p == len) { out[qi] = onecnt; continue; }
+		const uint64_t wpos = p >> 6;
+		if (wpos != cur_w) {
+			const uint64_t blk = (p >> 10) & ~1ull;
+			if (blk != cur_blk) {
+				w0 = inv.word(blk);
+				w1 = inv.word(blk + 1);
+				cur_blk = blk;
+			}
+			wrank = (w0 & 0x3FFFFFFFFFFFFULL) + subblkrank(w0, w1, ((p >> 8) & 7ULL));
+			for (uint64_t i = (wpos & ~3ULL); i < wpos; ++i)
+				wrank += w.popcntw(i);
+			cur_w = wpos;
+		}
+		const unsigned int off = p & 63ULL;
+		out[qi] = (off > 0) ? wrank + popcnt(w.word(wpos) & ((1ULL << off) - 1)) : wrank;
+	}
+}
+
+void Rank6pAux::select_ordered(const uint64_t* r, const size_t* order, size_t n, uint64_t* out) const {
+	uint64_t blk = 0;
+	for (size_t k = 0; k < n; ++k) {
+		const size_t qi = order ? order[k] : k;
+		const uint64_t rv = r[qi];
+		assert(rv < onecnt);
+		blk = find_block(rv, blk);
+		out[qi] = selectblock(blk, rv - blkrank(blk));
+	}
+}
+
+void Rank6pAux::rank_batch(const uint64_t* pos, size_t n, uint64_t* out) const {
+	if (std::is_sorted(pos, pos + n)) {
+		rank_ordered(pos, nullptr, n, out);
+		return;
+	}
+	std::vector<size_t> order(n);
+	std::iota(order.begin(), order.end(), 0);
+	std::sort(order.begin(), order.end(), [pos](size_t a, size_t b) { return pos[a] < pos[b]; });
+	rank_ordered(pos, order.data(), n, out);
+}
+
+void Rank6pAux::select_batch(const uint64_t* r, size_t n, uint64_t* out) const {
+	if (std::is_sorted(r, r + n)) {
+		select_ordered(r, nullptr, n, out);
+		return;
+	}
+	std::vector<size_t> order(n);
+	std::iota(order.begin(), order.end(), 0);
+	std::sort(order.begin(), order.end(), [r](size_t a, size_t b) { return r[a] < r[b]; });
+	select_ordered(r, order.data(), n, out);
+}
+
+//------------------------------------------------------------------------
+
 uint64_t Rank6pAux::blkrank0(size_t blk) const {
 	return blk * 2048 - (inv.word(blk*2) & 0x3FFFFFFFFFFFFULL);
 }
@@ -249,6 +415,12 @@ uint64_t Rank6pAux::selectzero(const uint64_t r) const {
 }
 
 uint64_t Rank6pAux::selectblock0(uint64_t lo, uint64_t d) const {
+	if (bwords != nullptr) return selectblock0_w(DirectWordAccess(bwords), lo, d);
+	else return selectblock0_w(InterfaceWordAccess(bits), lo, d);
+}
+
+template<typename Words>
+inline uint64_t Rank6pAux::selectblock0_w(const Words& w, uint64_t lo, uint64_t d) const {
 	unsigned int j = 0;
 	for (unsigned int i = 0; i < 8; i++)
 		if (subblkrank0(lo*2, i) <= d) j = i;
@@ -256,9 +428,9 @@ uint64_t Rank6pAux::selectblock0(uint64_t lo, uint64_t d) const {
 	d = d - subblkrank0(lo*2, j);
 	uint64_t widx = lo * 32 + j * 4;
 	for (unsigned int k = 0; k < 4; k++)  {
-		unsigned int wr = 64-bits->popcntw(widx);
+		unsigned int wr = 64-w.popcntw(widx);
 		if (d < wr)
-			return lo * 2048 + 256* j + 64 * k + selectword(~bits->word(widx), d);
+			return lo * 2048 + 256* j + 64 * k + selectword(~w.word(widx), d);
 		else
 			d -= wr;
 		widx += 1;
@@ -270,13 +442,10 @@ uint64_t Rank6pAux::selectblock0(uint64_t lo, uint64_t d) const {
 void Rank6pAux::clear() {
 	inv.clear();
 	bits = nullptr;
+	bwords = nullptr;
 	onecnt = 0;
 }
 
-unsigned int Rank6pAux::word_rank(size_t idx, unsigned int i) const {
-	return (i > 0) ? popcnt(bits->word(idx) & ((1ULL << i) - 1)) : 0;
-}
-
 //------------------------------------------------------------------------
 
 struct BlockIntIterator {
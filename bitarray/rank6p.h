@@ -40,10 +40,22 @@ public:
 	uint64_t one_count() const { return onecnt; }
 	/** returns the length of the array */
 	uint64_t length() const { return bits->length(); }
+
+	/** computes out[i] = rank(pos[i]) for i in [0..n). The queries are answered in
+	increasing position order so that the inventory of each 2048-bit block is
+	decoded only once for all queries falling inside it */
+	void rank_batch(const uint64_t* pos, size_t n, uint64_t* out) const;
+	/** computes out[i] = select(r[i]) for i in [0..n). The queries are answered in
+	increasing rank order; the block search continues from the previous answer */
+	void select_batch(const uint64_t* r, size_t n, uint64_t* out) const;
 	
 	/** returns the value p-th bit in the bit array */
-	bool access(uint64_t pos) const { return bits->bit(pos); }
-	bool bit(uint64_t p) const;
+	bool access(uint64_t pos) const { return bit(pos); }
+	bool bit(uint64_t p) const {
+		assert(p < length());
+		if (bwords != nullptr) return ((bwords[p >> 6] >> (p & 63)) & 1) != 0;
+		return bits->bit(p);
+	}
 
 	void clear();
 	
@@ -56,6 +68,8 @@ public:
 	typedef Rank6pBuilder BuilderTp;
 protected:
 	const BitArrayInterface* bits;
+	/// the words of `bits' if they can be read directly, otherwise nullptr
+	const uint64_t* bwords = nullptr;
 	BitArray inv;
 	uint64_t onecnt;
 
@@ -65,10 +79,25 @@ private:
 	uint64_t blkrank0(size_t blk) const;
 	uint64_t subblkrank0(size_t blk, unsigned int off) const;
 
+	void set_bits(const BitArrayInterface* b) { bits = b; bwords = b->word_addr(); }
+	/* the query kernels are instantiated with DirectWordAccess when the words of
+	`bits' are addressable and with InterfaceWordAccess otherwise */
+	template<typename Words>
+	uint64_t rank_w(const Words& w, uint64_t p) const;
+	template<typename Words>
+	uint64_t selectblock_w(const Words& w, uint64_t blk, uint64_t d) const;
+	template<typename Words>
+	uint64_t selectblock0_w(const Words& w, uint64_t blk, uint64_t d) const;
+	template<typename Words>
+	void rank_ordered_w(const Words& w, const uint64_t* pos, const size_t* order, size_t n, uint64_t* out) const;
+
 	uint64_t selectblock(uint64_t blk, uint64_t d) const;
+	uint64_t find_block(uint64_t r, uint64_t lo) const;
+	void rank_ordered(const uint64_t* pos, const size_t* order, size_t n, uint64_t* out) const;
+	void select_ordered(const uint64_t* r, const size_t* order, size_t n, uint64_t* out) const;
+	const uint64_t* inv_addr() const;
+	static uint64_t subblkrank(uint64_t w0, uint64_t w1, unsigned int off);
 	uint64_t selectblock0(uint64_t blk, uint64_t d) const;
-
-	unsigned int word_rank(size_t idx, unsigned int i) const;
 	friend class Rank6pBuilder;
 	friend class Rank6pHintSel;
 	friend struct BlockIntIterator;
@@ -91,9 +120,14 @@ class Rank6pBuilder {
 public:
 	static void build_aux(const BitArrayInterface* b, Rank6pAux * o);
 	static void build(const BitArray& b, Rank6p * o);
+	/** parallel build using `nthreads` threads (0 means the number of CPU cores),
+	the result is identical to the serial build */
+	static void build_aux(const BitArrayInterface* b, Rank6pAux * o, unsigned int nthreads);
+	static void build(const BitArray& b, Rank6p * o, unsigned int nthreads);
 	typedef Rank6pAux QueryTp;
 private:
 	static uint64_t popcntwz(const BitArrayInterface* v, size_t idx);
+	static uint64_t build_blocks(const BitArrayInterface* b, Rank6pAux * o, uint64_t first, uint64_t last, uint64_t cnt);
 };
 
 /// Rank6p adds select hints
@@ -2,13 +2,16 @@
 #include "rank25p.h"
 #include "rank6p.h"
 #include "rank3p.h"
+#include "rank14p.h"
 #include "rrr.h"
 #include "rrr2.h"
 #include "utils/utest.h"
 #include "utils/utils.h"
+#include "mem/info_archive.h"
 
 
 #include <vector>
+#include <algorithm>
 #include <fstream>
 #include <iostream>
 
@@ -266,6 +269,129 @@ TEST(ranktest, rank6p) {
 	cout << endl;
 }
 
+void test_rank6p_batch(const std::vector<bool>& vec) {
+	BitArray v = BitArrayBuilder::create(vec.size());
+	v.fillzero();
+	for (unsigned int i = 0; i < vec.size(); i++)
+		v.setbit(i, vec[i]);
+	Rank6p r;
+	Rank6pBuilder::build(v, &r);
+
+	std::vector<uint64_t> pos, out;
+	for (uint64_t i = 0; i <= vec.size(); ++i) pos.push_back(i);
+	out.resize(pos.size());
+	r.rank_batch(pos.data(), pos.size(), out.data());
+	for (size_t i = 0; i < pos.size(); ++i)
+		ASSERT_EQ(r.rank(pos[i]), out[i]);
+	std::random_shuffle(pos.begin(), pos.end());
+	r.rank_batch(pos.data(), pos.size(), out.data());
+	for (size_t i = 0; i < pos.size(); ++i)
+		ASSERT_EQ(r.rank(pos[i]), out[i]);
+
+	pos.clear();
+	for (uint64_t i = 0; i < r.one_count(); ++i) pos.push_back(i);
+	out.resize(pos.size());
+	r.select_batch(pos.data(), pos.size(), out.data());
+	for (size_t i = 0; i < pos.size(); ++i)
+		ASSERT_EQ(r.select(pos[i]), out[i]);
+	std::random_shuffle(pos.begin(), pos.end());
+	r.select_batch(pos.data(), pos.size(), out.data());
+	for (size_t i = 0; i < pos.size(); ++i)
+		ASSERT_EQ(r.select(pos[i]), out[i]);
+}
+
+TEST(ranktest, rank6p_batch) {
+	test_rank6p_batch(bits_one());
+	test_rank6p_batch(bits_zero());
+	test_rank6p_batch(bits_vsparse(200000));
+	for (int i = 0; i < 20; ++i) {
+		test_rank6p_batch(bits_dense(20000 + rand() % 4));
+		test_rank6p_batch(bits_sparse(20000 + rand() % 4));
+		test_rank6p_batch(bits_imbal(20000 + rand() % 4));
+	}
+}
+
+void test_rank6p_parallel(const std::vector<bool>& vec, unsigned int nthreads) {
+	BitArray v = BitArrayBuilder::create(vec.size());
+	v.fillzero();
+	for (unsigned int i = 0; i < vec.size(); i++)
+		v.setbit(i, vec[i]);
+	Rank6p r, rp;
+	Rank6pBuilder::build(v, &r);
+	Rank6pBuilder::build(v, &rp, nthreads);
+	ASSERT_EQ(r.one_count(), rp.one_count());
+	for (uint64_t i = 0; i <= vec.size(); ++i)
+		ASSERT_EQ(r.rank(i), rp.rank(i));
+	for (uint64_t i = 0; i < r.one_count(); ++i)
+		ASSERT_EQ(r.select(i), rp.select(i));
+}
+
+TEST(ranktest, rank6p_parallel) {
+	test_rank6p_parallel(bits_dense(100000), 4);
+	test_rank6p_parallel(bits_sparse(100000), 3);
+	test_rank6p_parallel(bits_imbal(100000), 7);
+	test_rank6p_parallel(bits_dense(3000), 8);
+	test_rank6p_parallel(bits_one(), 2);
+}
+
+/// wraps a region and only allows API access to it, like a remote region
+struct APIOnlyRegion: public StaticMemRegionAbstract {
+	StaticMemRegionPtr base;
+	APIOnlyRegion(const StaticMemRegionPtr& b): base(b) {}
+	MemoryAlignmentType alignment() const { return base.alignment(); }
+	MemoryAccessType memory_type() const { return API_ACCESS; }
+	const void* get_addr() const { return nullptr; }
+	bool request_map(size_t start, size_t len) { return false; }
+	size_t size() const { return base.size(); }
+	void close() {}
+	uint64_t getword(size_t wp) const { return base.getword(wp); }
+	char getchar(size_t i) const { return base.getchar(i); }
+	void setword(size_t wp, uint64_t val) { base.setword(wp, val); }
+	void setchar(size_t i, char c) { base.setchar(i, c); }
+	void read(size_t i, size_t rlen, void* dst) const { base.read(i, rlen, dst); }
+	void write(size_t i, size_t wlen, const void* dst) { base.write(i, wlen, dst); }
+	void scan(size_t i, size_t len, CallBackContext cb, void* context) const { base.scan(i, len, cb, context); }
+};
+
+void test_rank6p_direct(const std::vector<bool>& vec) {
+	BitArray v = BitArrayBuilder::create(vec.size());
+	v.fillzero();
+	for (unsigned int i = 0; i < vec.size(); i++)
+		v.setbit(i, vec[i]);
+	ASSERT_TRUE(v.word_addr() != nullptr);
+	BitArray va = BitArrayBuilder::adopt(v.length(),
+		StaticMemRegionPtr(std::make_shared<APIOnlyRegion>(v.data_ptr())));
+	ASSERT_TRUE(va.word_addr() == nullptr);
+	for (size_t i = 0; i < v.word_count(); ++i)
+		ASSERT_EQ(v.word(i), va.word(i));
+
+	Rank6p r;
+	Rank6pBuilder::build(v, &r);
+	Rank6p ra;
+	Rank6pBuilder::build(va, &ra);
+	ASSERT_EQ(r.one_count(), ra.one_count());
+	for (uint64_t i = 0; i < vec.size(); ++i)
+		ASSERT_EQ(vec[i], ra.access(i));
+	for (uint64_t i = 0; i <= vec.size(); ++i)
+		ASSERT_EQ(r.rank(i), ra.rank(i));
+	for (uint64_t i = 0; i < r.one_count(); ++i)
+		ASSERT_EQ(r.select(i), ra.select(i));
+	for (uint64_t i = 0; i < vec.size() - r.one_count(); ++i)
+		ASSERT_EQ(r.selectzero(i), ra.selectzero(i));
+	std::vector<uint64_t> pos, out(vec.size() + 1);
+	for (uint64_t i = 0; i <= vec.size(); ++i) pos.push_back(i);
+	ra.rank_batch(pos.data(), pos.size(), out.data());
+	for (size_t i = 0; i < pos.size(); ++i)
+		ASSERT_EQ(r.rank(pos[i]), out[i]);
+}
+
+TEST(ranktest, rank6p_direct) {
+	test_rank6p_direct(bits_dense(30000));
+	test_rank6p_direct(bits_sparse(30000));
+	test_rank6p_direct(bits_imbal(30001));
+	test_rank6p_direct(bits_onezero(10000));
+}
+
 TEST(ranktest, rank3p) {
 	test_rank<Rank3p>(bits_one());
 	test_rank<Rank3p>(bits_zero());
@@ -286,6 +412,49 @@ TEST(ranktest, rank3p) {
 	cout << endl;
 }
 
+TEST(ranktest, rank14p) {
+	test_rank<Rank14p>(bits_one());
+	test_rank<Rank14p>(bits_zero());
+	test_rank<Rank14p>(bits_onezero());
+	test_rank<Rank14p>(bits_oneonezero());
+	test_rank<Rank14p>(bits_zerozeroone());
+	for (int i = 0; i < 200; i++) {
+		SCOPED_TRACE("Random");
+		test_rank<Rank14p>(bits_dense(2046 + rand() % 4));
+		test_rank<Rank14p>(bits_sparse(2046 + rand() % 4));
+		test_rank<Rank14p>(bits_imbal(2046 + rand() % 4));
+		if (i % 10 == 0) cout << ".";
+	}
+	test_rank<Rank14p>(bits_dense(100000));
+	test_rank<Rank14p>(bits_sparse(100000));
+	test_rank<Rank14p>(bits_vsparse(200000));
+	test_rank<Rank14p>(bits_vsparse(200000, 4000));
+	cout << endl;
+}
+
+TEST(ranktest, rank14p_saveload) {
+	auto vec = bits_imbal(100000);
+	BitArray v = BitArrayBuilder::create(vec.size());
+	for (unsigned int i = 0; i < vec.size(); i++)
+		v.setbit(i, vec[i]);
+	Rank14p r, r2;
+	Rank14pBuilder::build(v, &r);
+	OMemArchive out;
+	r.save(out);
+	out.close();
+	IMemArchive inp(out);
+	r2.load(inp);
+	inp.close();
+	ASSERT_EQ(r.length(), r2.length());
+	ASSERT_EQ(r.one_count(), r2.one_count());
+	for (unsigned int i = 0; i <= vec.size(); i += 7)
+		ASSERT_EQ(r.rank(i), r2.rank(i));
+	for (unsigned int i = 0; i < r.one_count(); i += 3)
+		ASSERT_EQ(r.select(i), r2.select(i));
+	for (unsigned int i = 0; i < r.length() - r.one_count(); i += 3)
+		ASSERT_EQ(r.selectzero(i), r2.selectzero(i));
+}
+
 TEST(ranktest, rrr) {
 	test_rank<RRR>(bits_one());
 	test_rank<RRR>(bits_zero());
@@ -1,6 +1,7 @@
 
 #include "select_dense.h"
 #include "select_dense_block.h"
+#include "utils/parallel.h"
 
 #include <algorithm>
 
@@ -200,6 +201,99 @@ void SelectDenseBuilder::build0_aux(const BitArrayInterface *b, SelectDenseAux *
 	o->is_one_select = false;
 }
 
+// parallel version of __SelectDenseBuilder_build(): the bit array is split into chunks,
+// the matching bits of each chunk are counted, then every thread builds the blocks that
+// start inside its chunk into its own streams, which are concatenated in order
+template<typename F>
+size_t __SelectDenseBuilder_build_par(const BitArrayInterface * b, F f,
+		OBitStream& header, OBitStream& overflow, unsigned int nthreads) {
+	const size_t BLK = DenseSelectBlock::BLK_COUNT;
+	const size_t len = b->length();
+	std::vector<size_t> cnts(nthreads + 1, 0);
+	utils::parallel_parts(len, nthreads, [&](unsigned int t, size_t st, size_t ed) {
+		size_t c = 0;
+		for (size_t i = st; i < ed; ++i)
+			if (f(b->bit(i))) ++c;
+		cnts[t + 1] = c;
+	});
+	for (unsigned int t = 0; t < nthreads; ++t)
+		cnts[t + 1] += cnts[t];
+	const size_t total = cnts[nthreads];
+
+	std::vector<OBitStream> headers(nthreads), overflows(nthreads);
+	utils::parallel_parts(len, nthreads, [&](unsigned int t, size_t st, size_t ed) {
+		// blocks whose first matching bit is inside [st, ed)
+		size_t blk = (cnts[t] + BLK - 1) / BLK;
+		const size_t blk_end = (cnts[t + 1] + BLK - 1) / BLK;
+		if (blk >= blk_end) return;
+		size_t skip = blk * BLK - cnts[t];
+		std::vector<unsigned int> v(BLK);
+		unsigned p = 0;
+		DenseSelectBlock bx;
+		for (size_t i = st; i < len && blk < blk_end; ++i) {
+			if (!f(b->bit(i))) continue;
+			if (skip > 0) { --skip; continue; }
+			v[p++] = i;
+			if (p == BLK) {
+				bx.build(v, overflows[t], 0, 0);
+				headers[t].puts(bx.h.v1);
+				headers[t].puts(bx.h.v2);
+				p = 0;
+				++blk;
+			}
+		}
+		if (p > 0) {
+			v.resize(p);
+			bx.build(v, overflows[t], 0, 0);
+			headers[t].puts(bx.h.v1);
+			headers[t].puts(bx.h.v2);
+		}
+		headers[t].close();
+		overflows[t].close();
+	});
+	for (unsigned int t = 0; t < nthreads; ++t) {
+		header.append(headers[t]);
+		overflow.append(overflows[t]);
+	}
+	header.close();
+	overflow.close();
+	return total;
+}
+
+void SelectDenseBuilder::build_aux(const BitArrayInterface *b, SelectDenseAux *o, unsigned int nthreads) {
+	nthreads = utils::resolve_threads(nthreads);
+	if (nthreads <= 1) {
+		build_aux(b, o);
+		return;
+	}
+	OBitStream header;
+	OBitStream overflow;
+	auto cnt = __SelectDenseBuilder_build_par(b, [](bool v) { return v; }, header, overflow, nthreads);
+	header.build(&(o->ptrs));
+	overflow.build(&(o->overflow));
+	o->cnt = cnt;
+	o->len = b->length();
+	o->bits = b;
+	o->is_one_select = true;
+}
+
+void SelectDenseBuilder::build0_aux(const BitArrayInterface *b, SelectDenseAux *o, unsigned int nthreads) {
+	nthreads = utils::resolve_threads(nthreads);
+	if (nthreads <= 1) {
+		build0_aux(b, o);
+		return;
+	}
+	OBitStream header;
+	OBitStream overflow;
+	auto cnt = __SelectDenseBuilder_build_par(b, [](bool v) { return !v; }, header, overflow, nthreads);
+	header.build(&(o->ptrs));
+	overflow.build(&(o->overflow));
+	o->cnt = cnt;
+	o->len = b->length();
+	o->bits = b;
+	o->is_one_select = false;
+}
+
 void SelectDenseBuilder::build(const BitArray &b, SelectDense *o) {
 	build_aux(&b, o);
 }
@@ -21,6 +21,10 @@ class SelectDenseBuilder {
 public:
 	static void build_aux(const BitArrayInterface * b, SelectDenseAux * o);
 	static void build0_aux(const BitArrayInterface * b, SelectDenseAux * o);
+	/** parallel build using `nthreads` threads (0 means the number of CPU cores),
+	the result is identical to the serial build */
+	static void build_aux(const BitArrayInterface * b, SelectDenseAux * o, unsigned int nthreads);
+	static void build0_aux(const BitArrayInterface * b, SelectDenseAux * o, unsigned int nthreads);
 
 	static void build(const BitArray& b, SelectDense * o);
 	static void build0(const BitArray& b, SelectDense * o);
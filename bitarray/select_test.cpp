@@ -100,6 +100,30 @@ static void test_gen(unsigned int len, double density) {
 	}
 }
 
+static void test_parallel(unsigned int len, double density, unsigned int nthreads) {
+	BitArray b = gen_bits(len, density);
+	SelectDense qs, qp, qs0, qp0;
+	SelectDenseBuilder::build_aux(&b, &qs);
+	SelectDenseBuilder::build_aux(&b, &qp, nthreads);
+	SelectDenseBuilder::build0_aux(&b, &qs0);
+	SelectDenseBuilder::build0_aux(&b, &qp0, nthreads);
+	unsigned cnt = 0;
+	for (unsigned int i = 0; i < b.length(); ++i)
+		if (b[i]) cnt++;
+	for (unsigned int i = 0; i < cnt; ++i)
+		ASSERT_EQ(qs.pre_select(i), qp.pre_select(i));
+	for (unsigned int i = 0; i < b.length() - cnt; ++i)
+		ASSERT_EQ(qs0.pre_select(i), qp0.pre_select(i));
+}
+
+TEST(select_dense, parallel) {
+	test_parallel(100000, 0.5, 4);
+	test_parallel(100000, 0.25, 3);
+	test_parallel(100000, 0.9, 7);
+	test_parallel(3000, 0.5, 8);
+	test_parallel(500, 0.5, 4);
+}
+
 TEST(select_dense, all) {
 	test_gen(2000, 1.0);
 	test_gen(2000, 0.75);
@@ -2,9 +2,20 @@
 #include "utils/utils.h"
 
 #include <stdexcept>
+#include <algorithm>
+#include <cassert>
 
 namespace mscds {
 
+namespace {
+const MemoryCodecMethod& blk_codec(BlkCompCodec c) {
+	static const SnappyCodec snappy;
+	static const RansCodec rans;
+	if (c == BLKCOMP_RANS) return rans;
+	return snappy;
+}
+}
+
 void LineBlockBuilder::add(const std::string &line) {
 	if (line.length() > 0 && line[line.length() - 1] == '\n')
 		blkmem.append(line);
@@ -57,6 +68,7 @@ void BlkCompBuilder::init() {
 	maxblksz = 128;
 	curblksz = 0;
 	entcnt = 0;
+	codec_type = BLKCOMP_SNAPPY;
 }
 
 void BlkCompBuilder::add(const std::string &line) {
@@ -75,7 +87,7 @@ void BlkCompBuilder::flush_data() {
 	if (curblksz == 0) return;
 	bd.build();
 	blkcnt++;
-	codec.compress(bd.blkmem, &buff);
+	blk_codec(codec_type).compress(bd.blkmem, &buff);
 	os.puts(buff);
 	buff.clear();
 	pbd.add_inc(os.length());
@@ -87,6 +99,7 @@ void BlkCompBuilder::build(BlkCompQuery *data) {
 	flush_data();
 	data->entcnt = entcnt;
 	data->maxblksz = this->maxblksz;
+	data->codec_type = codec_type;
 	pbd.build(&(data->bptr));
 	os.build(&(data->bits));
 	data->prepare_ptr();
@@ -96,26 +109,37 @@ void BlkCompBuilder::build(BlkCompQuery *data) {
 
 //--------------------------------------------------------------
 
-void BlkCompQuery::init() { cache_mamager.resize_capacity(32); cache.resize(32); lastblk = -1; }
+void BlkCompQuery::init() { set_cache_size(32); }
 
-BlkCompQuery::BlkCompQuery() { init(); }
+void BlkCompQuery::set_cache_size(unsigned int cache_size) { cache.resize(cache_size); }
+
+BlkCompQuery::BlkCompQuery() { clear(); init(); }
 
 void BlkCompQuery::load(mscds::InpArchive &ar) {
-	ar.loadclass("BlockCompressor");
+	int class_version = ar.loadclass("BlockCompressor");
 	ar.var("n_entries").load(entcnt);
 	ar.var("entry_per_block").load(maxblksz);
 	bptr.load(ar.var("start_block_ptrs"));
 	bits.load(ar.var("compressed_data"));
+	// older versions have no codec field and are always compressed with snappy
+	uint32_t c = BLKCOMP_SNAPPY;
+	if (class_version >= 2)
+		ar.var("codec").load(c);
+	if (c != BLKCOMP_SNAPPY && c != BLKCOMP_RANS)
+		throw std::runtime_error("unknown block compression");
+	codec_type = (BlkCompCodec) c;
 	ar.endclass();
 	prepare_ptr();
 }
 
 void BlkCompQuery::save(mscds::OutArchive &ar) const {
-	ar.startclass("BlockCompressor");
+	ar.startclass("BlockCompressor", 2);
 	ar.var("n_entries").save(entcnt);
 	ar.var("entry_per_block").save(maxblksz);
 	bptr.save(ar.var("start_block_ptrs"));
 	bits.save(ar.var("compressed_data"));
+	uint32_t c = codec_type;
+	ar.var("codec").save(c);
 	ar.endclass();
 }
 
@@ -123,8 +147,10 @@ void BlkCompQuery::clear() {
 	maxblksz = 0;
 	entcnt = 0;
 	len = 0;
+	codec_type = BLKCOMP_SNAPPY;
 	bptr.clear();
 	bits.clear();
+	cache.reset();
 }
 
 void BlkCompQuery::getEnum(unsigned int idx, BlkCompQuery::Enum *e) const {
@@ -137,14 +163,14 @@ void BlkCompQuery::getEnum(unsigned int idx, BlkCompQuery::Enum *e) const {
 }
 
 bool BlkCompQuery::Enum::hasNext() const {
-	return idx < parent->len;
+	return idx < parent->entcnt;
 }
 
 std::string BlkCompQuery::Enum::next() {
 	std::string ret = blkdata.getline(bidx);
 	idx++;
 	bidx++;
-	if (bidx >= parent->maxblksz && idx < parent->len) {
+	if (bidx >= parent->maxblksz && idx < parent->entcnt) {
 		cblk++;
 		parent->load_blk(cblk, this->blkdata);
 		bidx = 0;
@@ -155,27 +181,28 @@ std::string BlkCompQuery::Enum::next() {
 std::string BlkCompQuery::getline(unsigned int i) const {
 	if (i >= entcnt) throw std::runtime_error("index out of range");
 	unsigned int blk = i / maxblksz;
-	const LineBlock& ref = getblk(blk);
-	return ref.getline(i % maxblksz);
+	BlockPtr ref = getblk(blk);
+	return ref->getline(i % maxblksz);
 }
 
-const LineBlock& BlkCompQuery::getblk(unsigned int b) const {
-	if (b == lastblk) return cache[lastanswer]; // read only :)
-	auto r = cache_mamager.access(b);
-	if (r.type != utils::LRU_Policy::FOUND_ENTRY)
-		load_blk(b, cache[r.index]);
-	lastblk = b;
-	lastanswer = r.index;
-	return cache[lastanswer];
+BlkCompQuery::BlockPtr BlkCompQuery::getblk(unsigned int b) const {
+	return cache.get(b, [&](LineBlock& blk) { load_blk(b, blk); });
 }
 
 void BlkCompQuery::load_blk(unsigned int blk, LineBlock& lnblk) const {
-	//assert();
-	unsigned int st = bptr.prefixsum(blk);
-	unsigned int ed = bptr.prefixsum(blk + 1);
-	//codec.uncompress_c(ptr+st, ed-st, &(lnblk.blkmem));
-	//UNDONE
-	throw std::runtime_error("not implemented");
+	size_t st = bptr.prefixsum(blk);
+	size_t ed = bptr.prefixsum(blk + 1);
+	assert(st <= ed && ed <= len);
+	StaticMemRegionPtr mem = bits.data_ptr();
+	bool ok;
+	if (mem.memory_type() == FULL_MAPPING) {
+		ok = blk_codec(codec_type).uncompress_c((const char*) mem.get_addr() + st, ed - st, &(lnblk.blkmem));
+	} else {
+		std::string buf(ed - st, '\0');
+		mem.read(st, ed - st, &buf[0]);
+		ok = blk_codec(codec_type).uncompress(buf, &(lnblk.blkmem));
+	}
+	if (!ok) throw std::runtime_error("corrupted compressed block");
 	lnblk.post_load();
 }
 
@@ -186,7 +213,7 @@ void BlkCompQuery::prepare_ptr() {
 	//UNDONE
 	//ptr = (const char*)bits.data_ptr();
 	len = bits.length() / 8;
-	lastblk = -1;
+	cache.reset();
 }
 
 
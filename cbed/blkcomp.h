@@ -10,12 +10,16 @@
 #include <string>
 #include <vector>
 #include <sstream>
+#include <memory>
 
 namespace mscds {
 
 class BlkCompBuilder;
 class BlkCompQuery;
 
+/// compression method of the blocks (stored with the data)
+enum BlkCompCodec { BLKCOMP_SNAPPY = 0, BLKCOMP_RANS = 1 };
+
 class LineBlockBuilder {
 public:
 	void add(const std::string& line);
@@ -49,6 +53,8 @@ public:
 	BlkCompBuilder() { init(); }
 	void init(Config* conf);
 	void init();
+	/** \brief selects the block compression (Snappy by default), call before adding lines */
+	void set_codec(BlkCompCodec c) { codec_type = c; }
 	void add(const std::string& line);
 	void build(BlkCompQuery* data);
 	void build(mscds::OutArchive& ar);
@@ -61,21 +67,37 @@ private:
 	std::string buff;
 
 	SDArraySmlBuilder pbd;
-	SnappyCodec codec;
+	BlkCompCodec codec_type;
 	LineBlockBuilder bd;
 	unsigned int maxblksz, curblksz, entcnt, blkcnt;
 };
 
+/**
+Query structure for lines compressed in blocks.
+
+Random access keeps the recently decompressed blocks in a bounded cache (CLOCK
+policy) that can be shared by concurrent readers; the blocks are held by shared
+pointers so that an evicted block stays valid for the readers still using it.
+Sequential scans should use the enumerator which decompresses each block once
+without going through the cache.
+*/
 class BlkCompQuery {
 public:
 	BlkCompQuery();
 	void init(); // default cache size = 32
 	void init(Config* conf) {}
-	void init(unsigned int cache_size, Config* conf) {}
+	void init(unsigned int cache_size, Config* conf) { set_cache_size(cache_size); }
+	/** \brief sets the maximum number of decompressed blocks kept in memory (drops the cached blocks) */
+	void set_cache_size(unsigned int cache_size);
 	void load(mscds::InpArchive& ar);
 	void save(mscds::OutArchive& ar) const;
 	std::string getline(unsigned int i) const;
+	size_t size() const { return entcnt; }
 	void clear();
+
+	/** \brief numbers of getline() calls answered from the cache / that decompressed a block */
+	uint64_t cache_hits() const { return cache.hits(); }
+	uint64_t cache_misses() const { return cache.misses(); }
 public:
 	class Enum : public mscds::EnumeratorInt<std::string> {
 	public:
@@ -90,7 +112,8 @@ public:
 	};
 	void getEnum(unsigned int idx, Enum * e) const;
 private:
-	const LineBlock& getblk(unsigned int b) const;
+	typedef std::shared_ptr<const LineBlock> BlockPtr;
+	BlockPtr getblk(unsigned int b) const;
 	void load_blk(unsigned int blk, LineBlock& lnblk) const;
 
 	unsigned int maxblksz;
@@ -103,13 +126,10 @@ private:
 	//const char * ptr;
 	size_t len;
 
-	SnappyCodec codec;
-
-	mutable std::vector<LineBlock> cache;
-	mutable utils::LRU_Policy cache_mamager;
+	BlkCompCodec codec_type;
 
-	mutable int lastblk;
-	mutable unsigned int lastanswer;
+	/// decompressed blocks, a copy of the query starts with an empty cache of the same size
+	mutable utils::ShardedCache<LineBlock> cache;
 	friend class BlkCompBuilder;
 };
 
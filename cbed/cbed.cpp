@@ -4,6 +4,7 @@
 #include "mem/fmap_archive2.h"
 #include "mem/info_archive.h"
 #include "utils/str_utils.h"
+#include "utils/line_reader.h"
 #include <iostream>
 #include <fstream>
 #include <stdexcept>
@@ -13,78 +14,28 @@ using namespace std;
 
 namespace app_ds {
 
+static void parse_bed(const std::string &s, utils::BedRecord& r) {
+	if (!utils::parse_bed_line(utils::StrRef(s), r))
+		throw std::runtime_error(std::string("error parsing line: ") + s);
+}
+
 void BED_Entry2::parse(const std::string &s) {
-	const char * p = s.c_str();
-	unsigned int i = 0;
-	while (*p != ' ' && *p != '\t' && i < s.length()) { ++p; ++i; }
-	this->chrom = std::string(s.c_str(), p);
-
-	if (*p == ' ' || *p == '\t') ++p;
-	else throw std::runtime_error(std::string("error parsing line: ") + s);
-	unsigned int st = 0;
-	while (*p >= '0' && *p <= '9' && i < s.length()) {
-		st = (st * 10) + (*p - '0');
-		++i;
-		++p;
-	}
-	this->st = st;
-	if (*p == ' ' || *p == '\t') ++p;
-	else throw std::runtime_error(std::string("error parsing line: ") + s);
-	unsigned int ed = 0;
-	while (*p >= '0' && *p <= '9' && i < s.length()) {
-		ed = (ed * 10) + (*p - '0');
-		++i;
-		++p;
-	}
-	this->ed = ed;
-	if ((*p == ' ' || *p == '\t') && i < s.length()) {
-		++p; this->other = std::string(p);
-	}
-	else {
-		this->other = "";
-	}
+	utils::BedRecord r;
+	parse_bed(s, r);
+	this->chrom = r.chrom.str();
+	this->st = r.st;
+	this->ed = r.ed;
+	this->other = r.raw_rest.str();
 }
 
 void app_ds::BED_Entry2::quick_parse(const std::string &s, const std::string &pre_chr) {
-	const char * p = s.c_str();
-	unsigned int i = 0;
-	while (*p != ' ' && *p != '\t' && i < pre_chr.length() && i < s.length() && *p == pre_chr[i]) {
-		++p;
-		++i;
-	}
-	// same chrom name
-	if (i == pre_chr.length() && pre_chr.length() > 0 && (*p == ' ' || *p == '\t')) {
-		this->chrom = pre_chr;
-	}
-	else {
-		while (*p != ' ' && *p != '\t' && i < s.length()) { ++p; ++i; }
-		this->chrom = std::string(s.c_str(), p);
-	}
-	if (*p == ' ' || *p == '\t') ++p;
-	else throw std::runtime_error(std::string("error parsing line: ") + s);
-	unsigned int st = 0;
-	while (*p >= '0' && *p <= '9' && i < s.length()) {
-		st = (st * 10) + (*p - '0');
-		++i;
-		++p;
-	}
-	this->st = st;
-	if (*p == ' ' || *p == '\t') ++p;
-	else throw std::runtime_error(std::string("error parsing line: ") + s);
-	unsigned int ed = 0;
-	while (*p >= '0' && *p <= '9' && i < s.length()) {
-		ed = (ed * 10) + (*p - '0');
-		++i;
-		++p;
-	}
-	this->ed = ed;
-	if ((*p == ' ' || *p == '\t') && i < s.length()) {
-		++p; this->other = std::string(p);
-	}
-	else {
-		this->other = "";
-	}
-	
+	utils::BedRecord r;
+	parse_bed(s, r);
+	if (r.chrom.equals(pre_chr)) this->chrom = pre_chr;
+	else this->chrom = r.chrom.str();
+	this->st = r.st;
+	this->ed = r.ed;
+	this->other = r.raw_rest.str();
 }
 
 void BED_Entry2::parse_other(const std::string &chrom, unsigned int start, unsigned int end, const std::string &other) {
@@ -134,12 +85,14 @@ void BEDChrQuery::save(mscds::OutArchive& ar) const {
 }
 
 void BEDChrQuery::dump_file(std::ostream &fo) {
-	unsigned int i = 0;
+	if (size() == 0) return;
+	mscds::BlkCompQuery::Enum e;
+	ext.getEnum(0, &e);
 	for (unsigned int i = 0; i < size(); ++i) {
 		fo << name << '\t';
 		auto p = pos.get(i);
 		fo << p.first << '\t' << p.second;
-		string s = ext.getline(i); // TODO: change to enumerator later
+		string s = e.next();
 		if (!s.empty())
 			fo << '\t' << s << '\n';
 		else
@@ -11,6 +11,7 @@
 #include "blkcomp.h"
 
 #include <string>
+#include <vector>
 
 
 namespace app_ds {
@@ -75,6 +76,18 @@ public:
 		return DataOut(p.first, p.second, ext.getline(i));
 	}
 	size_t size() const;
+
+	/** \brief number of entries overlapping [st, ed) */
+	size_t count_overlap(unsigned int st, unsigned int ed) const { return pos.count_overlap(st, ed); }
+	/** \brief indexes of the entries overlapping [st, ed), in increasing order */
+	std::vector<unsigned int> overlap(unsigned int st, unsigned int ed) const { return pos.overlap(st, ed); }
+	/** \brief calls f(i) for each entry i overlapping [st, ed) */
+	template<typename Func>
+	void overlap(unsigned int st, unsigned int ed, Func f) const { pos.overlap(st, ed, f); }
+	/** \brief overlap counts of many queries (faster when the queries are sorted) */
+	void count_overlap_batch(const std::vector<std::pair<unsigned int, unsigned int> >& qs,
+		std::vector<unsigned int>& out) const { pos.count_overlap_batch(qs, out); }
+	const IntvLst& intervals() const { return pos; }
 private:
 	IntvLst pos;
 	mscds::BlkCompQuery ext;
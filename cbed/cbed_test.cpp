@@ -14,6 +14,8 @@
 #include <string>
 #include <vector>
 #include <sstream>
+#include <thread>
+#include <atomic>
 
 using namespace std;
 using namespace mscds;
@@ -51,6 +53,73 @@ TEST(compressblk, test2) {
 	}
 }
 
+TEST(compressblk, cache_enum) {
+	const int n = 2000;
+	vector<string> inp;
+	for (unsigned int i = 0; i < n; ++i)
+		inp.push_back(generate_str(1 + rand() % 50));
+	BlkCompBuilder bd;
+	for (unsigned int i = 0; i < n; ++i)
+		bd.add(inp[i]);
+	BlkCompQuery qs;
+	bd.build(&qs);
+	qs.set_cache_size(4);
+	ASSERT_EQ(n, qs.size());
+
+	BlkCompQuery::Enum e;
+	for (unsigned int st = 0; st < n; st += 333) {
+		qs.getEnum(st, &e);
+		for (unsigned int i = st; i < n; ++i) {
+			ASSERT_TRUE(e.hasNext());
+			ASSERT_EQ(inp[i], e.next());
+		}
+		ASSERT_FALSE(e.hasNext());
+	}
+	// consecutive lines of a block are answered from the cache
+	for (unsigned int i = 0; i < n; ++i)
+		ASSERT_EQ(inp[i], qs.getline(i));
+	ASSERT_EQ((n + 127) / 128, qs.cache_misses());
+	ASSERT_EQ(n - qs.cache_misses(), qs.cache_hits());
+
+	std::vector<std::thread> thr;
+	std::atomic<unsigned int> wrong(0);
+	for (unsigned int t = 0; t < 4; ++t)
+		thr.emplace_back([&qs, &inp, &wrong, t]() {
+			unsigned int x = t * 7919;
+			for (unsigned int k = 0; k < 20000; ++k) {
+				x = x * 1103515245u + 12345u;
+				unsigned int i = (x >> 8) % inp.size();
+				if (qs.getline(i) != inp[i]) ++wrong;
+			}
+		});
+	for (auto& th : thr) th.join();
+	ASSERT_EQ(0, wrong);
+}
+
+TEST(compressblk, rans_codec) {
+	const int n = 1000;
+	vector<string> inp;
+	for (unsigned int i = 0; i < n; ++i)
+		inp.push_back(generate_str(1 + rand() % 80));
+	BlkCompBuilder bd;
+	bd.set_codec(BLKCOMP_RANS);
+	for (unsigned int i = 0; i < n; ++i)
+		bd.add(inp[i]);
+	OMemArchive out;
+	bd.build(out);
+	out.close();
+	IMemArchive in(out);
+	BlkCompQuery qs;
+	qs.load(in);
+	in.close();
+	for (unsigned int i = 0; i < n; ++i)
+		ASSERT_EQ(inp[i], qs.getline(i)) << "i = " << i << endl;
+	BlkCompQuery::Enum e;
+	qs.getEnum(0, &e);
+	for (unsigned int i = 0; i < n; ++i)
+		ASSERT_EQ(inp[i], e.next());
+}
+
 using namespace std;
 
 void build_ext(const string& inp, const string& out) {
@@ -177,10 +246,82 @@ TEST(Intv, rand1) {
 	}
 }
 
+static void test_overlap(const vector<pair<unsigned, unsigned> >& inp, unsigned int range) {
+	IntvLstBuilder bd;
+	for (auto p : inp)
+		bd.add(p.first, p.second);
+	IntvLst lst;
+	bd.build(&lst);
+	vector<pair<unsigned, unsigned> > qs;
+	for (unsigned int st = 0; st < range + 2; ++st)
+		for (unsigned int len = 1; len < 6; ++len)
+			qs.emplace_back(st, st + len * len);
+	for (auto q : qs) {
+		vector<unsigned int> exp;
+		for (unsigned int i = 0; i < inp.size(); ++i)
+			if (inp[i].first < q.second && inp[i].second > q.first)
+				exp.push_back(i);
+		ASSERT_EQ(exp, lst.overlap(q.first, q.second)) << q.first << " " << q.second;
+		ASSERT_EQ(exp.size(), lst.count_overlap(q.first, q.second));
+	}
+	// non-decreasing starts and ends: the scanning batch
+	vector<pair<unsigned, unsigned> > sq;
+	for (unsigned int st = 0; st < range + 2; ++st)
+		sq.emplace_back(st, st + 1 + rand() % 3);
+	for (unsigned int i = 1; i < sq.size(); ++i)
+		sq[i].second = std::max(sq[i].second, sq[i - 1].second);
+	for (auto* q : { &qs, &sq }) {
+		vector<unsigned int> cnt;
+		lst.count_overlap_batch(*q, cnt);
+		ASSERT_EQ(q->size(), cnt.size());
+		for (unsigned int i = 0; i < q->size(); ++i)
+			ASSERT_EQ(lst.count_overlap((*q)[i].first, (*q)[i].second), cnt[i]);
+	}
+}
+
+TEST(Intv, overlap) {
+	test_overlap({ { 1, 8 }, { 3, 4 }, { 3, 5 }, { 3, 5 } }, 10);
+	test_overlap({ { 0, 100 }, { 2, 3 }, { 5, 6 }, { 7, 50 }, { 60, 61 } }, 110);
+	test_overlap({}, 5);
+	for (unsigned int i = 0; i < 50; ++i)
+		test_overlap(generate_pairs(1 + rand() % 200, 300), 300);
+}
+
+TEST(Intv, overlap_saveload) {
+	auto inp = generate_pairs(500, 2000);
+	IntvLstBuilder bd;
+	for (auto p : inp)
+		bd.add(p.first, p.second);
+	IntvLst lst, lst2;
+	bd.build(&lst);
+	OMemArchive out;
+	lst.save(out);
+	out.close();
+	IMemArchive in(out);
+	lst2.load(in);
+	in.close();
+	for (unsigned int st = 0; st < 2000; st += 7) {
+		ASSERT_EQ(lst.overlap(st, st + 10), lst2.overlap(st, st + 10));
+		ASSERT_EQ(lst.count_overlap(st, st + 10), lst2.count_overlap(st, st + 10));
+	}
+}
+
 //-------------------------------
 typedef GenomeDataBuilder BEDFormatBuilder;
 typedef GenomeData BEDFormatQuery;
 
+TEST(cbed, parse_empty_columns) {
+	BED_Entry2 e;
+	e.parse("chr1\t10\t20\t\t0\t+");
+	ASSERT_EQ("chr1", e.chrom);
+	ASSERT_EQ(10, e.st);
+	ASSERT_EQ(20, e.ed);
+	ASSERT_EQ("\t0\t+", e.other);
+	e.quick_parse("chr1\t30\t40\t\t\r", "chr1");
+	ASSERT_EQ(40, e.ed);
+	ASSERT_EQ("\t", e.other);
+}
+
 TEST(cbed, access1) {
 	vector<string> lst = { "chr1	1	3	abc", "chr1	2	4	def" };
 	BEDFormatBuilder bd;
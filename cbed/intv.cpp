@@ -1,4 +1,5 @@
 #include "intv.h"
+#include <limits>
 
 namespace app_ds {
 
@@ -72,25 +73,48 @@ void IntvLstBuilder::build(IntvLst *out) {
 		}
 	}
 	bdsp.build(&(out->span));
+	out->build_overlap_index();
+}
+
+void IntvLst::build_overlap_index() {
+	size_t n = size();
+	std::vector<PosType> ends(n);
+	mscds::SDArraySmlBuilder bd;
+	PosType mx = 0;
+	for (size_t i = 0; i < n; ++i) {
+		ends[i] = end_of(i);
+		mx = std::max(mx, ends[i]);
+		bd.add_inc(mx);
+	}
+	bd.build(&maxend);
+	if (n > 0) endmax.build(ends, false);
+	else endmax.clear();
 }
 
 void IntvLst::save(mscds::OutArchive &ar) const {
-	ar.startclass("Interval_list");
+	ar.startclass("Interval_list", 2);
 	marks.save(ar.var("markers"));
 	pos.save(ar.var("positions"));
 	span.save(ar.var("span"));
+	maxend.save(ar.var("prefix_max_end"));
+	endmax.save(ar.var("end_rmq"));
 	ar.endclass();
 }
 
 void IntvLst::load(mscds::InpArchive &ar) {
-	ar.loadclass("Interval_list");
+	int class_version = ar.loadclass("Interval_list");
 	marks.load(ar.var("markers"));
 	pos.load(ar.var("positions"));
 	span.load(ar.var("span"));
+	if (class_version >= 2) {
+		maxend.load(ar.var("prefix_max_end"));
+		endmax.load(ar.var("end_rmq"));
+	} else
+		build_overlap_index();
 	ar.endclass();
 }
 
-void IntvLst::clear() { marks.clear(); pos.clear(); span.clear(); }
+void IntvLst::clear() { marks.clear(); pos.clear(); span.clear(); maxend.clear(); endmax.clear(); }
 
 std::pair<IntvLst::PosType, IntvLst::PosType> IntvLst::get(unsigned int i) const {
 	std::pair<PosType, PosType> ret;
@@ -105,5 +129,71 @@ size_t app_ds::IntvLst::size() const {
 	return pos.length() / 2;
 }
 
+size_t IntvLst::count_less(PosType x) const {
+	if (x == 0 || pos.length() == 0) return 0;
+	if (x > pos.total()) return pos.length();
+	return pos.rank(x) - 1;
+}
+
+size_t IntvLst::ends_until(PosType x) const {
+	if (x == std::numeric_limits<PosType>::max()) return size();
+	size_t c = count_less(x + 1);
+	return c - marks.rank(c);
+}
+
+size_t IntvLst::count_overlap(PosType st, PosType ed) const {
+	if (st >= ed) return 0;
+	return starts_before(ed) - ends_until(st);
+}
+
+std::vector<unsigned int> IntvLst::overlap(PosType st, PosType ed) const {
+	std::vector<unsigned int> ret;
+	overlap(st, ed, [&ret](unsigned int i) { ret.push_back(i); });
+	return ret;
+}
+
+void IntvLst::count_overlap_batch(const std::vector<std::pair<PosType, PosType> >& qs,
+		std::vector<unsigned int>& out) const {
+	size_t nq = qs.size(), np = pos.length();
+	out.resize(nq);
+	if (np == 0) {
+		std::fill(out.begin(), out.end(), 0);
+		return;
+	}
+	bool sorted = true;
+	for (size_t i = 1; i < nq && sorted; ++i)
+		sorted = qs[i - 1].first <= qs[i].first && qs[i - 1].second <= qs[i].second;
+	// one scan over the 2n positions is cheaper than nq binary searches
+	unsigned int lg = 1;
+	while ((1ull << lg) < np) ++lg;
+	if (!sorted || nq * lg < np) {
+		for (size_t i = 0; i < nq; ++i)
+			out[i] = (unsigned int) count_overlap(qs[i].first, qs[i].second);
+		return;
+	}
+	// two cursors over the sorted positions: positions < ed and positions <= st
+	mscds::SDArraySml::PSEnum ce, cs;
+	pos.getPSEnum(0, &ce);
+	pos.getPSEnum(0, &cs);
+	size_t ne = 0, ns = 0;
+	uint64_t ve = ce.next(), vs = cs.next();
+	bool he = true, hs = true;
+	for (size_t i = 0; i < nq; ++i) {
+		PosType st = qs[i].first, ed = qs[i].second;
+		if (st >= ed) { out[i] = 0; continue; }
+		while (he && ve < ed) {
+			++ne;
+			he = ne < np;
+			if (he) ve = ce.next();
+		}
+		while (hs && vs <= st) {
+			++ns;
+			hs = ns < np;
+			if (hs) vs = cs.next();
+		}
+		out[i] = (unsigned int) (marks.rank(ne) - (ns - marks.rank(ns)));
+	}
+}
+
 
 }//namespace
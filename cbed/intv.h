@@ -3,9 +3,12 @@
 #include "intarray/sdarray_sml.h"
 #include "bitarray/rank6p.h"
 #include "tree/RMQ_pm1.h"
+#include "tree/RMQ_sct.h"
 #include "bitarray/bitarray.h"
 #include "framework/archive.h"
 #include <algorithm>
+#include <vector>
+#include <utility>
 
 namespace app_ds {
 class IntvLst;
@@ -41,6 +44,14 @@ private:
 	std::vector<PosData> lst;
 };
 
+/**
+List of intervals sorted by their start positions.
+
+Overlap queries use the prefix maxima of the end positions (the intervals before
+the first prefix maximum after `st' cannot overlap [st, ed)) and a RMQ on the
+end positions to skip the remaining candidates that end before `st'.
+The enumeration costs O(1) RMQ per reported interval.
+*/
 class IntvLst {
 public:
 	typedef unsigned int PosType;
@@ -50,15 +61,75 @@ public:
 
 	std::pair<PosType, PosType> get(unsigned int i) const;
 	size_t size() const;
+
+	/** \brief number of intervals that overlap [st, ed) i.e. start < ed and end > st */
+	size_t count_overlap(PosType st, PosType ed) const;
+
+	/** \brief calls f(i) for each interval i overlapping [st, ed), in increasing order of i */
+	template<typename Func>
+	void overlap(PosType st, PosType ed, Func f) const;
+
+	/** \brief returns the indexes of the intervals overlapping [st, ed) */
+	std::vector<unsigned int> overlap(PosType st, PosType ed) const;
+
+	/** \brief counts the overlaps of many queries, out[i] = count_overlap(qs[i].first, qs[i].second).
+	When both the starts and the ends of the queries are non-decreasing and the queries are
+	dense enough, the interval positions are scanned once instead of searched for each query. */
+	void count_overlap_batch(const std::vector<std::pair<PosType, PosType> >& qs,
+		std::vector<unsigned int>& out) const;
 private:
+	/// number of (start and end) positions that are less than x
+	size_t count_less(PosType x) const;
+	/// number of intervals with start < x
+	size_t starts_before(PosType x) const { return marks.rank(count_less(x)); }
+	/// number of intervals with end <= x
+	size_t ends_until(PosType x) const;
+	PosType end_of(size_t i) const { return get((unsigned int) i).second; }
+	void build_overlap_index();
+
 	mscds::Rank6p marks;
 	mscds::SDArraySml pos;
 	mscds::SDArraySml span;
 
+	/// prefix maxima of the end positions
+	mscds::SDArraySml maxend;
+	/// maximum of the end positions in a range of intervals
+	mscds::RMQ_sct endmax;
+
 	//mscds::RMQ_pm1_minmax minmax_depth;
 	//size_t len;
 	friend class IntvLstBuilder;
 };
 
+template<typename Func>
+inline void IntvLst::overlap(PosType st, PosType ed, Func f) const {
+	if (st >= ed || size() == 0) return;
+	if ((uint64_t) st + 1 > maxend.total()) return;
+	size_t lo = maxend.rank((uint64_t) st + 1) - 1;
+	size_t hi = starts_before(ed);
+	if (lo >= hi) return;
+	// in-order traversal of the (implicit) cartesian tree of the ends in [lo, hi),
+	// the subtrees whose maximum end is at most `st' are skipped
+	struct Frame { size_t lo, hi; bool report; };
+	std::vector<Frame> stack;
+	Frame fr = {lo, hi, false};
+	stack.push_back(fr);
+	while (!stack.empty()) {
+		Frame c = stack.back();
+		stack.pop_back();
+		if (c.report) {
+			f((unsigned int) c.lo);
+			continue;
+		}
+		if (c.lo >= c.hi) continue;
+		size_t m = endmax.m_idx(c.lo, c.hi);
+		if (end_of(m) <= st) continue;
+		Frame right = {m + 1, c.hi, false}, mid = {m, m + 1, true}, left = {c.lo, m, false};
+		stack.push_back(right);
+		stack.push_back(mid);
+		stack.push_back(left);
+	}
+}
+
 }//namespace
 
@@ -0,0 +1,82 @@
+#include "intv.h"
+
+#include "utils/benchmark.h"
+#include "utils/utils.h"
+
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
+
+namespace tests {
+
+using namespace std;
+using namespace app_ds;
+using namespace utils;
+
+// peak-like intervals: mostly short, a few long ones
+static vector<pair<unsigned, unsigned> > gen_peaks(unsigned int n, unsigned int range) {
+	vector<pair<unsigned, unsigned> > ret;
+	for (unsigned int i = 0; i < n; ++i) {
+		unsigned int st = rand() % range;
+		unsigned int len = (rand() % 100 == 0) ? 1 + rand() % 20000 : 50 + rand() % 500;
+		ret.emplace_back(st, st + len);
+	}
+	sort(ret.begin(), ret.end());
+	return ret;
+}
+
+// the scan that was needed before: check every interval that starts before `ed`
+static size_t naive_count(const vector<pair<unsigned, unsigned> >& intv, unsigned int st, unsigned int ed) {
+	size_t c = 0;
+	for (auto it = intv.begin(); it != intv.end() && it->first < ed; ++it)
+		if (it->second > st) ++c;
+	return c;
+}
+
+BENCHMARK_SET(interval_overlap_benchmark) {
+	const unsigned int n = 200000, range = 200000000, nq = 2000;
+	auto intv = gen_peaks(n, range);
+	IntvLstBuilder bd;
+	for (auto& p : intv) bd.add(p.first, p.second);
+	IntvLst lst;
+	bd.build(&lst);
+
+	vector<pair<unsigned, unsigned> > qs;
+	for (unsigned int i = 0; i < nq; ++i) {
+		unsigned int st = rand() % range;
+		qs.emplace_back(st, st + 1000);
+	}
+	size_t c1 = 0, c2 = 0, c3 = 0, c4 = 0;
+	Timer tm;
+	for (auto& q : qs) c1 += naive_count(intv, q.first, q.second);
+	double t1 = tm.current();
+	tm.reset();
+	for (auto& q : qs) c2 += lst.count_overlap(q.first, q.second);
+	double t2 = tm.current();
+	tm.reset();
+	for (auto& q : qs) lst.overlap(q.first, q.second, [&c3](unsigned int) { ++c3; });
+	double t3 = tm.current();
+
+	// sorted stream of 2M stabbing queries
+	vector<pair<unsigned, unsigned> > sq;
+	for (unsigned int i = 0; i < 2000000; ++i) {
+		unsigned int p = rand() % range;
+		sq.emplace_back(p, p + 1);
+	}
+	sort(sq.begin(), sq.end());
+	vector<unsigned int> cnt;
+	tm.reset();
+	lst.count_overlap_batch(sq, cnt);
+	double t4 = tm.current();
+	for (auto x : cnt) c4 += x;
+
+	cout << n << " intervals, " << nq << " random queries (results: " << c1 << " " << c2 << " " << c3 << ")" << endl;
+	cout << "naive scan:     " << t1 * 1e6 / nq << " us/query" << endl;
+	cout << "count_overlap:  " << t2 * 1e6 / nq << " us/query" << endl;
+	cout << "overlap (enum): " << t3 * 1e6 / nq << " us/query" << endl;
+	cout << "sorted batch of " << sq.size() << " stabbing queries: " << t4 * 1e9 / sq.size()
+		<< " ns/query (total " << c4 << ")" << endl;
+}
+
+}//namespace
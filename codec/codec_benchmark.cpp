@@ -0,0 +1,135 @@
+#include "utils/benchmark.h"
+#include "utils/utils.h"
+
+#include "vbyte.h"
+#include "rans_block.h"
+#include "stream/codec_adapter.h"
+
+#include <vector>
+#include <iterator>
+#include <string>
+#include <cmath>
+
+namespace tests {
+
+using namespace std;
+using namespace coder;
+using namespace mscds;
+
+// mostly small values with a tail of larger ones (like block sizes or gaps)
+struct VByteBMFix: public SharedFixtureItf {
+	void SetUp() {
+		size_t n = 10000000;
+		vals.resize(n);
+		for (size_t i = 0; i < n; ++i) {
+			unsigned int r = utils::rand32() % 100;
+			vals[i] = (r < 60) ? utils::rand32() % 128 : ((r < 90) ? utils::rand32() % (1u << 14) : utils::rand32() % (1u << 28));
+		}
+		vbuf.clear();
+		for (size_t i = 0; i < n; ++i)
+			VByte::encode(vals[i], back_inserter(vbuf));
+		sbuf.resize(StreamVByte::max_compressed_size(n));
+		sbuf.resize(StreamVByte::encode(vals.data(), n, sbuf.data()));
+		OBitStream os;
+		for (size_t i = 0; i < 1000000; ++i)
+			VByteStream::append(os, vals[i]);
+		os.close();
+		os.build(&bits);
+		out64.resize(n);
+		out32.resize(n);
+	}
+	void TearDown() {
+		vals.clear();
+		vbuf.clear();
+		sbuf.clear();
+		bits.clear();
+		out64.clear();
+		out32.clear();
+	}
+	vector<uint32_t> vals;
+	vector<uint8_t> vbuf, sbuf;
+	BitArray bits;
+	vector<uint64_t> out64;
+	vector<uint32_t> out32;
+};
+
+void vbyte_scalar(VByteBMFix * fix) {
+	const uint8_t* p = fix->vbuf.data();
+	for (size_t i = 0; i < fix->out64.size(); ++i)
+		fix->out64[i] = VByte::decode(p);
+}
+
+void vbyte_masked(VByteBMFix * fix) {
+	VByte::decode_n(fix->vbuf.data(), fix->vbuf.size(), fix->out64.data(), fix->out64.size());
+}
+
+void stream_vbyte_scalar(VByteBMFix * fix) {
+	StreamVByte::decode_scalar(fix->sbuf.data(), fix->sbuf.size(), fix->out32.data(), fix->out32.size());
+}
+
+void stream_vbyte(VByteBMFix * fix) {
+	StreamVByte::decode(fix->sbuf.data(), fix->sbuf.size(), fix->out32.data(), fix->out32.size());
+}
+
+void vbyte_bitarray_extract(VByteBMFix * fix) {
+	size_t pos = 0;
+	for (size_t i = 0; i < 1000000; ++i)
+		fix->out64[i] = VByteStream::extract(fix->bits, pos);
+}
+
+void vbyte_bitarray_extract_n(VByteBMFix * fix) {
+	size_t pos = 0;
+	VByteStream::extract_n(fix->bits, pos, 1000000, fix->out64.data());
+}
+
+BENCHMARK_SET(vbyte_benchmark) {
+	Benchmarker<VByteBMFix> bm;
+	bm.n_samples = 3;
+	bm.add("vbyte_scalar", vbyte_scalar, 5);
+	bm.add("vbyte_masked", vbyte_masked, 5);
+	bm.add("stream_vbyte_scalar", stream_vbyte_scalar, 5);
+	bm.add("stream_vbyte", stream_vbyte, 5);
+	bm.add("vbyte_bitarray_extract", vbyte_bitarray_extract, 5);
+	bm.add("vbyte_bitarray_extract_n", vbyte_bitarray_extract_n, 5);
+	bm.run_all();
+	bm.report(0);
+}
+
+// bytes with a geometric-like distribution (about 6 bits of entropy)
+struct RansBMFix: public SharedFixtureItf {
+	void SetUp() {
+		size_t n = 1 << 24;
+		data.resize(n);
+		for (size_t i = 0; i < n; ++i) {
+			double u = (utils::rand32() + 1.0) / 4294967296.0;
+			data[i] = (char) (unsigned int) std::min(255.0, -std::log(u) * 20);
+		}
+		unsigned int ways[] = {4, 8, 32};
+		for (unsigned int k = 0; k < 3; ++k)
+			RansBlockCodec(ways[k]).compress((const uint8_t*) data.data(), n, &comp[k]);
+	}
+	void TearDown() {
+		data.clear();
+		out.clear();
+		for (unsigned int k = 0; k < 3; ++k) comp[k].clear();
+	}
+	std::string data, out, comp[3];
+};
+
+template<unsigned int K>
+void rans_block_decode(RansBMFix * fix) {
+	RansBlockCodec codec;
+	codec.decompress((const uint8_t*) fix->comp[K].data(), fix->comp[K].size(), &fix->out);
+}
+
+BENCHMARK_SET(rans_block_benchmark) {
+	Benchmarker<RansBMFix> bm;
+	bm.n_samples = 3;
+	bm.add("rans_4way_decode", rans_block_decode<0>, 5);
+	bm.add("rans_8way_decode", rans_block_decode<1>, 5);
+	bm.add("rans_32way_decode", rans_block_decode<2>, 5);
+	bm.run_all();
+	bm.report(0);
+}
+
+}//namespace
@@ -190,16 +190,15 @@ LenTp fib_sel(NumTp n, LenTp p) {
 }*/
 
 std::pair<NumTp, LenTp> FibCoder::decode2(NumTp n) {
+	// the code ends at the first "11", the value is the sum of fibn[i] for
+	// the 1 bits before the terminating one
+	NumTp t = n & (n >> 1);
+	LenTp i = (t != 0) ? mscds::lsb_intr(t) : MAXBITLEN;
+	NumTp x = (i + 1 < MAXBITLEN) ? n & ((2ULL << i) - 1) : n;
 	CodeTp ret = 0;
-	CodeTp a = 0, b = 1, c = 1;
-	LenTp i;
-	for (i = 0; i < MAXBITLEN; ++i) {
-		if (n & 1) {
-			ret += c; // fibn[i]
-			if (n & 2) break;
-		}
-		a = b; b = c; c = a + b;
-		n = (n >> 1);
+	while (x != 0) {
+		ret += fibn[mscds::lsb_intr(x)];
+		x &= x - 1;
 	}
 	return CodePr(ret, i+2);
 }
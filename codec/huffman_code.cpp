@@ -183,6 +183,24 @@ void HuffmanByteDec::build(const HuffmanCode& hcode) {
 	_size = hcode.size();
 	int tb = 0;
 	create(pcode, 0, pcode.size(), tb);
+	build_multi();
+}
+
+void HuffmanByteDec::build_multi() {
+	multi.resize(1u << MULTI_BITS);
+	for (unsigned int x = 0; x < multi.size(); ++x) {
+		MultiEntry& e = multi[x];
+		unsigned int used = 0;
+		e.n = 0;
+		while (e.n < MULTI_MAX) {
+			CodePr c = decode2(x >> used);
+			if (c.second == 0 || used + c.second > MULTI_BITS) break;
+			e.len[e.n] = (uint8_t) c.second;
+			e.sym[e.n] = (uint16_t) c.first;
+			used += c.second;
+			++e.n;
+		}
+	}
 }
 
 void HuffmanByteDec::create(std::vector<CodeInfo>& xc, unsigned int st, unsigned int ed, int & table_id) {
@@ -252,10 +270,14 @@ coder::CodePr HuffmanByteDec::decode2(NumTp n) const {
 
 HuffmanByteDec::HuffmanByteDec(): _size(0) {}
 
+const unsigned int HuffmanByteDec::MULTI_BITS;
+const unsigned int HuffmanByteDec::MULTI_MAX;
+
 void HuffmanByteDec::clear() {
 	_size = 0;
 	code.clear();
 	tbl_info.clear();
+	multi.clear();
 }
 
 bool HuffmanByteDec::CodeInfo::operator<(const CodeInfo& b) const {
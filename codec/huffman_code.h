@@ -76,8 +76,21 @@ public:
 	CodePr decode2(NumTp n) const;
 	unsigned int size() const;
 	void clear();
+
+	static const unsigned int MULTI_BITS = 10, MULTI_MAX = 3;
+	/// the codes that fit completely in MULTI_BITS bits (at most MULTI_MAX codes)
+	struct MultiEntry {
+		uint8_t n;
+		uint8_t len[MULTI_MAX];
+		uint16_t sym[MULTI_MAX];
+	};
+	/** \brief decodes the codes that fit in the low MULTI_BITS bits of `n' with one
+	table lookup; n = 0 when the first code is longer, use decode2() then */
+	const MultiEntry& decode_multi(NumTp n) const { return multi[n & ((1u << MULTI_BITS) - 1)]; }
 private:
 	unsigned int _size;
+	std::vector<MultiEntry> multi;
+	void build_multi();
 
 	//maximum 2^12 = 4096 symbols, max 256 per decode table
 	//code: highest bit:
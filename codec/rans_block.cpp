@@ -0,0 +1,242 @@
+#include "rans_block.h"
+#include "sym_table.h"
+#include "vbyte.h"
+
+#include <vector>
+#include <cstring>
+#include <stdexcept>
+#include <iterator>
+
+#if defined(__AVX2__) && defined(__GNUC__)
+#include <immintrin.h>
+#define RANS_BLOCK_AVX2
+#endif
+
+namespace coder {
+
+namespace {
+
+const uint32_t SCALE = 1u << RansBlockCodec::SCALE_BITS;
+const uint32_t SLOT_MASK = SCALE - 1;
+// states are kept in [L, 2^32) and renormalized by 16-bit words
+const uint32_t RANS_WORD_L = 1u << 16;
+
+const uint8_t STORED_BLOCK = 0;
+
+inline bool valid_ways(unsigned int w) { return w == 4 || w == 8 || w == 32; }
+
+inline uint16_t load16(const uint8_t* p) { uint16_t v; memcpy(&v, p, 2); return v; }
+
+/// slot -> (freq - 1) | (slot - start) << 12 | symbol << 24
+struct RansDecTable {
+	uint32_t entry[SCALE];
+	void build(const uint32_t* freqs, const uint32_t* cum_freqs) {
+		for (unsigned int s = 0; s < 256; ++s)
+			for (uint32_t k = 0; k < freqs[s]; ++k)
+				entry[cum_freqs[s] + k] = (freqs[s] - 1) | (k << 12) | (s << 24);
+	}
+};
+
+/// decodes one byte with the state `x' and reads a word if needed
+inline bool dec_step(const RansDecTable& tbl, uint32_t& x, const uint8_t*& wp, const uint8_t* end, uint8_t* out) {
+	uint32_t e = tbl.entry[x & SLOT_MASK];
+	*out = (uint8_t) (e >> 24);
+	x = ((e & SLOT_MASK) + 1) * (x >> RansBlockCodec::SCALE_BITS) + ((e >> 12) & SLOT_MASK);
+	if (x < RANS_WORD_L) {
+		if (end - wp < 2) return false;
+		x = (x << 16) | load16(wp);
+		wp += 2;
+	}
+	return true;
+}
+
+#ifdef RANS_BLOCK_AVX2
+/// for each renormalization mask of 8 states: the index of the word read by each state
+struct RansPermTable {
+	alignas(32) uint32_t idx[256][8];
+	RansPermTable() {
+		for (unsigned int m = 0; m < 256; ++m) {
+			unsigned int c = 0;
+			for (unsigned int j = 0; j < 8; ++j) {
+				idx[m][j] = c;
+				if ((m >> j) & 1) ++c;
+			}
+		}
+	}
+};
+
+const RansPermTable& perm_table() {
+	static const RansPermTable tbl;
+	return tbl;
+}
+
+/// decodes one step of 8 states, needs 16 readable bytes at `wp'
+inline __m256i dec_step8(const RansDecTable& tbl, const RansPermTable& perm, __m256i x, const uint8_t*& wp, uint8_t* out) {
+	const __m256i mask = _mm256_set1_epi32(SLOT_MASK);
+	__m256i e = _mm256_i32gather_epi32((const int*) tbl.entry, _mm256_and_si256(x, mask), 4);
+	__m256i f = _mm256_add_epi32(_mm256_and_si256(e, mask), _mm256_set1_epi32(1));
+	__m256i bias = _mm256_and_si256(_mm256_srli_epi32(e, 12), mask);
+	x = _mm256_add_epi32(_mm256_mullo_epi32(f, _mm256_srli_epi32(x, RansBlockCodec::SCALE_BITS)), bias);
+	// symbols: the top byte of each entry
+	__m256i s = _mm256_srli_epi32(e, 24);
+	s = _mm256_packus_epi32(s, s);
+	s = _mm256_packus_epi16(s, s);
+	uint32_t lo = (uint32_t) _mm_cvtsi128_si32(_mm256_castsi256_si128(s));
+	uint32_t hi = (uint32_t) _mm_cvtsi128_si32(_mm256_extracti128_si256(s, 1));
+	memcpy(out, &lo, 4);
+	memcpy(out + 4, &hi, 4);
+	// renormalize: the states below L take the next words in state order
+	__m256i need = _mm256_cmpeq_epi32(_mm256_srli_epi32(x, 16), _mm256_setzero_si256());
+	unsigned int m = (unsigned int) _mm256_movemask_ps(_mm256_castsi256_ps(need));
+	__m256i w = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*) wp));
+	w = _mm256_permutevar8x32_epi32(w, _mm256_load_si256((const __m256i*) perm.idx[m]));
+	x = _mm256_blendv_epi8(x, _mm256_or_si256(_mm256_slli_epi32(x, 16), w), need);
+	wp += 2 * __builtin_popcount(m);
+	return x;
+}
+
+/// decodes the full steps with G groups of 8 states, returns the number of decoded bytes
+template<unsigned int G>
+size_t dec_avx2(const RansDecTable& tbl, uint32_t* st, const uint8_t*& wp, const uint8_t* end, uint8_t* out, size_t n) {
+	const RansPermTable& perm = perm_table();
+	__m256i x[G];
+	for (unsigned int g = 0; g < G; ++g)
+		x[g] = _mm256_loadu_si256((const __m256i*) (st + 8 * g));
+	size_t i = 0;
+	// a step reads at most 8 * G words, the loads never go further than that
+	while (i + 8 * G <= n && (size_t)(end - wp) >= 16 * G) {
+		for (unsigned int g = 0; g < G; ++g)
+			x[g] = dec_step8(tbl, perm, x[g], wp, out + i + 8 * g);
+		i += 8 * G;
+	}
+	for (unsigned int g = 0; g < G; ++g)
+		_mm256_storeu_si256((__m256i*) (st + 8 * g), x[g]);
+	return i;
+}
+#endif
+
+}
+
+RansBlockCodec::RansBlockCodec(unsigned int ways): nways(ways) {
+	if (!valid_ways(ways)) throw std::runtime_error("the number of rANS states must be 4, 8 or 32");
+}
+
+std::string RansBlockCodec::compress(const uint8_t* in, size_t n) const {
+	std::string out;
+	compress(in, n, &out);
+	return out;
+}
+
+size_t RansBlockCodec::compress(const uint8_t* in, size_t n, std::string* out) const {
+	// header: method, length, frequency table
+	std::string hdr;
+	hdr.push_back((char) nways);
+	VByte::encode(n, std::back_inserter(hdr));
+	size_t stored_size = hdr.size() + n;
+	out->clear();
+	if (n > 0) {
+		NormSymbolStats stats;
+		for (unsigned int s = 0; s < 256; ++s) stats.freqs[s] = 0;
+		for (size_t i = 0; i < n; ++i) ++stats.freqs[in[i]];
+		stats.normalize_freqs(SCALE);
+		uint8_t present[32] = {0};
+		for (unsigned int s = 0; s < 256; ++s)
+			if (stats.freqs[s] > 0) present[s >> 3] |= 1u << (s & 7);
+		hdr.append((const char*) present, 32);
+		for (unsigned int s = 0; s < 256; ++s)
+			if (stats.freqs[s] > 0) {
+				uint16_t v = (uint16_t) (stats.freqs[s] - 1);
+				hdr.append((const char*) &v, 2);
+			}
+
+		// the words are written backwards: at most one word per byte and two per state
+		std::vector<uint16_t> buf(n + 2 * nways);
+		uint16_t* wp = buf.data() + buf.size();
+		std::vector<uint32_t> st(nways, RANS_WORD_L);
+		for (size_t i = n; i > 0; --i) {
+			uint32_t& x = st[(i - 1) % nways];
+			uint8_t s = in[i - 1];
+			uint32_t f = stats.freqs[s];
+			if ((uint64_t) x >= ((uint64_t) f << (32 - SCALE_BITS))) {
+				*--wp = (uint16_t) (x & 0xFFFF);
+				x >>= 16;
+			}
+			x = ((x / f) << SCALE_BITS) + (x % f) + stats.cum_freqs[s];
+		}
+		for (unsigned int j = nways; j > 0; --j) {
+			*--wp = (uint16_t) (st[j - 1] >> 16);
+			*--wp = (uint16_t) (st[j - 1] & 0xFFFF);
+		}
+		size_t nbytes = (buf.data() + buf.size() - wp) * 2;
+		if (hdr.size() + nbytes < stored_size) {
+			out->swap(hdr);
+			out->append((const char*) wp, nbytes);
+			return out->size();
+		}
+	}
+	// not compressible
+	out->push_back((char) STORED_BLOCK);
+	VByte::encode(n, std::back_inserter(*out));
+	out->append((const char*) in, n);
+	return out->size();
+}
+
+bool RansBlockCodec::decompress(const uint8_t* in, size_t len, std::string* out) const {
+	const uint8_t* p = in, * end = in + len;
+	if (len == 0) return false;
+	unsigned int ways = *p++;
+	uint64_t n = 0;
+	for (unsigned int shift = 0; ; shift += 7) {
+		if (p >= end || shift >= 64) return false;
+		uint8_t c = *p++;
+		n |= (uint64_t) (c & 127) << shift;
+		if (c < 128) break;
+	}
+	if (ways == STORED_BLOCK) {
+		if ((uint64_t)(end - p) != n) return false;
+		out->assign((const char*) p, n);
+		return true;
+	}
+	if (!valid_ways(ways) || n == 0) return false;
+	if (end - p < 32) return false;
+	uint32_t freqs[256], cum_freqs[257];
+	const uint8_t* present = p;
+	p += 32;
+	cum_freqs[0] = 0;
+	for (unsigned int s = 0; s < 256; ++s) {
+		freqs[s] = 0;
+		if ((present[s >> 3] >> (s & 7)) & 1) {
+			if (end - p < 2) return false;
+			freqs[s] = load16(p) + 1u;
+			p += 2;
+		}
+		cum_freqs[s + 1] = cum_freqs[s] + freqs[s];
+	}
+	if (cum_freqs[256] != SCALE) return false;
+	RansDecTable tbl;
+	tbl.build(freqs, cum_freqs);
+
+	if ((size_t)(end - p) < 4 * ways) return false;
+	uint32_t st[32];
+	for (unsigned int j = 0; j < ways; ++j) {
+		st[j] = load16(p) | ((uint32_t) load16(p + 2) << 16);
+		p += 4;
+	}
+	out->resize(n);
+	uint8_t* o = (uint8_t*) &((*out)[0]);
+	size_t i = 0;
+#ifdef RANS_BLOCK_AVX2
+	if (ways == 8) i = dec_avx2<1>(tbl, st, p, end, o, n);
+	else if (ways == 32) i = dec_avx2<4>(tbl, st, p, end, o, n);
+#endif
+	if (ways == 4) {
+		for (; i + 4 <= n; i += 4)
+			for (unsigned int j = 0; j < 4; ++j)
+				if (!dec_step(tbl, st[j], p, end, o + i + j)) return false;
+	}
+	for (; i < n; ++i)
+		if (!dec_step(tbl, st[i % ways], p, end, o + i)) return false;
+	return p == end;
+}
+
+}//namespace
@@ -0,0 +1,53 @@
+#pragma once
+
+/**
+\file
+
+Block compressor with interleaved rANS states
+
+The bytes of a block are coded with a static order-0 model (12-bit
+probabilities, the frequency table is stored in the block header) using 4, 8
+or 32 rANS states; byte i of the block belongs to state i % ways. The states
+are renormalized 16 bits at a time so that each state reads at most one word
+after a symbol. The decoder finds the symbol of a slot with one lookup in a
+table of 4096 packed entries (symbol, frequency, offset in the symbol range).
+With AVX2 the 8 and 32-way decoders handle 8 states per instruction: the
+table entries are gathered and the words needed for renormalization are
+distributed to the states with a permutation.
+
+A block that does not get smaller is stored as it is.
+
+Based on:
+
+  J. Duda. Asymmetric numeral systems: entropy coding combining speed of
+  Huffman coding with compression rate of arithmetic coding. 2013.
+
+  F. Giesen. Interleaved entropy coders. 2014.
+*/
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+
+namespace coder {
+
+/// order-0 byte compressor using interleaved rANS states
+class RansBlockCodec {
+public:
+	static const unsigned int SCALE_BITS = 12;
+
+	/// `ways' is the number of interleaved states (4, 8 or 32)
+	explicit RansBlockCodec(unsigned int ways = 8);
+	unsigned int ways() const { return nways; }
+
+	/** \brief compresses [in, in + n) to `out' and returns the compressed size */
+	size_t compress(const uint8_t* in, size_t n, std::string* out) const;
+	std::string compress(const uint8_t* in, size_t n) const;
+	/** \brief decompresses a block made by compress() (any number of ways),
+	returns false if the block is corrupted */
+	bool decompress(const uint8_t* in, size_t len, std::string* out) const;
+private:
+	unsigned int nways;
+};
+
+}//namespace
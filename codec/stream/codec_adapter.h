@@ -16,6 +16,7 @@ Coder + stream
 
 
 #include <vector>
+#include <algorithm>
 
 namespace mscds {
 
@@ -37,6 +38,20 @@ struct VByteStream {
 		};
 		return coder::VByte::decode_f(getter);
 	}
+	/// extracts `n' values, the bytes are decoded in bulk when the array is mapped and `pos' is byte aligned
+	template<typename T>
+	static void extract_n(const BitArray& ba, size_t& pos, size_t n, T* out) {
+		const uint64_t* w = ba.word_addr();
+		if (w != nullptr && (pos & 7) == 0 && pos <= ba.length()) {
+			std::vector<uint64_t> tmp(n);
+			size_t used = coder::VByte::decode_n(((const uint8_t*) w) + pos / 8, (ba.length() - pos) / 8, tmp.data(), n);
+			std::copy(tmp.begin(), tmp.end(), out);
+			pos += used * 8;
+		} else {
+			for (size_t i = 0; i < n; ++i)
+				out[i] = extract(ba, pos);
+		}
+	}
 };
 
 struct DeltaCodeStream {
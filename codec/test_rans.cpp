@@ -7,6 +7,9 @@
 #include "utils/utest.h"
 
 #include "sym_table_alias.h"
+#include "rans_block.h"
+
+#include <string>
 
 using namespace std;
 using namespace coder;
@@ -98,6 +101,59 @@ TEST(rans, rnd1) {
 	cout << endl;
 }
 
+static void check_block(const RansBlockCodec& codec, const std::string& inp) {
+	std::string comp, out;
+	size_t len = codec.compress((const uint8_t*) inp.data(), inp.size(), &comp);
+	ASSERT_EQ(comp.size(), len);
+	ASSERT_TRUE(codec.decompress((const uint8_t*) comp.data(), comp.size(), &out));
+	ASSERT_EQ(inp, out);
+	// a block can be decoded with any number of ways
+	RansBlockCodec other(codec.ways() == 4 ? 32 : 4);
+	out.clear();
+	ASSERT_TRUE(other.decompress((const uint8_t*) comp.data(), comp.size(), &out));
+	ASSERT_EQ(inp, out);
+}
+
+TEST(rans_block, roundtrip) {
+	unsigned int ways[] = {4, 8, 32};
+	size_t sizes[] = {0, 1, 7, 31, 33, 1000, 65537};
+	for (unsigned int w = 0; w < 3; ++w) {
+		RansBlockCodec codec(ways[w]);
+		for (unsigned int k = 0; k < 7; ++k) {
+			std::deque<uint8_t> d = gen_rnd1(sizes[k]);
+			check_block(codec, std::string(d.begin(), d.end()));
+			// skewed distribution with rare symbols
+			std::string s(sizes[k], 'a');
+			for (size_t i = 0; i < s.size(); ++i)
+				if (rand() % 100 == 0) s[i] = (char) (rand() % 256);
+			check_block(codec, s);
+			// one symbol only
+			check_block(codec, std::string(sizes[k], 'z'));
+		}
+	}
+}
+
+TEST(rans_block, stored_and_corrupted) {
+	RansBlockCodec codec(8);
+	// random bytes do not compress and are stored
+	std::string s;
+	for (int i = 0; i < 5000; ++i) s.push_back((char) (rand() % 256));
+	std::string comp = codec.compress((const uint8_t*) s.data(), s.size()), out;
+	ASSERT_EQ(0, comp[0]);
+	check_block(codec, s);
+
+	s.clear();
+	for (int i = 0; i < 5000; ++i) s.push_back((char) ('a' + rand() % 16));
+	comp = codec.compress((const uint8_t*) s.data(), s.size());
+	ASSERT_TRUE(comp.size() < s.size());
+	ASSERT_FALSE(codec.decompress((const uint8_t*) comp.data(), comp.size() - 1, &out));
+	ASSERT_FALSE(codec.decompress((const uint8_t*) comp.data(), 20, &out));
+	ASSERT_FALSE(codec.decompress((const uint8_t*) comp.data(), 0, &out));
+	std::string bad = comp;
+	bad[0] = 5;
+	ASSERT_FALSE(codec.decompress((const uint8_t*) bad.data(), bad.size(), &out));
+}
+
 /*
 int main(int argc, char* argv[]) {
 	::testing::GTEST_FLAG(catch_exceptions) = "0";
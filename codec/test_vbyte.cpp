@@ -0,0 +1,92 @@
+#include "vbyte.h"
+#include "stream/codec_adapter.h"
+
+#include "utils/utest.h"
+
+#include <vector>
+#include <iterator>
+
+namespace tests {
+
+using namespace std;
+using namespace coder;
+using namespace mscds;
+
+static uint64_t rand_vbyte_val(unsigned int maxbits) {
+	unsigned int bits = rand() % (maxbits + 1);
+	uint64_t v = ((uint64_t)rand() << 42) ^ ((uint64_t)rand() << 21) ^ rand();
+	return bits == 0 ? 0 : (bits >= 64 ? v : (v & ((1ull << bits) - 1)));
+}
+
+TEST(vbyte, decode_n) {
+	unsigned int maxbits[] = {7, 14, 21, 40, 64};
+	for (unsigned int t = 0; t < 5; ++t) {
+		vector<uint64_t> vals;
+		vector<uint8_t> buf;
+		vector<size_t> offs;
+		for (unsigned int i = 0; i < 5000; ++i) {
+			// runs of small values to go through the one and two byte groups
+			uint64_t v = (i / 100) % 3 == 0 ? rand() % 128 : ((i / 100) % 3 == 1 ? 128 + rand() % 16000 : rand_vbyte_val(maxbits[t]));
+			vals.push_back(v);
+			offs.push_back(buf.size());
+			VByte::encode(v, back_inserter(buf));
+		}
+		vector<uint64_t> out(vals.size());
+		ASSERT_EQ(buf.size(), VByte::decode_n(buf.data(), buf.size(), out.data(), out.size()));
+		ASSERT_EQ(vals, out);
+		// stop in the middle of the buffer
+		size_t half = vals.size() / 2 + 3;
+		ASSERT_EQ(offs[half], VByte::decode_n(buf.data(), buf.size(), out.data(), half));
+		ASSERT_EQ(offs[half] - offs[7], VByte::decode_n(buf.data() + offs[7], buf.size() - offs[7], out.data(), half - 7));
+		ASSERT_EQ(vals[half - 1], out[half - 8]);
+	}
+	uint8_t big[10];
+	uint8_t* q = big;
+	VByte::encode(~0ull, q);
+	uint64_t r;
+	ASSERT_EQ(10u, VByte::decode_n(big, 10, &r, 1));
+	ASSERT_EQ(~0ull, r);
+}
+
+TEST(vbyte, stream_vbyte) {
+	unsigned int sizes[] = {0, 1, 3, 4, 5, 17, 1000, 10003};
+	for (unsigned int t = 0; t < 8; ++t) {
+		size_t n = sizes[t];
+		vector<uint32_t> vals(n);
+		for (size_t i = 0; i < n; ++i)
+			vals[i] = (uint32_t) rand_vbyte_val(32);
+		vector<uint8_t> buf(StreamVByte::max_compressed_size(n));
+		size_t len = StreamVByte::encode(vals.data(), n, buf.data());
+		ASSERT_TRUE(len <= buf.size());
+		vector<uint32_t> out(n), out2(n);
+		ASSERT_EQ(len, StreamVByte::decode(buf.data(), len, out.data(), n));
+		ASSERT_EQ(len, StreamVByte::decode_scalar(buf.data(), len, out2.data(), n));
+		ASSERT_EQ(vals, out);
+		ASSERT_EQ(vals, out2);
+	}
+}
+
+TEST(vbyte, stream_extract_n) {
+	// the second stream starts at an odd bit position (no bulk decoding)
+	for (unsigned int pre = 0; pre < 4; pre += 3) {
+		vector<uint64_t> vals;
+		OBitStream os;
+		os.puts(0, pre);
+		for (unsigned int i = 0; i < 1000; ++i) {
+			vals.push_back(rand_vbyte_val(40));
+			VByteStream::append(os, vals.back());
+		}
+		os.close();
+		BitArray b;
+		os.build(&b);
+		size_t pos = pre, pos2 = pre;
+		vector<uint64_t> out(vals.size());
+		VByteStream::extract_n(b, pos, out.size(), out.data());
+		ASSERT_EQ(vals, out);
+		for (size_t i = 0; i < vals.size(); ++i)
+			ASSERT_EQ(vals[i], VByteStream::extract(b, pos2));
+		ASSERT_EQ(pos2, pos);
+	}
+}
+
+}//namespace
@@ -1,4 +1,168 @@
 #include "vbyte.h"
 
+#include <cstring>
+
+#if defined(__SSE2__) && defined(__GNUC__)
+#include <emmintrin.h>
+#define VBYTE_SSE2
+#endif
+#if defined(__SSSE3__) && defined(__GNUC__)
+#include <tmmintrin.h>
+#define VBYTE_SSSE3
+#endif
+#ifdef __BMI2__
+#include <immintrin.h>
+#endif
+
 namespace coder {
-}//namespace
\ No newline at end of file
+
+namespace {
+
+inline uint64_t decode_one(const uint8_t*& p, const uint8_t* end) {
+	uint64_t val = 0;
+	for (unsigned shift = 0; shift < 64 && p < end; shift += 7) {
+		uint8_t temp = *p++;
+		val |= ((uint64_t)(temp & 127) << shift);
+		if (temp < 128) break;
+	}
+	return val;
+}
+
+#ifdef VBYTE_SSE2
+/// the 7-bit groups of the lowest `l' bytes of `w' (l <= 8)
+inline uint64_t pack7(uint64_t w, unsigned int l) {
+	if (l < 8) w &= (1ull << (8 * l)) - 1;
+#ifdef __BMI2__
+	return _pext_u64(w, 0x7F7F7F7F7F7F7F7Full);
+#else
+	w &= 0x7F7F7F7F7F7F7F7Full;
+	w = (w & 0x007F007F007F007Full) | ((w & 0x7F007F007F007F00ull) >> 1);
+	w = (w & 0x00003FFF00003FFFull) | ((w & 0x3FFF00003FFF0000ull) >> 2);
+	return (w & 0x000000000FFFFFFFull) | ((w & 0x0FFFFFFF00000000ull) >> 4);
+#endif
+}
+#endif
+
+#ifdef VBYTE_SSSE3
+/// shuffle masks and data lengths of the 256 control bytes
+struct StreamVByteTable {
+	alignas(16) uint8_t shuf[256][16];
+	uint8_t len[256];
+	StreamVByteTable() {
+		for (unsigned int c = 0; c < 256; ++c) {
+			unsigned int off = 0;
+			for (unsigned int j = 0; j < 4; ++j) {
+				unsigned int l = ((c >> (2 * j)) & 3) + 1;
+				for (unsigned int b = 0; b < 4; ++b)
+					shuf[c][4 * j + b] = (b < l) ? (uint8_t)(off + b) : 0xFF;
+				off += l;
+			}
+			len[c] = (uint8_t)off;
+		}
+	}
+};
+
+const StreamVByteTable& svb_table() {
+	static const StreamVByteTable tbl;
+	return tbl;
+}
+#endif
+
+inline const uint8_t* svb_decode_tail(const uint8_t* ctrl, const uint8_t* data, uint32_t* out, size_t k, size_t n) {
+	for (; k < n; ++k) {
+		unsigned int l = ((ctrl[k >> 2] >> (2 * (k & 3))) & 3) + 1;
+		uint32_t v = 0;
+		memcpy(&v, data, l);
+		out[k] = v;
+		data += l;
+	}
+	return data;
+}
+
+}
+
+size_t VByte::decode_n(const uint8_t* in, size_t len, uint64_t* out, size_t n) {
+	const uint8_t* p = in, * end = in + len;
+	size_t k = 0;
+#ifdef VBYTE_SSE2
+	while (k < n && end - p >= 16) {
+		__m128i x = _mm_loadu_si128((const __m128i*) p);
+		unsigned int cont = (unsigned int) _mm_movemask_epi8(x);
+		if (cont == 0 && n - k >= 16) {
+			// 16 one-byte values
+			for (unsigned int j = 0; j < 16; ++j)
+				out[k + j] = p[j];
+			p += 16;
+			k += 16;
+			continue;
+		}
+		if (cont == 0x5555 && n - k >= 8) {
+			// 8 two-byte values
+			__m128i v = _mm_or_si128(_mm_and_si128(x, _mm_set1_epi16(0x7F)),
+				_mm_srli_epi16(_mm_and_si128(x, _mm_set1_epi16(0x7F00)), 1));
+			uint16_t tmp[8];
+			_mm_storeu_si128((__m128i*) tmp, v);
+			for (unsigned int j = 0; j < 8; ++j)
+				out[k + j] = tmp[j];
+			p += 16;
+			k += 8;
+			continue;
+		}
+		// the values that end in the first 8 bytes
+		unsigned int term = ~cont & 0xFF;
+		if (term == 0) {
+			out[k++] = decode_one(p, end);
+			continue;
+		}
+		uint64_t w;
+		memcpy(&w, p, 8);
+		do {
+			unsigned int l = __builtin_ctz(term) + 1;
+			out[k++] = pack7(w, l);
+			p += l;
+			term >>= l;
+			w = (l < 8) ? (w >> (8 * l)) : 0;
+		} while (term != 0 && k < n);
+	}
+#endif
+	while (k < n && p < end)
+		out[k++] = decode_one(p, end);
+	return p - in;
+}
+
+size_t StreamVByte::encode(const uint32_t* in, size_t n, uint8_t* out) {
+	uint8_t* ctrl = out, * data = out + (n + 3) / 4;
+	for (size_t i = 0; i < n; ++i) {
+		uint32_t v = in[i];
+		unsigned int code = (v < (1u << 8)) ? 0 : (v < (1u << 16)) ? 1 : (v < (1u << 24)) ? 2 : 3;
+		if ((i & 3) == 0) ctrl[i >> 2] = 0;
+		ctrl[i >> 2] |= (uint8_t)(code << (2 * (i & 3)));
+		memcpy(data, &v, code + 1);
+		data += code + 1;
+	}
+	return data - out;
+}
+
+size_t StreamVByte::decode(const uint8_t* in, size_t len, uint32_t* out, size_t n) {
+	const uint8_t* ctrl = in, * data = in + (n + 3) / 4;
+	size_t k = 0;
+#ifdef VBYTE_SSSE3
+	const StreamVByteTable& tbl = svb_table();
+	const uint8_t* end = in + len;
+	for (; k + 4 <= n && end - data >= 16; k += 4) {
+		uint8_t c = ctrl[k >> 2];
+		__m128i x = _mm_loadu_si128((const __m128i*) data);
+		__m128i sh = _mm_load_si128((const __m128i*) tbl.shuf[c]);
+		_mm_storeu_si128((__m128i*) (out + k), _mm_shuffle_epi8(x, sh));
+		data += tbl.len[c];
+	}
+#endif
+	return svb_decode_tail(ctrl, data, out, k, n) - in;
+}
+
+size_t StreamVByte::decode_scalar(const uint8_t* in, size_t len, uint32_t* out, size_t n) {
+	const uint8_t* ctrl = in, * data = in + (n + 3) / 4;
+	return svb_decode_tail(ctrl, data, out, 0, n) - in;
+}
+
+}//namespace
@@ -4,9 +4,27 @@
 \file
 
 Implement VByte coding
+
+VByte stores 7 bits of a value per byte (lowest group first), the high bit
+of a byte is set when more bytes follow. Besides the one-value-at-a-time
+functions, VByte::decode_n decodes a run of values from a byte buffer by
+looking at the continuation bits of 16 bytes at once (masked VByte).
+
+StreamVByte is a different layout for 32-bit values: the lengths of four
+values are packed in one control byte and all control bytes are stored before
+the data bytes, so a group of four values is decoded with one table lookup
+and one byte shuffle (SSSE3) without any branch on the data.
+
+Based on:
+
+  J. Plaisance, N. Kurz, and D. Lemire. Vectorized VByte Decoding. 2015.
+
+  D. Lemire, N. Kurz, and C. Rupp. Stream VByte: Faster Byte-Oriented
+  Integer Compression. Information Processing Letters, 2018.
 */
 
 #include <stdint.h>
+#include <stddef.h>
 
 namespace coder {
 /// VByte codec
@@ -25,7 +43,7 @@ struct VByte {
 		uint64_t val = 0;	
 		for (unsigned shift = 0; shift < 64; shift += 7) {
 			uint8_t temp = *input++;
-			val |= ((temp&127) << shift);
+			val |= ((uint64_t)(temp & 127) << shift);
 			if (temp < 128) break;
 		}
 		return val;
@@ -45,11 +63,28 @@ struct VByte {
 		uint64_t val = 0;
 		for (unsigned shift = 0; shift < 64; shift += 7) {
 			uint8_t temp = fx();
-			val |= ((temp & 127) << shift);
+			val |= ((uint64_t)(temp & 127) << shift);
 			if (temp < 128) break;
 		}
 		return val;
 	}
+	/** \brief decodes `n' values from the buffer [in, in + len) to `out',
+	returns the number of bytes used. The input must hold `n' complete values. */
+	static size_t decode_n(const uint8_t* in, size_t len, uint64_t* out, size_t n);
+};
+
+/// Stream VByte codec for 32-bit values
+struct StreamVByte {
+	/// size of the largest output of encode() for `n' values
+	static size_t max_compressed_size(size_t n) { return (n + 3) / 4 + n * 4; }
+	/** \brief writes the (n+3)/4 control bytes and then the data bytes of `n' values,
+	returns the number of bytes written */
+	static size_t encode(const uint32_t* in, size_t n, uint8_t* out);
+	/** \brief decodes `n' values from the buffer [in, in + len),
+	returns the number of bytes used */
+	static size_t decode(const uint8_t* in, size_t len, uint32_t* out, size_t n);
+	/// same as decode() without the SIMD path
+	static size_t decode_scalar(const uint8_t* in, size_t len, uint32_t* out, size_t n);
 };
 
 }//namespace
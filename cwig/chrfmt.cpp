@@ -278,10 +278,46 @@ inline std::vector<Tp> diff_func(unsigned int st, unsigned int ed, unsigned int
 	return out;
 }
 
+/**
+calls fx(i, sum, sqrsum, coverage) with the statistics of the i-th window.
+When the windows cover few intervals, a cursor walks the intervals once in
+increasing order, otherwise each window end is looked up independently.
+*/
+template<typename Func>
+void ChrNumData::window_stats(unsigned int st, unsigned int ed, unsigned int n, bool need_sqr, Func fx) const {
+	auto rng = vals.find_intervals(st, ed);
+	unsigned int nintv = (rng.first < rng.second) ? rng.second - rng.first : 0;
+	if (nintv <= (uint64_t) n * CURSOR_INTERVALS) {
+		ChrNumValType::PrefixCursor c;
+		vals.getCursor(st, &c);
+		double lsum = c.sum, lsqr = c.sqrsum;
+		unsigned int lcov = c.coverage;
+		endpoints(st, ed, n, [&](unsigned int i, unsigned pos) {
+			c.advance(pos);
+			fx(i, c.sum - lsum, c.sqrsum - lsqr, c.coverage - lcov);
+			lsum = c.sum; lsqr = c.sqrsum; lcov = c.coverage;
+		});
+	} else {
+		double lsum, lsqr = 0;
+		unsigned int lcov;
+		vals.prefix_stats(st, &lsum, need_sqr ? &lsqr : NULL, &lcov);
+		endpoints(st, ed, n, [&](unsigned int i, unsigned pos) {
+			double csum, csqr = 0;
+			unsigned int ccov;
+			vals.prefix_stats(pos, &csum, need_sqr ? &csqr : NULL, &ccov);
+			fx(i, csum - lsum, csqr - lsqr, ccov - lcov);
+			lsum = csum; lsqr = csqr; lcov = ccov;
+		});
+	}
+}
+
 std::vector<double> ChrNumData::sum_batch(unsigned int st, unsigned int ed, unsigned int n) const {
-	if (ed - st > n) return diff_func<double>(st, ed, n, [&](unsigned int pos)->double{
-		return this->sum(pos); });
-	else {
+	if (ed - st > n) {
+		std::vector<double> ret(n);
+		window_stats(st, ed, n, false, [&](unsigned int i, double sx, double, unsigned int) {
+			ret[i] = sx; });
+		return ret;
+	} else {
 		auto arr = base_value_map(st, ed);
 		return mapValue<double>(st, ed, n, [&](double i)->double{return arr[i]; });
 	}
@@ -298,9 +334,12 @@ std::vector<unsigned int> ChrNumData::count_intervals_batch(unsigned int st, uns
 }
 
 std::vector<unsigned int> ChrNumData::coverage_batch(unsigned int st, unsigned int ed, unsigned int n) const {
-	if (ed - st > n) return diff_func<unsigned int>(st, ed, n, [&](unsigned int pos)->unsigned int{
-		return this->coverage(pos); });
-	else {
+	if (ed - st > n) {
+		std::vector<unsigned int> ret(n);
+		window_stats(st, ed, n, false, [&](unsigned int i, double, double, unsigned int cov) {
+			ret[i] = cov; });
+		return ret;
+	} else {
 		auto arr = base_value_map(st, ed);
 		return mapValue<unsigned int>(st, ed, n, [&](double i)->unsigned int{
 			return boost::math::isnan(arr[i]) ? 0 : 1; });
@@ -310,12 +349,8 @@ std::vector<unsigned int> ChrNumData::coverage_batch(unsigned int st, unsigned i
 std::vector<double> ChrNumData::avg_batch(unsigned int st, unsigned int ed, unsigned int n) const {
 	if (ed - st > n) {
 		std::vector<double> ret(n);
-		pair<double, double> last = make_pair(this->sum(st), this->coverage(st));
-		endpoints(st, ed, n, [&](unsigned int i, unsigned pos) {
-			pair<double, double> cv = make_pair(this->sum(pos), this->coverage(pos));
-			ret[i] = (cv.first - last.first) / (cv.second - last.second);
-			last = cv;
-		});
+		window_stats(st, ed, n, false, [&](unsigned int i, double sx, double, unsigned int cov) {
+			ret[i] = sx / (double) cov; });
 		return ret;
 	} else {
 		auto arr = base_value_map(st, ed);
@@ -352,12 +387,68 @@ std::vector<double> ChrNumData::max_value_batch(unsigned int st, unsigned int ed
 }
 
 std::vector<double> ChrNumData::stdev_batch(unsigned int st, unsigned int ed, unsigned int n) const {
-	if (ed - st > n)
-		return range_summary<double>(st, ed, n, [&](unsigned int st, unsigned int ed)->double{
-			return this->stdev(st, ed); });
-	else {
+	if (ed - st > n) {
+		std::vector<double> ret(n);
+		window_stats(st, ed, n, true, [&](unsigned int i, double sx, double sqsx, unsigned int cov) {
+			ret[i] = sqrt((sqsx - sx * sx / cov) / cov); });
+		return ret;
+	} else {
 		return mapValue<double>(st, ed, n, [&](double i)->double{return 0; });
 	}
 }
 
+WindowSummary ChrNumData::summary_batch(unsigned int st, unsigned int ed, unsigned int n, unsigned int mask) const {
+	WindowSummary out;
+	if (n == 0 || st >= ed) throw runtime_error("wrong function inputs");
+	if (mask & SUM_STAT) out.sum.resize(n);
+	if (mask & AVG_STAT) out.avg.resize(n);
+	if (mask & COVERAGE_STAT) out.coverage.resize(n);
+	if (mask & MIN_STAT) out.min.resize(n);
+	if (mask & MAX_STAT) out.max.resize(n);
+	if (mask & STDEV_STAT) out.stdev.resize(n);
+	if (ed - st > n) {
+		const bool need_min = (mask & MIN_STAT) && (minmax_opt & MIN_OP);
+		const bool need_max = (mask & MAX_STAT) && (minmax_opt & MAX_OP);
+		if (mask & (SUM_STAT | AVG_STAT | COVERAGE_STAT | STDEV_STAT))
+			window_stats(st, ed, n, (mask & STDEV_STAT) != 0, [&](unsigned int i, double sx, double sqsx, unsigned int cov) {
+				if (mask & SUM_STAT) out.sum[i] = sx;
+				if (mask & AVG_STAT) out.avg[i] = sx / (double) cov;
+				if (mask & COVERAGE_STAT) out.coverage[i] = cov;
+				if (mask & STDEV_STAT) out.stdev[i] = sqrt((sqsx - sx * sx / cov) / cov);
+			});
+		if (need_min || need_max) {
+			unsigned int last = st;
+			endpoints(st, ed, n, [&](unsigned int i, unsigned pos) {
+				auto ls = vals.find_intervals(last, pos);
+				if (ls.first < ls.second) {
+					if (need_min) {
+						unsigned int p = min.m_idx(ls.first, ls.second) * MIN_MAX_SAMPLE_RATE;
+						out.min[i] = vals.range_min(p, p + MIN_MAX_SAMPLE_RATE);
+					}
+					if (need_max) {
+						unsigned int p = max.m_idx(ls.first, ls.second) * MIN_MAX_SAMPLE_RATE;
+						out.max[i] = vals.range_max(p, p + MIN_MAX_SAMPLE_RATE);
+					}
+				}
+				last = pos;
+			});
+		}
+	} else {
+		auto arr = base_value_map(st, ed);
+		unsigned int last = 0;
+		endpoints(0, n, ed - st, [&](unsigned int i, unsigned pos) {
+			double v = arr[i];
+			for (unsigned int j = last; j < pos; ++j) {
+				if (mask & SUM_STAT) out.sum[j] = v;
+				if (mask & AVG_STAT) out.avg[j] = v;
+				if (mask & COVERAGE_STAT) out.coverage[j] = boost::math::isnan(v) ? 0 : 1;
+				if (mask & MIN_STAT) out.min[j] = v;
+				if (mask & MAX_STAT) out.max[j] = v;
+			}
+			last = pos;
+		});
+	}
+	return out;
+}
+
 }//namespace
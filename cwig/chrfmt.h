@@ -26,6 +26,16 @@ class ChrNumData;
 
 enum minmaxop_t {NO_MINMAX= 0, MIN_OP=1, MAX_OP=2, ALL_OP=3};
 
+/// statistics selected in ChrNumData::summary_batch (can be combined with '|')
+enum summary_stat_t {SUM_STAT=1, AVG_STAT=2, COVERAGE_STAT=4, MIN_STAT=8, MAX_STAT=16, STDEV_STAT=32, ALL_STATS=63};
+
+/// per window statistics of ChrNumData::summary_batch, only the requested arrays are filled
+struct WindowSummary {
+	std::vector<double> sum, avg, min, max, stdev;
+	std::vector<unsigned int> coverage;
+	void clear() { sum.clear(); avg.clear(); min.clear(); max.clear(); stdev.clear(); coverage.clear(); }
+};
+
 /// building cwig data in one chromosome
 class ChrNumDataBuilder {
 public:
@@ -103,6 +113,12 @@ public:
 	double stdev(unsigned int st, unsigned int ed) const;
 	std::vector<double> stdev_batch(unsigned int st, unsigned int ed, unsigned int n) const;
 
+	/** \brief computes the statistics selected by `mask` (see summary_stat_t) of the
+	`n` windows in [st..ed) at once; the prefix sums at each window boundary are
+	computed only once and shared between the statistics. The results are the same
+	as the corresponding *_batch functions. */
+	WindowSummary summary_batch(unsigned int st, unsigned int ed, unsigned int n, unsigned int mask = ALL_STATS) const;
+
 	/** \brief returns the values of bases from st to ed */
 	std::vector<double> base_value_map(unsigned int st, unsigned int ed) const;
 
@@ -116,6 +132,11 @@ public:
 	std::string name;
 
 private:
+	template<typename Func>
+	void window_stats(unsigned int st, unsigned int ed, unsigned int n, bool need_sqr, Func fx) const;
+	/// windows covering at most this many intervals on average are evaluated with a cursor
+	static const unsigned CURSOR_INTERVALS = 64;
+
 	ChrNumValType vals;
 	mscds::StringArr annotations;
 	mscds::RMQ_sct min, max;
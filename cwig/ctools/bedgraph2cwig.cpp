@@ -57,10 +57,10 @@ void testbig() {
 	fi.close();
 }
 
-void build_with_xml(const string& input, const string& output, const string& xmlout) {
+void build_with_xml(const string& input, const string& output, const string& xmlout, unsigned int nthreads) {
 	ifstream fi(input.c_str());
 	GenomeNumDataBuilder bd;
-	bd.init(true);
+	bd.init(true, ALL_OP, false, nthreads);
 	string lastchr = "";
 	while (fi) {
 		string line;
@@ -89,17 +89,17 @@ void build_with_xml(const string& input, const string& output, const string& xml
 
 }
 
-void build(const string& input, const string& output, bool xml, const string& xmlout) {
+void build(const string& input, const string& output, bool xml, const string& xmlout, unsigned int nthreads) {
 	GenomeNumDataBuilder bd;
 	try {
 		if (!xml)
-			bd.build_bedgraph(input, output);
+			bd.build_bedgraph(input, output, true, false, false, nthreads);
 		else {
 			string out;
 			if (xmlout.empty()) {
 				out = output + ".xml";
 			} else out = xmlout;
-			build_with_xml(input, output, out);
+			build_with_xml(input, output, out, nthreads);
 		}
 	}catch(std::exception& e) {
 		std::cerr << e.what() << endl;
@@ -114,6 +114,7 @@ int main(int argc, const char* argv[]) {
 		("input,i", po::value<std::string>()->required(), "Input bedGraph file")
 		("output,o", po::value<std::string>()->required(), "Output cwig file")
 		("info", po::value<std::string>()->implicit_value(""), "Produce structure XML file")
+		("threads,t", po::value<unsigned int>()->default_value(1), "Number of threads building the chromosomes (0: auto)")
 		;
 	po::positional_options_description positionalOptions;
 	positionalOptions.add("input", 1);
@@ -152,6 +153,6 @@ int main(int argc, const char* argv[]) {
 		xml_output = vm["info"].as<string>();
 	}
 	
-	build(vm["input"].as<string>(), vm["output"].as<string>(), xml, xml_output);
+	build(vm["input"].as<string>(), vm["output"].as<string>(), xml, xml_output, vm["threads"].as<unsigned int>());
 	return 0;
 }
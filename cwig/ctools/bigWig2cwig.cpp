@@ -21,12 +21,13 @@ using namespace utils;
 struct ConvertBWF: public BigWigIntervals {
 	const static int factor = 10000;
 	GenomeNumDataBuilder bd;
+	unsigned int nthreads;
 
-	ConvertBWF() {}
+	ConvertBWF(unsigned int nthreads = 1): nthreads(nthreads) {}
 	~ConvertBWF() {}
 
 	void process(const string& bwfile, const string& outfile) {
-		bd.init(true);
+		bd.init(true, ALL_OP, false, nthreads);
 		scan(bwfile);
 
 		GenomeNumData qs;
@@ -65,20 +66,13 @@ struct ConvertBWF: public BigWigIntervals {
 	}
 };
 
-int run_batch(int argc, const char* argv[]) {
-	if (argc != 2) {
-		cerr << "not enough argument";
-	}
-	ifstream fi(argv[1]);
+int run_batch(const string& listfile, unsigned int nthreads) {
+	ifstream fi(listfile.c_str());
 	if (!fi) throw runtime_error("cannot read input list");
 	string line;
-	Config * c = Config::getInst();
-	c->parse(argc, argv);
-	cout << "params: " << endl;
-	c->dump();
 	Timer tm;
 
-	ConvertBWF cf;
+	ConvertBWF cf(nthreads);
 	while (fi) {
 		getline(fi, line);
 		if (line.empty()) break;
@@ -96,12 +90,12 @@ int run_batch(int argc, const char* argv[]) {
 	return 0;
 }
 
-void build_one(const string& inp, const string&  out) {
+void build_one(const string& inp, const string&  out, unsigned int nthreads) {
 
 	if (!utils::file_exists(out)) {
 		cout << inp << "  " << out << endl;
 		Timer tm;
-		ConvertBWF cf;
+		ConvertBWF cf(nthreads);
 		cf.process(inp, out);
 		cout << tm.current() << endl;
 	} else cout << "skip" << endl;
@@ -109,15 +103,30 @@ void build_one(const string& inp, const string&  out) {
 
 
 int main(int argc, const char* argv[]) {
-	if (argc == 2)
-		return run_batch(argc, argv);
+	// positional arguments: <list_file> or <input.bw> <output>; "-D..." are parameters
+	vector<string> args;
+	unsigned int nthreads = 1;
+	for (int i = 1; i < argc; ++i) {
+		string s(argv[i]);
+		if ((s == "--threads" || s == "-t") && i + 1 < argc)
+			nthreads = atoi(argv[++i]);
+		else if (s.compare(0, 10, "--threads=") == 0)
+			nthreads = atoi(s.c_str() + 10);
+		else if (s.length() > 1 && s[0] == '-') continue;
+		else args.push_back(s);
+	}
+	if (args.empty()) {
+		cerr << "Usage:\n  bigWig2cwig [--threads N] <input.bw> <output>\n"
+			"  bigWig2cwig [--threads N] <list_file>" << endl;
+		return 1;
+	}
+	Config * c = Config::getInst();
+	c->parse(argc, argv);
+	cout << "params: " << endl;
+	c->dump();
+	if (args.size() == 1)
+		return run_batch(args[0], nthreads);
 	else
-		if (argc>=3) {
-			Config * c = Config::getInst();
-			c->parse(argc, argv);
-			cout << "params: " << endl;
-			c->dump();
-
-			build_one(argv[1], argv[2]);
-		}
+		build_one(args[0], args[1], nthreads);
+	return 0;
 }
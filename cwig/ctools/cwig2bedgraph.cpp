@@ -17,7 +17,7 @@ int main(int argc, char* argv[]) {
 	if (argc == 3) {
 		GenomeNumData qs;
 		IFileMapArchive2 fi;
-		fi.open_read(argv[1]);
+		fi.open_read(argv[1], IFileMapArchive2::SEQUENTIAL_ACCESS);
 		cout << "Loading ... " << endl;
 		qs.load(fi);
 		cout << qs.chromosome_count() << " chromosomes " << endl;
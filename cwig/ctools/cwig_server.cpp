@@ -1,16 +1,25 @@
 
 #include "url_parser.h"
 #include "utils/file_utils.h"
+#include "utils/cache_table.h"
 #include "cwig/cwig.h"
 
 #include <boost/network/include/http/server.hpp>
 #include <boost/thread.hpp>
 #include <boost/lexical_cast.hpp>
+#include <boost/algorithm/string/predicate.hpp>
+#include <boost/bind.hpp>
 #include <iostream>
 #include <map>
+#include <memory>
+#include <future>
+#include <functional>
+#include <atomic>
+#include <mutex>
 #include <unordered_map>
 #include <sstream>
 #include <stdexcept>
+#include <cstdio>
 
 namespace app_ds {
 
@@ -20,48 +29,92 @@ namespace network = boost::network;
 struct request_server;
 typedef http::async_server<request_server> server;
 
-struct file_cache {
-	boost::shared_mutex cache_mutex;
-	std::string doc_root_;
-	unsigned int max_size;
-
-	typedef std::list<std::pair<std::string, app_ds::GenomeNumData> > cache_t;
-	cache_t cache;
-	std::unordered_map<std::string, cache_t::iterator> table;
+/**
+Cache of opened CWig files shared by the worker threads.
 
+The files are distributed to several shards by the hash of their paths, each
+shard has its own lock and CLOCK replacement policy. Lookups of cached files
+only take a shared lock and set the reference bit of the entry, hence readers
+never block each other. The data is held by shared pointers so an entry can be
+evicted while queries on it are still running. The query structures keep
+internal caches and are not thread-safe, so each entry keeps a pool of opened
+query objects: a query takes an idle one (or maps the file once more when all
+are busy) and gives it back afterwards, the queries on one file run in parallel.
+The total size (file sizes) of the cached files is bounded by `max_bytes`.
+Concurrent requests of the same uncached file wait for a single load.
+*/
+struct file_cache {
+	typedef std::unique_ptr<app_ds::GenomeNumData> query_ptr;
+	/// an opened file with its idle query objects, `mtx' guards `idle'
+	struct file_entry {
+		std::string fn;
+		std::vector<query_ptr> idle;
+		std::mutex mtx;
+	};
+	typedef std::shared_ptr<file_entry> data_ptr;
 
-	explicit file_cache(std::string const & doc_root)
-		: doc_root_(doc_root) {}
-
-	bool has(std::string const & path) {
-		boost::shared_lock<boost::shared_mutex> lock(cache_mutex);
-		if (table.find(path) == table.end())
-			return false;
-		else
-			return true;
-	}
+	explicit file_cache(std::string const & doc_root, size_t max_bytes = 4ull << 30, unsigned int nshards = 16)
+		: doc_root_(doc_root), shards(nshards), shard_bytes((max_bytes + nshards - 1) / nshards) {}
 
-	bool load(std::string const & path) {
-		boost::upgrade_lock<boost::shared_mutex> lock(cache_mutex);
-		auto it = table.find(path);
-		if (it != table.end()) return true;
-		if (!utils::file_exists(doc_root_ + path)) return false;
-		boost::upgrade_to_unique_lock<boost::shared_mutex> unique_lock(lock);
-		if (table.size() >= max_size) {
-			clear_();
+	/** returns the opened file, loads it if necessary, returns NULL if the file cannot be opened */
+	data_ptr acquire(std::string const & path) {
+		shard_t& sh = shards[std::hash<std::string>()(path) % shards.size()];
+		{
+			boost::shared_lock<boost::shared_mutex> lock(sh.mtx);
+			auto it = sh.index.find(path);
+			if (it != sh.index.end()) {
+				sh.policy.touch(it->second);
+				return sh.slots[it->second].data;
+			}
+		}
+		std::shared_ptr<std::promise<data_ptr> > prom;
+		std::shared_future<data_ptr> fut;
+		{
+			boost::unique_lock<boost::shared_mutex> lock(sh.mtx);
+			auto it = sh.index.find(path);
+			if (it != sh.index.end())
+				return sh.slots[it->second].data;
+			auto lit = sh.loading.find(path);
+			if (lit != sh.loading.end())
+				fut = lit->second;
+			else {
+				prom = std::make_shared<std::promise<data_ptr> >();
+				fut = prom->get_future().share();
+				sh.loading[path] = fut;
+			}
 		}
-		cache.emplace_front(path, app_ds::GenomeNumData());
-		auto pos = table.insert(std::make_pair(path, cache.begin()));
-		assert(pos.second);
+		if (!prom) return fut.get();
+
+		data_ptr data;
 		try {
-			cache.begin()->second.loadfile(doc_root_ + path);
+			size_t bytes = 0;
+			std::string fn = doc_root_ + path;
+			if (utils::file_exists(fn)) {
+				data = std::make_shared<file_entry>();
+				data->fn = fn;
+				try {
+					data->idle.push_back(open_query(fn));
+					bytes = utils::filesize(fn);
+				}
+				catch (std::runtime_error&) {
+					data.reset();
+				}
+			}
+			boost::unique_lock<boost::shared_mutex> lock(sh.mtx);
+			if (data) insert_(sh, path, data, bytes);
+			sh.loading.erase(path);
 		}
-		catch (std::runtime_error&) {
-			cache.erase(pos.first->second);
-			table.erase(pos.first);
-			return false;
+		catch (...) {
+			// the waiters get the same exception, the next request loads the file again
+			{
+				boost::unique_lock<boost::shared_mutex> lock(sh.mtx);
+				sh.loading.erase(path);
+			}
+			prom->set_exception(std::current_exception());
+			throw;
 		}
-		return true;
+		prom->set_value(data);
+		return data;
 	}
 
 	template<typename T>
@@ -79,14 +132,48 @@ struct file_cache {
 		out << "]";
 	}
 
-	bool get(const app_ds::chrom_intv_op& query, std::string& out) {
-		boost::upgrade_lock<boost::shared_mutex> lock(cache_mutex);
-		out.clear();
-		auto it = table.find(query.file);
-		if (it == table.end()) {
-			out = "Not cached";  return false;
+	void json_dumps(const app_ds::WindowSummary& sm, std::ostream& out) {
+		out << "{\"sum\": ";
+		json_dumps(sm.sum, out);
+		out << ", \"avg\": ";
+		json_dumps(sm.avg, out);
+		out << ", \"cov\": ";
+		json_dumps(sm.coverage, out);
+		out << ", \"min\": ";
+		json_dumps(sm.min, out);
+		out << ", \"max\": ";
+		json_dumps(sm.max, out);
+		out << ", \"stdev\": ";
+		json_dumps(sm.stdev, out);
+		out << "}";
+	}
+
+	/** runs the query on the file with a query object of the pool */
+	bool get(file_entry& entry, const app_ds::chrom_intv_op& query, std::string& out) {
+		query_ptr q;
+		{
+			std::lock_guard<std::mutex> lock(entry.mtx);
+			if (!entry.idle.empty()) {
+				q = std::move(entry.idle.back());
+				entry.idle.pop_back();
+			}
 		}
-		app_ds::GenomeNumData& qs = it->second->second;
+		if (!q) q = open_query(entry.fn);
+		// a query object that threw is dropped, not returned to the pool
+		bool ok = run_query(*q, query, out);
+		std::lock_guard<std::mutex> lock(entry.mtx);
+		entry.idle.push_back(std::move(q));
+		return ok;
+	}
+private:
+	static query_ptr open_query(const std::string& fn) {
+		query_ptr q(new app_ds::GenomeNumData());
+		q->loadfile(fn, mscds::IFileMapArchive2::RANDOM_ACCESS);
+		return q;
+	}
+
+	bool run_query(app_ds::GenomeNumData& qs, const app_ds::chrom_intv_op& query, std::string& out) {
+		out.clear();
 		std::ostringstream ss;
 		int chr = qs.getChrId(query.chrom);
 		if (query.winsize == 0 || query.winsize > 10000) {
@@ -104,33 +191,83 @@ struct file_cache {
 				} else
 					if (query.opname == "max") {
 					json_dumps(qs.getChr(chr).max_value_batch(query.start, query.end, query.winsize), ss);
-					} else {
+					} else
+						if (query.opname == "summary") {
+						json_dumps(qs.getChr(chr).summary_batch(query.start, query.end, query.winsize), ss);
+						} else {
 					out = "Unknown operation";
 					return false;
 					}
 				out = ss.str();
 				return true;
 	}
-private:
-	void clear_() {
-		unsigned int sz = table.size() / 2;
-		auto it = table.begin();
-		while (it != table.end()) {
-			if (sz == 0) break;
-			if (rand() % 2 == 1) {
-				cache.erase(it->second);
-				table.erase(it++);
-			} else {
-				++it;
-			}
-		}
-		while (table.size() > sz) {
-			cache.erase(table.begin()->second);
-			table.erase(table.begin());
-		}
+
+	struct slot_t {
+		slot_t(): bytes(0) {}
+		std::string path;
+		data_ptr data;
+		size_t bytes;
+	};
+
+	struct shard_t {
+		shard_t(): policy(MAX_FILES_PER_SHARD), slots(MAX_FILES_PER_SHARD), bytes(0), next_key(0) {}
+		boost::shared_mutex mtx;
+		utils::CLOCK_Policy policy;
+		std::vector<slot_t> slots;
+		std::unordered_map<std::string, unsigned int> index;
+		std::map<std::string, std::shared_future<data_ptr> > loading;
+		size_t bytes;
+		unsigned int next_key;
+	};
+
+	static const unsigned int MAX_FILES_PER_SHARD = 256;
+
+	// requires the unique lock of the shard
+	void insert_(shard_t& sh, const std::string& path, const data_ptr& data, size_t bytes) {
+		while (sh.policy.size() > 0 && sh.bytes + bytes > shard_bytes)
+			evict_(sh, sh.policy.envict().index);
+		auto r = sh.policy.access(sh.next_key++);
+		if (r.type == utils::CLOCK_Policy::REPLACED_ENTRY)
+			evict_(sh, r.index);
+		slot_t& sl = sh.slots[r.index];
+		sl.path = path;
+		sl.data = data;
+		sl.bytes = bytes;
+		sh.bytes += bytes;
+		sh.index[path] = r.index;
 	}
+
+	// releases the data in the slot (running queries keep their own reference)
+	void evict_(shard_t& sh, unsigned int slot) {
+		slot_t& sl = sh.slots[slot];
+		sh.bytes -= sl.bytes;
+		sh.index.erase(sl.path);
+		sl = slot_t();
+	}
+
+	std::string doc_root_;
+	std::vector<shard_t> shards;
+	size_t shard_bytes;
 };
 
+/**
+writes a complete response. The vendored cpp-netlib async server handles one request per
+TCP connection, hence "Connection: close" is sent; Content-Length lets the clients reuse
+their buffers and detect truncated responses.
+*/
+inline void write_response(server::connection_ptr connection, server::connection::status_t status,
+		const std::string& data, const char * content_type = "text/plain") {
+	std::string len = boost::lexical_cast<std::string>(data.size());
+	server::response_header headers[] = {
+			{"Connection", "close"}
+			, {"Content-Type", content_type}
+			, {"Content-Length", len}
+	};
+	connection->set_status(status);
+	connection->set_headers(boost::make_iterator_range(headers, headers + 3));
+	connection->write(data);
+}
+
 struct connection_handler: boost::enable_shared_from_this<connection_handler> {
 	explicit connection_handler(file_cache & cache, bool verbose = true)
 		: file_cache_(cache), verbose_(verbose) {}
@@ -141,57 +278,206 @@ struct connection_handler: boost::enable_shared_from_this<connection_handler> {
 		app_ds::chrom_intv_op res;
 		bool ok = app_ds::parse_url_query(path, res);
 		if (!ok) { error(connection, "Wrong query format"); return; }
-		ok = file_cache_.has(res.file);
-		if (!ok)
-			ok = file_cache_.load(res.file);
-		if (ok) {
-			std::string outx;
-			ok = file_cache_.get(res, outx);
-			if (!ok) error(connection, outx);
-			else success(connection, outx);
-		} else {
-			not_found(connection);
+		file_cache::data_ptr data;
+		std::string outx;
+		try {
+			data = file_cache_.acquire(res.file);
+			if (data) ok = file_cache_.get(*data, res, outx);
+		} catch (std::exception& e) {
+			error(connection, e.what());
+			return;
+		} catch (...) {
+			error(connection, "Internal error");
+			return;
 		}
+		if (!data) not_found(connection);
+		else if (!ok) error(connection, outx);
+		else success(connection, outx);
 	}
 
 	void success(server::connection_ptr connection, const std::string& data) {
-		static server::response_header headers[] = {
-				{"Connection", "close"}
-				, {"Content-Type", "text/plain"}
-		};
-		connection->set_status(server::connection::ok);
-		connection->set_headers(boost::make_iterator_range(headers, headers + 2));
-		connection->write(data);
+		write_response(connection, server::connection::ok, data);
 		if (verbose_)
 			std::cout << " OK" << std::endl;
 	}
 
 	void error(server::connection_ptr connection, const std::string& msg) {
-		static server::response_header headers[] = {
-				{"Connection", "close"}
-				, {"Content-Type", "text/plain"}
-		};
-		connection->set_status(server::connection::internal_server_error);
-		connection->set_headers(boost::make_iterator_range(headers, headers + 2));
-		connection->write("Error: " + msg);
+		write_response(connection, server::connection::internal_server_error, "Error: " + msg);
 		if (verbose_)
 			std::cout << " ERR" << std::endl;
 	}
 
 	void not_found(server::connection_ptr connection) {
+		write_response(connection, server::connection::not_found, "File Not Found!");
+		if (verbose_)
+			std::cout << " NOT_FOUND" << std::endl;
+	}
+
+	bool verbose_;
+	file_cache & file_cache_;
+};
+
+/**
+Handles "POST /batch": the body contains one query per line
+  file chrom start end winsize op
+(separated by spaces or tabs). The queries are executed in parallel on the server's
+thread pool and the response is a JSON array with one element per query: the result
+array, or {"error": "message"} for a failed query. The results are streamed: each one
+is written as soon as it and all the results before it are finished, so only the
+results that wait for an earlier query are kept in memory.
+*/
+struct batch_handler: boost::enable_shared_from_this<batch_handler> {
+	static const size_t MAX_BODY = 1 << 20;
+	static const size_t MAX_QUERIES = 4096;
+
+	batch_handler(file_cache & cache, size_t content_length, bool verbose = true)
+		: file_cache_(cache), expected(content_length), next_out(0), writing(false), failed(false),
+		verbose_(verbose) {}
+
+	void start(server::connection_ptr connection) {
+		if (expected == 0 || expected > MAX_BODY) {
+			write_response(connection, server::connection::bad_request, "Error: missing or too large request body");
+			return;
+		}
+		body.reserve(expected);
+		read_more(connection);
+	}
+
+private:
+	void read_more(server::connection_ptr connection) {
+		connection->read(boost::bind(&batch_handler::handle_read, shared_from_this(), _1, _2, _3, _4));
+	}
+
+	void handle_read(server::connection::input_range input, boost::system::error_code ec,
+			size_t bytes_transferred, server::connection_ptr connection) {
+		body.append(boost::begin(input), boost::begin(input) + bytes_transferred);
+		if (body.size() < expected && !ec) {
+			read_more(connection);
+			return;
+		}
+		if (body.size() < expected) return; // connection error, nothing to answer
+		body.resize(expected);
+		run(connection);
+	}
+
+	void run(server::connection_ptr connection) {
+		std::istringstream lines(body);
+		std::string line;
+		while (std::getline(lines, line)) {
+			if (line.find_first_not_of(" \t\r") == std::string::npos) continue;
+			app_ds::chrom_intv_op q;
+			if (!app_ds::parse_batch_query(line, q)) {
+				write_response(connection, server::connection::bad_request, "Error: Wrong query format: " + line);
+				return;
+			}
+			queries.push_back(q);
+		}
+		if (queries.empty() || queries.size() > MAX_QUERIES) {
+			write_response(connection, server::connection::bad_request, "Error: wrong number of queries");
+			return;
+		}
+		if (verbose_)
+			std::cout << "batch of " << queries.size() << " queries" << std::endl;
+		results.resize(queries.size());
+		status.resize(queries.size());
+		done.resize(queries.size(), 0);
+		// the length is unknown, the end of the response is the end of the connection
 		static server::response_header headers[] = {
 				{"Connection", "close"}
-				, {"Content-Type", "text/plain"}
+				, {"Content-Type", "application/json"}
 		};
-		connection->set_status(server::connection::not_found);
+		connection->set_status(server::connection::ok);
 		connection->set_headers(boost::make_iterator_range(headers, headers + 2));
-		connection->write("File Not Found!");
-		if (verbose_)
-			std::cout << " NOT_FOUND" << std::endl;
+		for (size_t i = 0; i < queries.size(); ++i)
+			connection->thread_pool().post(
+				boost::bind(&batch_handler::exec, shared_from_this(), i, connection));
+	}
+
+	// file_cache::get gives each running query its own query object of the file
+	void exec(size_t i, server::connection_ptr connection) {
+		try {
+			file_cache::data_ptr data = file_cache_.acquire(queries[i].file);
+			if (data)
+				status[i] = file_cache_.get(*data, queries[i], results[i]) ? 1 : 0;
+			else {
+				results[i] = "File Not Found";
+				status[i] = 0;
+			}
+		} catch (std::exception& e) {
+			results[i] = e.what();
+			status[i] = 0;
+		} catch (...) {
+			results[i] = "Internal error";
+			status[i] = 0;
+		}
+		{
+			std::lock_guard<std::mutex> lock(out_mtx);
+			done[i] = 1;
+		}
+		flush(connection);
+	}
+
+	/** writes the finished results that follow the written ones; one write at a time,
+	the completion handler of a write starts the next one */
+	void flush(server::connection_ptr connection) {
+		std::string chunk;
+		{
+			std::lock_guard<std::mutex> lock(out_mtx);
+			if (writing || failed) return;
+			while (next_out < queries.size() && done[next_out]) {
+				size_t i = next_out++;
+				chunk += (i == 0) ? "[" : ",\n";
+				if (status[i]) chunk += results[i];
+				else chunk += "{\"error\": \"" + json_escape(results[i]) + "\"}";
+				std::string().swap(results[i]);
+				if (next_out == queries.size()) chunk += "]";
+			}
+			if (chunk.empty()) return;
+			writing = true;
+		}
+		try {
+			connection->write(chunk, boost::bind(&batch_handler::handle_write, shared_from_this(), _1, connection));
+		} catch (std::exception&) {
+			std::lock_guard<std::mutex> lock(out_mtx);
+			failed = true;
+		}
+	}
+
+	void handle_write(boost::system::error_code ec, server::connection_ptr connection) {
+		{
+			std::lock_guard<std::mutex> lock(out_mtx);
+			writing = false;
+			if (ec) failed = true;
+		}
+		flush(connection);
+	}
+
+	static std::string json_escape(const std::string& s) {
+		std::string out;
+		for (size_t i = 0; i < s.size(); ++i) {
+			unsigned char c = s[i];
+			if (c == '"' || c == '\\') { out += '\\'; out += c; }
+			else if (c < 0x20) {
+				char buf[8];
+				snprintf(buf, sizeof(buf), "\\u%04x", c);
+				out += buf;
+			} else out += c;
+		}
+		return out;
 	}
 
-	bool verbose_;
 	file_cache & file_cache_;
+	std::string body;
+	size_t expected;
+	std::vector<app_ds::chrom_intv_op> queries;
+	std::vector<std::string> results;
+	std::vector<char> status;
+	// guards the fields below and `done'
+	std::mutex out_mtx;
+	std::vector<char> done;
+	size_t next_out;
+	bool writing, failed;
+	bool verbose_;
 };
 
 struct request_server {
@@ -205,6 +491,17 @@ struct request_server {
 		if (request.method == "GET") {
 			boost::shared_ptr<connection_handler> h(new connection_handler(cache_, verbose_));
 			(*h)(request.destination, connection);
+		} else
+		if (request.method == "POST" && request.destination.compare(0, 6, "/batch") == 0) {
+			size_t content_length = 0;
+			for (auto it = request.headers.begin(); it != request.headers.end(); ++it)
+				if (boost::iequals(it->name, "Content-Length")
+						&& !boost::conversion::try_lexical_convert(it->value, content_length)) {
+					write_response(connection, server::connection::bad_request, "Error: wrong Content-Length");
+					return;
+				}
+			boost::shared_ptr<batch_handler> h(new batch_handler(cache_, content_length, verbose_));
+			h->start(connection);
 		} else {
 			static server::response_header error_headers[] = {
 					{"Connection", "close"}
@@ -3,78 +3,168 @@
 #include "cwig/cwig.h"
 #include "mem/fmap_archive2.h"
 #include "mem/info_archive.h"
+#include "utils/line_reader.h"
+#include "utils/modp_numtoa.h"
+#include "utils/parallel.h"
+
+#include <cstdio>
+#include <vector>
+#include <algorithm>
+#include <atomic>
 
 using namespace std;
 using namespace app_ds;
 
 namespace app_ds {
 
-template<typename T>
-void printarr(const std::vector<T>& arr) {
-	for (auto it = arr.begin(); it != arr.end(); ++it)
-		cout << *it << "  ";
-	cout << endl;
-}
+/// output buffer of one region, numbers are written with the modp formatters
+struct ResultText {
+	std::string s;
+	void clear() { s.clear(); }
+	void put(double v) {
+		char buf[64];
+		int l = utils::modp_dtoa2(v, buf, 6);
+		s.append(buf, l);
+		s.append("  ");
+	}
+	void put(unsigned int v) {
+		char buf[16];
+		utils::modp_uitoa10(v, buf);
+		s.append(buf);
+		s.append("  ");
+	}
+	template<typename T>
+	void putarr(const std::vector<T>& arr) {
+		for (auto it = arr.begin(); it != arr.end(); ++it)
+			put(*it);
+		s.push_back('\n');
+	}
+};
 
+/**
+Evaluates the regions of a BED file in chunks. The regions of a chunk are
+sorted by chromosome and position, split into slices that the worker threads
+take in turn, and the results are written in the input order.
 
-struct Entry {
-	std::string chrom;
-	unsigned int st, ed;
-	bool changed;
-	Entry(): changed(true) {}
-	void clear() {
-		chrom.clear();
+The query structures keep per-instance block state, each worker has its own
+GenomeNumData over the same read-only mapping of the cwig file.
+*/
+class BatchQuery {
+public:
+	BatchQuery(const std::string& cwigfile, const std::string& cmd, unsigned int size, unsigned int nthreads);
+	void run(const std::string& bedfile, std::FILE* out);
+
+	/// number of regions per chunk
+	static const size_t CHUNK = 1 << 16;
+	/// number of slices per thread in a chunk (for load balancing)
+	static const unsigned int SLICES = 8;
+private:
+	struct Region {
+		int chr;
+		unsigned int st, ed;
+	};
+	enum QueryOp { AVG_OP, COV_OP, MIN_OP, MAX_OP, SUMMARY_OP };
+
+	void process(std::FILE* out);
+	void eval(GenomeNumData& qs, const Region& r, ResultText& res) const;
+
+	QueryOp op;
+	unsigned int size, nthreads;
+	std::vector<GenomeNumData> qs;
+	std::vector<Region> regs;
+	std::vector<uint32_t> order;
+	std::vector<ResultText> outs;
+};
+
+BatchQuery::BatchQuery(const std::string& cwigfile, const std::string& cmd, unsigned int size, unsigned int nthreads)
+		: size(size), nthreads(utils::resolve_threads(nthreads)) {
+	if (cmd == "avg") op = AVG_OP;
+	else if (cmd == "cov") op = COV_OP;
+	else if (cmd == "min") op = MIN_OP;
+	else if (cmd == "max") op = MAX_OP;
+	else if (cmd == "summary") op = SUMMARY_OP;
+	else throw std::runtime_error("unknown query: " + cmd);
+	if (this->size == 0) this->size = 1;
+	qs.resize(this->nthreads);
+	for (unsigned int t = 0; t < this->nthreads; ++t)
+		qs[t].loadfile(cwigfile, mscds::IFileMapArchive2::RANDOM_ACCESS);
+}
+
+void BatchQuery::eval(GenomeNumData& qs, const Region& r, ResultText& res) const {
+	res.clear();
+	if (r.chr < 0) {
+		// unknown chromosome: a "0" line per output line of the operation
+		res.s = (op == SUMMARY_OP) ? "0\n0\n0\n0\n0\n0\n" : "0\n";
+		return;
+	}
+	const ChrNumData& chr = qs.getChr(r.chr);
+	switch (op) {
+	case AVG_OP: res.putarr(chr.avg_batch(r.st, r.ed, size)); break;
+	case COV_OP: res.putarr(chr.coverage_batch(r.st, r.ed, size)); break;
+	case MIN_OP: res.putarr(chr.min_value_batch(r.st, r.ed, size)); break;
+	case MAX_OP: res.putarr(chr.max_value_batch(r.st, r.ed, size)); break;
+	case SUMMARY_OP: {
+		// one line per statistic: sum, avg, cov, min, max, stdev
+		WindowSummary sm = chr.summary_batch(r.st, r.ed, size);
+		res.putarr(sm.sum);
+		res.putarr(sm.avg);
+		res.putarr(sm.coverage);
+		res.putarr(sm.min);
+		res.putarr(sm.max);
+		res.putarr(sm.stdev);
+		break;
 	}
+	}
+}
 
-	void quick_parse(const std::string& s) {
-		const char * p = s.c_str();
-		unsigned int i = 0;
-		while (*p != ' ' && *p != '\t' && i < chrom.length() && i < s.length() && *p == chrom[i]) {
-			++p;
-			++i;
-		}
-		// same chrom name
-		if (i == chrom.length() && chrom.length() > 0 && (*p == ' ' || *p == '\t')) {
-			//this->chrom = pre_chr; // no change
-			this->changed = false;
-		} else {
-			while (*p != ' ' && *p != '\t' && i < s.length()) { ++p; ++i; }
-			this->chrom = std::string(s.c_str(), p);
-			this->changed = true;
-		}
-		if (*p == ' ' || *p == '\t') ++p;
-		else throw std::runtime_error(std::string("error parsing line: ") + s);
-		unsigned int st = 0;
-		while (*p >= '0' && *p <= '9' && i < s.length()) {
-			st = (st * 10) + (*p - '0');
-			++i;
-			++p;
-		}
-		this->st = st;
-		if (*p == ' ' || *p == '\t') ++p;
-		else throw std::runtime_error(std::string("error parsing line: ") + s);
-		unsigned int ed = 0;
-		while (*p >= '0' && *p <= '9' && i < s.length()) {
-			ed = (ed * 10) + (*p - '0');
-			++i;
-			++p;
+void BatchQuery::process(std::FILE* out) {
+	const size_t n = regs.size();
+	order.resize(n);
+	for (size_t i = 0; i < n; ++i) order[i] = (uint32_t) i;
+	std::sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b) {
+		const Region &x = regs[a], &y = regs[b];
+		return x.chr < y.chr || (x.chr == y.chr && x.st < y.st);
+	});
+	if (outs.size() < n) outs.resize(n);
+
+	const size_t nslices = std::min<size_t>(n, nthreads * SLICES);
+	std::atomic<size_t> next(0);
+	utils::parallel_parts(nthreads, nthreads, [&](unsigned int t, size_t, size_t) {
+		size_t sl;
+		while ((sl = next++) < nslices) {
+			size_t st = n * sl / nslices, ed = n * (sl + 1) / nslices;
+			for (size_t k = st; k < ed; ++k)
+				eval(qs[t], regs[order[k]], outs[order[k]]);
 		}
-		this->ed = ed;
-	}
-};
+	});
+	for (size_t i = 0; i < n; ++i)
+		std::fwrite(outs[i].s.data(), 1, outs[i].s.size(), out);
+	regs.clear();
+}
 
-template<typename Func>
-void query_file(const std::string& fname, Func fx) {
-	std::string line;
+void BatchQuery::run(const std::string& bedfile, std::FILE* out) {
+	utils::MappedLineReader fi;
+	fi.open(bedfile);
+	utils::StrRef line;
+	utils::BedRecord r;
 	std::string chrom;
-	//unsigned int start, end;
-	Entry et;
-	ifstream fi(fname.c_str());
-	while (std::getline(fi, line)) {
-		et.quick_parse(line);
-		fx(et.changed, et.chrom, et.st, et.ed);
+	int chr = -1;
+	regs.clear();
+	regs.reserve(CHUNK);
+	while (fi.next(line)) {
+		if (!utils::parse_bed_line(line, r))
+			throw std::runtime_error(std::string("error parsing line: ") + line.str());
+		if (!r.chrom.equals(chrom) || regs.empty()) {
+			chrom = r.chrom.str();
+			chr = qs[0].getChrId(chrom);
+		}
+		Region rg = {chr, r.st, r.ed};
+		regs.push_back(rg);
+		if (regs.size() == CHUNK) process(out);
 	}
+	if (!regs.empty()) process(out);
 	fi.close();
+	std::fflush(out);
 }
 
 }//namespace
@@ -82,77 +172,26 @@ void query_file(const std::string& fname, Func fx) {
 using namespace app_ds;
 
 int main(int argc, char* argv[]) {
-	if (argc != 4 && argc != 5) {
-		cerr << "cwig_summary {avg|cov|min|max} <cwigfile> <bedfile> <size=1>" << endl;
+	if (argc < 4 || argc > 6) {
+		cerr << "cwig_summary {avg|cov|min|max|summary} <cwigfile> <bedfile> <size=1> <threads=1>" << endl;
+		cerr << "  threads=0 uses all the hardware threads" << endl;
 		return 1;
 	}
-	mscds::IFileMapArchive2 fi;
-	fi.open_read(argv[2]);
-	
-	unsigned int sz = 1;
-	if (argc == 5) sz = atoi(argv[4]);
-	
-	GenomeNumData qs;
-	qs.load(fi);
-	
+	unsigned int sz = 1, nthreads = 1;
+	if (argc >= 5) sz = atoi(argv[4]);
+	if (argc >= 6) nthreads = atoi(argv[5]);
+
 	string cmd(argv[1]);
-	unsigned int lastid = -1;
-	if (cmd == "avg") {
-		query_file(argv[3], [&qs,&lastid,sz](bool changed, std::string& chrom, unsigned int st, unsigned int ed) {
-			if (changed) lastid = qs.getChrId(chrom);
-			if (lastid != -1)
-				printarr(qs.getChr(lastid).avg_batch(st, ed, sz));
-			else std::cout << 0 << std::endl;
-		});
-	} else
-	if (cmd == "cov") {
-		query_file(argv[3], [&qs, &lastid, sz](bool changed, std::string& chrom, unsigned int st, unsigned int ed) {
-			if (changed) lastid = qs.getChrId(chrom);
-			if (lastid != -1)
-				printarr(qs.getChr(lastid).coverage_batch(st, ed, sz));
-			else std::cout << 0 << std::endl;
-		});
-	} else
-	if (cmd == "min") {
-		query_file(argv[3], [&qs, &lastid, sz](bool changed, std::string& chrom, unsigned int st, unsigned int ed) {
-			if (changed) lastid = qs.getChrId(chrom);
-			if (lastid != -1)
-				printarr(qs.getChr(lastid).min_value_batch(st, ed, sz));
-			else std::cout << 0 << std::endl;
-		});
-	} else
-	if (cmd == "max") {
-		query_file(argv[3], [&qs, &lastid, sz](bool changed, std::string& chrom, unsigned int st, unsigned int ed) {
-			if (changed) lastid = qs.getChrId(chrom);
-			if (lastid != -1)
-				printarr(qs.getChr(lastid).max_value_batch(st, ed, sz));
-			else std::cout << 0 << std::endl;
-		});
-	} /* else
-	if (cmd == "lst") {
-		auto & chrds = qs.getChr(chr);
-		auto rng = chrds.find_intervals(start, end);
-		cout << "Indexes: " << rng.first << " " << rng.second << endl;
-		if (rng.first < rng.second) {
-			app_ds::ChrNumValType::Enum e;
-			chrds.getEnum(rng.first, &e);
-			for (unsigned int i = rng.first; i < rng.second; ++i) {
-				auto intv = e.next();
-				cout << argv[3] << "\t" << intv.st << "\t" << intv.ed << "\t" << intv.val << "\n";
-			}
-			cout << endl;
-		}
-	} else
-	if (cmd == "map") {
-		auto & chrds = qs.getChr(chr);
-		auto arr = chrds.base_value_map(start, end);
-		for (unsigned int i = 0; i < arr.size(); ++i)
-			cout << arr[i] << " ";
-		cout << endl;
-	} */
-	else {
+	if (cmd != "avg" && cmd != "cov" && cmd != "min" && cmd != "max" && cmd != "summary") {
 		cerr << "unknow query" << endl;
+		return 1;
+	}
+	try {
+		BatchQuery bq(argv[2], cmd, sz, nthreads);
+		bq.run(argv[3], stdout);
+	} catch (std::exception& e) {
+		cerr << "error: " << e.what() << endl;
+		return 1;
 	}
-	qs.clear();
 	return 0;
 }
@@ -10,6 +10,8 @@
 #include <boost/fusion/include/io.hpp>
 
 #include <iostream>
+#include <sstream>
+#include <limits>
 
 BOOST_FUSION_ADAPT_STRUCT(app_ds::chrom_intv_op,
 	(std::string, file)
@@ -60,6 +62,28 @@ bool parse_url_query(const std::string& url, chrom_intv_op& out) {
 	return r;
 }
 
+// reads a number that fits in unsigned int, negative values are rejected
+// (`>> unsigned int' would wrap them around)
+static bool read_uint(std::istream& ss, unsigned int& out) {
+	long long v;
+	if (!(ss >> v) || v < 0 || v > (long long) std::numeric_limits<unsigned int>::max())
+		return false;
+	out = (unsigned int) v;
+	return true;
+}
+
+bool parse_batch_query(const std::string& line, chrom_intv_op& out) {
+	std::istringstream ss(line);
+	if (!(ss >> out.file >> out.chrom)) return false;
+	if (!read_uint(ss, out.start) || !read_uint(ss, out.end) || !read_uint(ss, out.winsize))
+		return false;
+	if (!(ss >> out.opname)) return false;
+	// the files are relative to the document root
+	if (out.file.find_first_of("/\\") != std::string::npos) return false;
+	std::string rest;
+	return !(ss >> rest);
+}
+
 
 
 }
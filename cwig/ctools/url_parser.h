@@ -14,5 +14,8 @@ struct chrom_intv_op {
 
 bool parse_url_query(const std::string& url, chrom_intv_op& out);
 
+/** parses one line of a batch query: "file chrom start end winsize op" */
+bool parse_batch_query(const std::string& line, chrom_intv_op& out);
+
 
 }//namespace
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include "mem/file_archive2.h"
 #include "mem/fmap_archive2.h"
 #include "utils/str_utils.h"
+#include "utils/line_reader.h"
 #include "remote_file/remote_archive2.h"
 #include <iostream>
 #include <fstream>
@@ -30,91 +31,76 @@ void BED_Entry::parse(const std::string& s) {
 }
 
 void BED_Entry::quick_parse(const std::string& s, const std::string& pre_chr) {
-	const char * p = s.c_str();
-	unsigned int i = 0;
-	while (*p != ' ' && *p != '\t' && i < pre_chr.length() && i < s.length() && *p == pre_chr[i]) {
-		++p;
-		++i;
-	}
-	// same chrom name
-	if (i == pre_chr.length() && pre_chr.length() > 0 && (*p == ' ' || *p == '\t')) {
+	utils::BedRecord r;
+	if (!utils::parse_bedgraph_line(utils::StrRef(s), r))
+		throw std::runtime_error(std::string("error parsing line: ") + s);
+	if (!r.chrom.equals(pre_chr))
+		this->chrom = r.chrom.str();
+	else
 		this->chrom = pre_chr;
+	this->st = r.st;
+	this->ed = r.ed;
+	this->val = r.val;
+}
+
+void GenomeNumDataBuilder::add_bedgraph_line(const utils::StrRef& line, std::string& curchr) {
+	size_t i = 0;
+	while (i < line.size() && std::isspace(line[i])) ++i;
+	if (i == line.size() || line[i] == '#') return;
+	utils::BedRecord r;
+	if (!utils::parse_bedgraph_line(line, r))
+		throw std::runtime_error(std::string("error parsing line: ") + line.str());
+	if (!r.chrom.equals(curchr)) {
+		curchr = r.chrom.str();
+		changechr(curchr);
 	}
-	else {
-		while (*p != ' ' && *p != '\t' && i < s.length()) { ++p; ++i; }
-		this->chrom = std::string(s.c_str(), p);
-	}
-	if (*p == ' ' || *p == '\t') ++p;
-	else throw std::runtime_error(std::string("error parsing line: ") + s);
-	unsigned int st = 0;
-	while (*p >= '0' && *p <= '9' && i < s.length()) {
-		st = (st * 10) + (*p - '0');
-		++i;
-		++p;
-	}
-	this->st = st;
-	if (*p == ' ' || *p == '\t') ++p;
-	else throw std::runtime_error(std::string("error parsing line: ") + s);
-	unsigned int ed = 0;
-	while (*p >= '0' && *p <= '9' && i < s.length()) {
-		ed = (ed * 10) + (*p - '0');
-		++i;
-		++p;
-	}
-	this->ed = ed;
-	if (*p == ' ' || *p == '\t') ++p;
-	else throw std::runtime_error(std::string("error parsing line: ") + s);
-	this->val = utils::atof2(p);
+	if (annotation)
+		add(r.st, r.ed, r.val, r.rest.str());
+	else
+		add(r.st, r.ed, r.val);
 }
 
 void GenomeNumDataBuilder::build_bedgraph(std::istream& fi, mscds::OutArchive& ar,
-										  bool minmax_query, bool annotation) {
+										  bool minmax_query, bool annotation, unsigned int nthreads) {
 	clear();
-	init(false, (minmax_query ? ALL_OP : NO_MINMAX), annotation);
-	std::string curchr = "";
-	while (fi) {
-		std::string line;
-		std::getline(fi, line);
-		if (!fi) break;
-		unsigned int i = 0;
-		while (i < line.length() && std::isspace(line[i])) ++i;
-		if (i == line.size() || line[i] == '#') continue;
-		BED_Entry b;
-		if (annotation) b.parse_ann(line);
-		else b.quick_parse(line, curchr);
-		if (b.chrom != curchr) {
-			changechr(b.chrom);
-			curchr = b.chrom;
-		}
-		add(b.st, b.ed, b.val, b.annotation);
-	}
+	init(false, (minmax_query ? ALL_OP : NO_MINMAX), annotation, nthreads);
+	std::string curchr = "", line;
+	while (std::getline(fi, line))
+		add_bedgraph_line(utils::StrRef(line), curchr);
 	build(ar);
 }
 
 void GenomeNumDataBuilder::build_bedgraph(const std::string &input, const std::string &output,
-	bool minmax_query, bool annotation, bool output_structure_file) {
-	const unsigned int BUFSIZE = 512 * 1024;
-	char buffer[BUFSIZE];
-	std::ifstream fi(input.c_str());
-	fi.rdbuf()->pubsetbuf(buffer, BUFSIZE);
+	bool minmax_query, bool annotation, bool output_structure_file, unsigned int nthreads) {
+	utils::MappedLineReader fi;
+	fi.open(input);
+	clear();
+	init(false, (minmax_query ? ALL_OP : NO_MINMAX), annotation, nthreads);
+	std::string curchr = "";
+	utils::StrRef line;
+	while (fi.next(line))
+		add_bedgraph_line(line, curchr);
+	fi.close();
 	mscds::OFileArchive2 fo;
 	fo.open_write(output);
-	build_bedgraph(fi, fo, minmax_query, annotation);
+	build(fo);
 	fo.close();
-	fi.close();
 }
 
 
 void GenomeNumDataBuilder::clear() {
+	pool.reset();
+	built.clear();
 	chrid.clear();
 	list.clear();
 	tmpfn.clear();
 	numchr = 0;
 }
 
-void GenomeNumDataBuilder::init(bool one_by_one_chrom, minmaxop_t opt, bool range_annotation) {
+void GenomeNumDataBuilder::init(bool one_by_one_chrom, minmaxop_t opt, bool range_annotation, unsigned int nthreads) {
 	clear();
 	this->opt = opt;
+	this->nthreads = nthreads;
 	onechr = one_by_one_chrom;
 	annotation = range_annotation;
 	numchr = 0;
@@ -131,7 +117,8 @@ void GenomeNumDataBuilder::changechr(const std::string &chr) {
 	if (onechr) {
 		if (lastname == chr) return ;
 		if (list[0].size() > 0) {
-			buildtemp(lastname);
+			if (nthreads != 1) submitchr(lastname);
+			else buildtemp(lastname);
 			numchr++;
 		}
 		lastchr = 1;
@@ -179,10 +166,45 @@ void GenomeNumDataBuilder::buildtemp(const std::string& name) {
 	tmpfn.push_back(fn);
 }
 
+void GenomeNumDataBuilder::submitchr(const std::string& name) {
+	if (!pool) pool.reset(new utils::TaskQueue(nthreads, utils::resolve_threads(nthreads)));
+	if (annotation && empty_ann) annotation = false;
+	bool ann = annotation;
+	auto out = std::make_shared<mscds::OMemArchive>();
+	built.push_back(out);
+	auto lst = std::make_shared<RangeListTp>();
+	lst->swap(list[0]);
+	pool->submit([this, name, lst, out, ann]() {
+		ChrNumData data;
+		buildchr(name, *lst, &data, ann);
+		lst->clear();
+		data.save(*out);
+		out->close();
+	});
+}
+
+void GenomeNumDataBuilder::collect(GenomeNumData *data) {
+	if (pool) pool->wait();
+	data->clear();
+	data->chrs.resize(built.size());
+	for (size_t i = 0; i < built.size(); ++i) {
+		mscds::IMemArchive fi(*built[i]);
+		data->chrs[i].load(fi);
+		fi.close();
+		built[i].reset();
+	}
+	data->nchr = data->chrs.size();
+	data->loadinit();
+}
+
 void GenomeNumDataBuilder::buildchr(const std::string& name, RangeListTp& rlst, ChrNumData * out) {
-	ChrNumDataBuilder bd;
 	if (annotation && empty_ann) annotation = false;
-	bd.init(opt, annotation);
+	buildchr(name, rlst, out, annotation);
+}
+
+void GenomeNumDataBuilder::buildchr(const std::string& name, RangeListTp& rlst, ChrNumData * out, bool ann) const {
+	ChrNumDataBuilder bd;
+	bd.init(opt, ann);
 	if (!std::is_sorted(rlst.begin(), rlst.end()))
 		std::sort(rlst.begin(), rlst.end());
 	for (auto it = rlst.begin(); it != rlst.end(); ++it) {
@@ -194,6 +216,14 @@ void GenomeNumDataBuilder::buildchr(const std::string& name, RangeListTp& rlst,
 
 void GenomeNumDataBuilder::build(GenomeNumData *data) {
 	if (list.empty()) return ;
+	if (onechr && nthreads != 1) {
+		if (list[0].size() > 0) {
+			submitchr(lastname);
+			numchr++;
+		}
+		collect(data);
+		clear();
+	} else
 	if (onechr) {
 		if (list[0].size() > 0) {
 			buildtemp(lastname);
@@ -218,14 +248,35 @@ void GenomeNumDataBuilder::build(GenomeNumData *data) {
 		data->clear();
 		assert(chrid.size() == numchr);
 		data->chrs.resize(numchr);
+		if (annotation && empty_ann) annotation = false;
+		std::vector<std::pair<RangeListTp*, unsigned int> > jobs;
+		std::vector<const std::string*> names(numchr);
 		unsigned int i = 0;
 		for (auto chrit = chrid.begin(); chrit != chrid.end(); ++chrit) {
 			if (list[chrit->second-1].size() > 0) {
 				data->chrs[i].clear();
-				buildchr(chrit->first, list[chrit->second-1], &(data->chrs[i]));
+				names[i] = &(chrit->first);
+				jobs.push_back(std::make_pair(&(list[chrit->second-1]), i));
 				++i;
 			}
 		}
+		if (nthreads != 1 && jobs.size() > 1) {
+			// largest chromosomes first for a better balance between the threads
+			std::sort(jobs.begin(), jobs.end(), [](const std::pair<RangeListTp*, unsigned int>& a,
+				const std::pair<RangeListTp*, unsigned int>& b) { return a.first->size() > b.first->size(); });
+			utils::TaskQueue workers(nthreads);
+			for (auto it = jobs.begin(); it != jobs.end(); ++it) {
+				RangeListTp* lst = it->first;
+				ChrNumData* out = &(data->chrs[it->second]);
+				const std::string* name = names[it->second];
+				bool ann = annotation;
+				workers.submit([this, lst, out, name, ann]() { buildchr(*name, *lst, out, ann); });
+			}
+			workers.wait();
+		} else {
+			for (auto it = jobs.begin(); it != jobs.end(); ++it)
+				buildchr(*names[it->second], *(it->first), &(data->chrs[it->second]));
+		}
 		data->nchr = data->chrs.size();
 		data->loadinit();
 		clear();
@@ -233,6 +284,11 @@ void GenomeNumDataBuilder::build(GenomeNumData *data) {
 }
 
 void GenomeNumDataBuilder::build(mscds::OutArchive &ar) {
+	if (onechr && nthreads != 1) {
+		GenomeNumData data;
+		build(&data);
+		data.save(ar);
+	} else
 	if (onechr) {
 		GenomeNumData data;
 		if (list[0].size() > 0) {
@@ -278,7 +334,7 @@ void GenomeNumData::loadinit() {
 	}
 }
 
-void GenomeNumData::loadfile(const std::string &input) {
+void GenomeNumData::loadfile(const std::string &input, mscds::IFileMapArchive2::AccessAdvice advice) {
 	if (input.length() >= 8 && (input.substr(0, 7) == "http://" || input.substr(0, 8) == "https://")) {
 		mscds::RemoteArchive2 rar;
 		rar.open_url(input);
@@ -286,7 +342,7 @@ void GenomeNumData::loadfile(const std::string &input) {
 	}
 	else {
 		mscds::IFileMapArchive2 fi;
-		fi.open_read(input);
+		fi.open_read(input, advice);
 		load(fi);
 		fi.close();
 	}
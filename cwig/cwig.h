@@ -8,6 +8,13 @@
 #include <map>
 #include "chrfmt.h"
 #include "framework/archive.h"
+#include "mem/fmap_archive2.h"
+#include "mem/info_archive.h"
+#include "utils/parallel.h"
+#include "utils/line_reader.h"
+
+#include <deque>
+#include <memory>
 
 /// namespace for applications
 namespace app_ds {
@@ -24,11 +31,19 @@ struct BED_Entry {
 	void quick_parse(const std::string& s, const std::string& pre_chr);
 };
 
-/// Build CWig file. (The class is named before the project was named.)
+/** \brief Build CWig file. (The class is named before the project was named.)
+
+With `nthreads` != 1, the chromosomes are built concurrently. In the
+`one_by_one_chrom` mode a chromosome is handed to the worker threads as soon as
+the input moves to the next one, hence parsing overlaps with building, and the
+built chromosomes are serialized in memory instead of temporary files.
+*/
 class GenomeNumDataBuilder {
 public:
+	GenomeNumDataBuilder(): nthreads(1) {}
+	/** `nthreads` is the number of threads used to build the chromosomes (0 = auto) */
 	void init(bool one_by_one_chrom = false,
-			  minmaxop_t opt = ALL_OP, bool range_annotation = false);
+			  minmaxop_t opt = ALL_OP, bool range_annotation = false, unsigned int nthreads = 1);
 	void changechr(const std::string& chr);
 	void add(unsigned int st, unsigned int ed, double d, const std::string& annotation = "");
 	void add(const std::string& bed_line);
@@ -36,7 +51,7 @@ public:
 	void build(mscds::OutArchive& ar);
 	/// build from BedGraph file
 	void build_bedgraph(std::istream& fi, mscds::OutArchive& ar,
-		 bool minmax_query = true, bool annotation = false);
+		 bool minmax_query = true, bool annotation = false, unsigned int nthreads = 1);
 	/**
 	  * \brief converts the BED graph file into our format
 	  *
@@ -48,13 +63,15 @@ public:
 	  * \param factor the multiply factor
 	  * \param minmax_query sets to true if you want to ask min/max query (default is true)
 	  * \param annotation   sets to true if you want to add text annotations (default is false)
+	  * \param nthreads     number of threads used to build the chromosomes (0 = auto)
 	  *
 	  * The BED graph file format contains multiple lines. Each line has four tokens
 	  * chromsome_name  start_position  end_position  optional_annotation
 	  * 
 	  */
 	void build_bedgraph(const std::string& input, const std::string& output,
-		bool minmax_query = true, bool annotation = false, bool output_structure_file=false);
+		bool minmax_query = true, bool annotation = false, bool output_structure_file=false,
+		unsigned int nthreads = 1);
 	void clear();
 private:
 	std::map<std::string, unsigned int> chrid;
@@ -66,7 +83,16 @@ private:
 	bool onechr, annotation, empty_ann;
 	void buildtemp(const std::string& name);
 	void buildchr(const std::string& name, RangeListTp& lst, ChrNumData * out);
+	void buildchr(const std::string& name, RangeListTp& lst, ChrNumData * out, bool ann) const;
+	void add_bedgraph_line(const utils::StrRef& line, std::string& curchr);
+	/// hands the current chromosome to the worker threads (one_by_one_chrom mode)
+	void submitchr(const std::string& name);
+	void collect(GenomeNumData* data);
 	std::vector<std::string> tmpfn;
+
+	unsigned int nthreads;
+	std::deque<std::shared_ptr<mscds::OMemArchive> > built;
+	std::unique_ptr<utils::TaskQueue> pool; // declared after `built', stops first
 };
 
 
@@ -76,8 +102,13 @@ public:
 	/** \brief returns the data structure for chrosome `chrid' (starts with 0) */
 	const ChrNumData& getChr(unsigned int chrid) { return chrs[chrid]; }
 
-	/** \brief loads the data structure from file */
-	void loadfile(const std::string& input);
+	/** \brief loads the data structure from file
+
+	Local files are memory mapped, the data is not copied (the structures point to
+	the mapped pages). `advice` hints the expected access pattern to the OS.
+	*/
+	void loadfile(const std::string& input,
+		mscds::IFileMapArchive2::AccessAdvice advice = mscds::IFileMapArchive2::NORMAL_ACCESS);
 
 	void load(mscds::InpArchive& ar);
 
@@ -14,6 +14,7 @@
 #include <cstring>
 #include <tuple>
 #include <fstream>
+#include <sstream>
 
 using namespace std;
 using namespace app_ds;
@@ -257,6 +258,85 @@ TEST(cwig, stdev) {
 	ASSERT_DOUBLE_EQ(2, v);
 }
 
+TEST(cwig, parallel_build) {
+	std::vector<std::string> lines;
+	for (unsigned int c = 0; c < 7; ++c) {
+		unsigned int p = rand() % 100;
+		unsigned int n = 100 + rand() % 3000;
+		for (unsigned int i = 0; i < n; ++i) {
+			unsigned int l = 1 + rand() % 30;
+			std::ostringstream ss;
+			ss << "chr" << c << " " << p << " " << p + l << " " << (rand() % 100) / 4.0;
+			lines.push_back(ss.str());
+			p += l + rand() % 20;
+		}
+	}
+	for (unsigned int mode = 0; mode < 2; ++mode) {
+		GenomeNumDataBuilder bd1, bd4;
+		bd1.init(mode == 1);
+		bd4.init(mode == 1, ALL_OP, false, 4);
+		for (size_t i = 0; i < lines.size(); ++i) {
+			bd1.add(lines[i]);
+			bd4.add(lines[i]);
+		}
+		GenomeNumData d1, d4;
+		bd1.build(&d1);
+		bd4.build(&d4);
+		ASSERT_EQ(d1.chromosome_count(), d4.chromosome_count());
+		for (unsigned int c = 0; c < d1.chromosome_count(); ++c) {
+			const ChrNumData& x = d1.getChr(c);
+			const ChrNumData& y = d4.getChr(c);
+			ASSERT_EQ(x.name, y.name);
+			ASSERT_EQ(x.count_intervals(), y.count_intervals());
+			ASSERT_EQ(x.last_position(), y.last_position());
+			for (unsigned int p = 0; p < x.last_position(); p += 1 + rand() % 100) {
+				ASSERT_EQ(x.sum(p), y.sum(p));
+				ASSERT_EQ(x.coverage(p), y.coverage(p));
+			}
+		}
+	}
+}
+
+TEST(cwig, summary_batch) {
+	GenomeNumDataBuilder bd;
+	bd.init(false, ALL_OP);
+	unsigned int p = 100;
+	for (unsigned int i = 0; i < 2000; ++i) {
+		unsigned int l = 1 + rand() % 30;
+		std::ostringstream ss;
+		ss << "chr1 " << p << " " << p + l << " " << (rand() % 100) / 4.0;
+		bd.add(ss.str());
+		p += l + rand() % 20;
+	}
+	GenomeNumData d;
+	bd.build(&d);
+	const ChrNumData& t = d.getChr(d.getChrId("chr1"));
+	for (unsigned int k = 0; k < 200; ++k) {
+		unsigned int st = rand() % p, ed = st + 1 + rand() % (p - st), n = 1 + rand() % 200;
+		WindowSummary sm = t.summary_batch(st, ed, n);
+		auto sum = t.sum_batch(st, ed, n), avg = t.avg_batch(st, ed, n);
+		auto mi = t.min_value_batch(st, ed, n), mx = t.max_value_batch(st, ed, n);
+		auto cov = t.coverage_batch(st, ed, n);
+		ASSERT_EQ(n, sm.sum.size());
+		for (unsigned int i = 0; i < n; ++i) {
+			ASSERT_EQ(cov[i], sm.coverage[i]);
+			if (cov[i] == 0) continue;
+			ASSERT_DOUBLE_EQ(sum[i], sm.sum[i]);
+			ASSERT_DOUBLE_EQ(avg[i], sm.avg[i]);
+			ASSERT_EQ(mi[i], sm.min[i]);
+			ASSERT_EQ(mx[i], sm.max[i]);
+		}
+		if (ed - st > n) {
+			auto sd = t.stdev_batch(st, ed, n);
+			for (unsigned int i = 0; i < n; ++i)
+				if (cov[i] > 0) ASSERT_NEAR(sd[i], sm.stdev[i], 1e-9);
+		}
+		WindowSummary s2 = t.summary_batch(st, ed, n, SUM_STAT | MAX_STAT);
+		ASSERT_EQ(0, s2.avg.size());
+		ASSERT_EQ(n, s2.max.size());
+	}
+}
+
 #include "utils/str_utils.h"
 
 using namespace utils;
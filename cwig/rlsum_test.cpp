@@ -157,6 +157,53 @@ TEST(rlsum, fuse_2) {
 	test_rlsum_tb_2<IntValQuery2>();
 }
 
+template<typename IntValQuery>
+void test_fuse_cursor(const vector<int>& A) {
+	std::deque<ValRange> inp = convertVR(genInp(A));
+	typename IntValQuery::BuilderTp bd;
+	for (unsigned int i = 0; i < inp.size(); ++i)
+		bd.add(inp[i].st, inp[i].ed, inp[i].val);
+	IntValQuery y;
+	bd.build(&y);
+
+	typename IntValQuery::Enum e;
+	y.getEnum(0, &e);
+	for (unsigned int i = 0; i < inp.size(); ++i) {
+		ASSERT_TRUE(e.hasNext());
+		auto x = e.next();
+		ASSERT_EQ(inp[i].st, x.st);
+		ASSERT_EQ(inp[i].ed, x.ed);
+		ASSERT_EQ(inp[i].val, x.val);
+	}
+	ASSERT_FALSE(e.hasNext());
+
+	unsigned int len = A.size();
+	for (unsigned int st = 0; st < len; st += 1 + rand() % 50) {
+		typename IntValQuery::PrefixCursor c;
+		y.getCursor(st, &c);
+		for (unsigned int p = st; p <= len; p += rand() % 20) {
+			c.advance(p);
+			double sm, sq;
+			unsigned int cov;
+			y.prefix_stats(p, &sm, &sq, &cov);
+			ASSERT_EQ(y.sum(p), sm);
+			ASSERT_EQ(y.sqrsum(p), sq);
+			ASSERT_EQ(y.countnz(p), cov);
+			ASSERT_EQ(sm, c.sum);
+			ASSERT_EQ(sq, c.sqrsum);
+			ASSERT_EQ(cov, c.coverage);
+		}
+	}
+}
+
+TEST(rlsum, fuse_cursor) {
+	for (int i = 0; i < 20; i++) {
+		vector<int> A = gen_density(10000);
+		test_fuse_cursor<IntValQuery2>(A);
+		test_fuse_cursor<IntValQuery3>(A);
+	}
+}
+
 TEST(rlsum, fuse_rng) {
 	for (int i = 0; i < 100; i++) {
 		test_rlsum_tb_rng<IntValQuery2>(i);
@@ -68,6 +68,10 @@ public:
 	double sum(uint32_t pos) const;
 	double sqrsum(uint32_t pos) const;
 
+	/** \brief computes sum(pos), sqrsum(pos) and countnz(pos) with a single interval
+	lookup (and a single decoding pass for both sums). Any output can be NULL. */
+	void prefix_stats(uint32_t pos, double* psum, double* psqrsum, unsigned int* pcov) const;
+
 	void save(mscds::OutArchive& ar) const;
 	void load(mscds::InpArchive& ar);
 
@@ -113,6 +117,7 @@ public:
 
 	IntervalInfo range_at(unsigned int i) const;
 
+	/// enumerates the intervals, the values are decoded sequentially
 	class Enum {
 	public:
 		bool hasNext();
@@ -121,8 +126,31 @@ public:
 		friend class IntValQueryG;
 		const IntValQueryG * ptr;
 		size_t i;
+		typename IVS::Enum ve;
 	};
 	void getEnum(unsigned int idx, Enum* e) const;
+
+	/** \brief computes the prefix statistics (sum, sqrsum, countnz) at non-decreasing
+	positions by walking the intervals forward. Only the first position needs a
+	random access, each next step costs amortized O(1) per passed interval. */
+	class PrefixCursor {
+	public:
+		PrefixCursor(): ptr(NULL) {}
+		/** moves the cursor forward to `pos` (must not be less than position()) */
+		void advance(uint32_t pos);
+		uint32_t position() const { return cur; }
+		double sum, sqrsum;
+		unsigned int coverage;
+	private:
+		friend class IntValQueryG;
+		const IntValQueryG * ptr;
+		uint32_t cur;
+		size_t idx;
+		bool loaded;
+		IntervalInfo iv;
+		typename IVS::Enum ve;
+	};
+	void getCursor(uint32_t pos, PrefixCursor* c) const;
 	//void inspect(const std::string& cmd, std::ostream& out) const;
 	typedef IntValBuilderG<IVS> BuilderTp;
 
@@ -248,6 +276,44 @@ double IntValQueryG<IVS>::sqrsum(uint32_t pos) const {
 	return sqrSum_intv(res.first, res.second);
 }
 
+template<typename IVS>
+void IntValQueryG<IVS>::prefix_stats(uint32_t pos, double* psum, double* psqrsum, unsigned int* pcov) const {
+	double sm = 0, sq = 0;
+	unsigned int cov = 0;
+	if (pos > 0) {
+		auto res = data.itv.find_cover(pos - 1);
+		if (res.first != 0 || res.second != 0) {
+			const unsigned int idx = res.first, leftpos = res.second;
+			if (pcov) cov = data.itv.int_psrlen(idx) + leftpos;
+			if (psum || psqrsum) {
+				size_t r = idx % rate;
+				size_t p = idx / rate;
+				size_t base = p * rate;
+				if (psum) sm = data.get_sumq(p);
+				if (psqrsum) sq = data.get_sqrsum(p);
+				typename IVS::Enum e;
+				if (r > 0 || leftpos > 0) {
+					data.getEnum(base, &e);
+					for (size_t i = 0; i < r; ++i) {
+						double v = e.next();
+						double l = data.itv.int_len(base + i);
+						sm += l * v;
+						sq += l * (v * v);
+					}
+				}
+				if (leftpos > 0) {
+					double v = e.next();
+					sm += v * leftpos;
+					sq += (v * v) * leftpos;
+				}
+			}
+		}
+	}
+	if (psum) *psum = sm;
+	if (psqrsum) *psqrsum = sq;
+	if (pcov) *pcov = cov;
+}
+
 template<typename IVS>
 double IntValQueryG<IVS>::range_value(unsigned int idx) const {
 	return data.get_val(idx);
@@ -330,6 +396,45 @@ template<typename IVS>
 void IntValQueryG<IVS>::getEnum(unsigned int idx, typename IntValQueryG<IVS>::Enum *e) const {
 	e->ptr = this;
 	e->i = idx;
+	if (idx < length())
+		data.getEnum(idx, &(e->ve));
+}
+
+template<typename IVS>
+void IntValQueryG<IVS>::getCursor(uint32_t pos, typename IntValQueryG<IVS>::PrefixCursor *c) const {
+	c->ptr = this;
+	c->cur = pos;
+	prefix_stats(pos, &(c->sum), &(c->sqrsum), &(c->coverage));
+	// the first interval that does not end before `pos'
+	c->idx = data.itv.find_cover(pos).first;
+	c->loaded = false;
+	if (c->idx < length())
+		data.getEnum(c->idx, &(c->ve));
+}
+
+template<typename IVS>
+void IntValQueryG<IVS>::PrefixCursor::advance(uint32_t pos) {
+	assert(pos >= cur);
+	while (true) {
+		if (!loaded) {
+			if (idx >= ptr->length()) break;
+			auto x = ptr->data.itv.int_startend(idx);
+			iv = IntervalInfo(x.first, x.second, ve.next());
+			loaded = true;
+		}
+		if (iv.st >= pos) break;
+		uint32_t a = std::max<uint32_t>(iv.st, cur), b = std::min<uint32_t>(iv.ed, pos);
+		if (a < b) {
+			double l = b - a;
+			sum += l * iv.val;
+			sqrsum += l * (iv.val * iv.val);
+			coverage += b - a;
+		}
+		if (iv.ed > pos) break;
+		loaded = false;
+		++idx;
+	}
+	cur = pos;
 }
 
 template<typename IVS>
@@ -339,7 +444,8 @@ bool app_ds::IntValQueryG<IVS>::Enum::hasNext() {
 
 template<typename IVS>
 typename IntValQueryG<IVS>::IntervalInfo IntValQueryG<IVS>::Enum::next() {
-	return ptr->range_at(i++);
+	auto x = ptr->data.itv.int_startend(i++);
+	return IntervalInfo(x.first, x.second, ve.next());
 }
 
 typedef IntValBuilderG<Storage> IntValBuilder2;
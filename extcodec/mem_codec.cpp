@@ -74,6 +74,14 @@ bool ZlibCodec::uncompress_c(const char* compressed, size_t compressed_length, s
 
 ZlibCodec::ZlibCodec() {}
 
+size_t RansCodec::compress_c(const char* input, size_t input_length, std::string* output) const {
+	return rans.compress((const uint8_t*) input, input_length, output);
+}
+
+bool RansCodec::uncompress_c(const char* compressed, size_t compressed_length, std::string* uncompressed) const {
+	return rans.decompress((const uint8_t*) compressed, compressed_length, uncompressed);
+}
+
 
 
 }//namespace
@@ -2,6 +2,8 @@
 
 #include <string>
 
+#include "codec/rans_block.h"
+
 /** 
 \file
 
@@ -35,5 +37,15 @@ public:
 private:
 };
 
+/// order-0 entropy coder with interleaved rANS states (see codec/rans_block.h), no external library
+class RansCodec : public MemoryCodecMethod {
+public:
+	explicit RansCodec(unsigned int ways = 8): rans(ways) {}
+	size_t compress_c(const char* input, size_t input_length, std::string* output) const;
+	bool uncompress_c(const char* compressed, size_t compressed_length, std::string* uncompressed) const;
+private:
+	coder::RansBlockCodec rans;
+};
+
 
 }//namespace
\ No newline at end of file
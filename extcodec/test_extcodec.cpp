@@ -37,6 +37,20 @@ TEST(extcodec, zlib) {
 		testcd<ZlibCodec>(generate_str(512));
 }
 
+TEST(extcodec, rans) {
+	testcd<RansCodec>("Hello world");
+	testcd<RansCodec>(generate_str(10));
+	testcd<RansCodec>(generate_str(100));
+	for (unsigned int i = 0; i < 100; i++)
+		testcd<RansCodec>(generate_str(512));
+	RansCodec cd(32);
+	string inp(100000, 'a'), out, uc;
+	for (size_t i = 0; i < inp.size(); i += 7) inp[i] = 'b' + i % 5;
+	ASSERT_TRUE(cd.compress(inp, &out) < inp.size() / 2);
+	ASSERT_TRUE(cd.uncompress(out, &uc));
+	ASSERT_EQ(inp, uc);
+}
+
 
 int main(int argc, char* argv[]) {
 	//::testing::GTEST_FLAG(filter) = "";
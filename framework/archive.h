@@ -50,7 +50,9 @@ public:
 	virtual OutArchive& var(const char*) { return *this; }
 	virtual OutArchive& annotate(const std::string&) { return * this; }
 
-	/// starts a class
+	/** \brief starts a class. The file archives store a 16-bit tag of the name; a
+	`version' above 1 is stored as the complemented tag followed by the version byte,
+	versions 0 and 1 keep the original layout (readable by older builds) */
 	virtual OutArchive& startclass(const std::string&, unsigned char version = 1) { return *this;  };
 	virtual OutArchive& endclass() { return *this; };
 	
@@ -92,7 +94,8 @@ public:
 	virtual InpArchive& var(const std::string&) { return *this; }
 	virtual InpArchive& var(const char*) { return *this; }
 
-	/// starts a class scope
+	/** \brief starts a class scope, returns the version given to startclass() if it
+	is above 1, or 0 for the classes saved with version 0/1 (and all older archives) */
 	virtual unsigned char loadclass(const std::string& name) { return 0; };
 	virtual InpArchive& endclass() { return *this; };
 
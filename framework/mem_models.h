@@ -174,6 +174,8 @@ public:
 
 	size_t size() const { return _impl->size(); }
 	void close() { if (_impl != nullptr) { _impl->close(); _impl = nullptr; } }
+	/// returns true if the pointer does not refer to any region
+	bool is_null() const { return _impl == nullptr; }
 
 	bool is_unique_ref() const { return _ref->is_unique_ref() && _ref.unique(); }
 
@@ -115,8 +115,9 @@ public:
 		assert(UNIT_BIT_SIZE == ubs);
 		size_t n = VByteStream::extract(b, ipos);
 		blkcnt = VByteStream::extract(b, ipos);
-		for (unsigned int i = 0; i < n; ++i)
-			_sizes.push_back(VByteStream::extract(b, ipos));
+		size_t old = _sizes.size();
+		_sizes.resize(old + n);
+		VByteStream::extract_n(b, ipos, n, _sizes.data() + old);
 		ps_sz.resize(_sizes.size() + 1);
 		ps_sz[0] = 0;
 		for (size_t i = 1; i <= _sizes.size(); ++i)
@@ -4,6 +4,7 @@
 #include "intarray/sdarray.h"
 #include "intarray/sdarray_sml.h"
 #include "intarray/sdarray_th.h"
+#include "intarray/sdarray_pef.h"
 #include "intarray/sdarray_zero.h"
 #include "fused_sdarray_test.h"
 #include "sdarray_blk_hints.h"
@@ -35,6 +36,7 @@ struct StmFix : public SharedFixtureItf {
 		SDArraySmlBuilder bd2;
 		tests::TwoSDA_Builder xd;
 		SDArrayTHBuilder thb;
+		SDArrayPEFBuilder pefb;
 		SDRankSelectBuilderSml srsb;
 
 		LiftStBuilder<SLG_Builder> dbd2;
@@ -62,6 +64,7 @@ struct StmFix : public SharedFixtureItf {
 			bd2.add(val);
 			xd.add(val, val);
 			thb.add(val);
+			pefb.add(val);
 			zero.add(val);
 			srsb.add(val);
 			rfsgbdx.add(val);
@@ -79,6 +82,7 @@ struct StmFix : public SharedFixtureItf {
 		bd2.build(&sd2);
 		xd.build(&qs);
 		thb.build(&th);
+		pefb.build(&pef);
 		srsb.build(&lkz);
 		fsgbd.check_end_data();
 		fsgbd.build(&fuse_single);
@@ -115,7 +119,7 @@ struct StmFix : public SharedFixtureItf {
 		}
 	}
 
-	void TearDown() { vals.clear(); sd1.clear(); sd2.clear(); qs.clear(); th.clear(); zero.clear(); lkz.clear(); fuse_single.clear(); }
+	void TearDown() { vals.clear(); sd1.clear(); sd2.clear(); qs.clear(); th.clear(); pef.clear(); zero.clear(); lkz.clear(); fuse_single.clear(); }
 
 	unsigned size, qsize;
 	std::vector<unsigned> vals;
@@ -126,6 +130,7 @@ struct StmFix : public SharedFixtureItf {
 	SDArraySml sd2;
 	tests::TwoSDA_Query qs;
 	SDArrayTH th;
+	SDArrayPEF pef;
 
 	SDArrayZero zero;
 	SDRankSelectSml lkz;
@@ -142,6 +147,7 @@ struct StmFix : public SharedFixtureItf {
 		std::cout << "sda_b512" << "\t" << estimate_data_size(sd2) << std::endl;
 		std::cout << "sda_hints" << "\t" << estimate_data_size(lkz) << std::endl;
 		std::cout << "sda_th" << "\t" << estimate_data_size(th) << std::endl;
+		std::cout << "sda_pef" << "\t" << estimate_data_size(pef) << std::endl;
 
 		std::cout << "sda_fusion(2)" << "\t" << estimate_data_size(qs.mng) << std::endl;
 		std::cout << "sda_one_fuse" << "\t" << estimate_data_size(fuse_single) << std::endl;
@@ -151,6 +157,7 @@ struct StmFix : public SharedFixtureItf {
 		std::cout << "> Components sizes (optional)" << std::endl;
 		sd2.inspect("comp_size", std::cout);
 		th.inspect("comp_size", std::cout);
+		pef.inspect("comp_size", std::cout);
 		TearDown();
 	}
 };
@@ -224,6 +231,14 @@ void sda_th(StmFix * fix) {
 	}
 }
 
+void sda_pef(StmFix * fix) {
+	unsigned vx = 121;
+	std::vector<unsigned int> * qs = fix->queries;
+	for (unsigned i = 0; i < fix->qsize; ++i) {
+		vx ^= fix->pef.lookup((*qs)[i]);
+	}
+}
+
 void sda_dual(StmFix * fix) {
 	auto& x = fix->dualsda.g<0>().start;
 	unsigned vx = 121;
@@ -301,6 +316,14 @@ void sda_th_rank(StmFix * fix) {
 	}
 }
 
+void sda_pef_rank(StmFix * fix) {
+	unsigned vx = 131;
+	std::vector<unsigned int> * qs = fix->queries;
+	for (unsigned i = 0; i < fix->qsize; ++i) {
+		vx ^= fix->pef.rank((*qs)[i]);
+	}
+}
+
 void sda_hints_rank(StmFix * fix) {
 	unsigned vx = 131;
 	std::vector<unsigned int> * qs = fix->queries;
@@ -323,6 +346,38 @@ void sda_dual_rank(StmFix * fix) {
 
 static const unsigned int RANDSEED = 3571;
 
+void sda_512_scan_enum(StmFix * fix) {
+	uint64_t vx = 121;
+	SDArraySml::PSEnum e;
+	fix->sd2.getPSEnum(0, &e);
+	for (unsigned i = 0; i < fix->size; ++i)
+		vx ^= e.next();
+}
+
+void sda_512_scan_bulk(StmFix * fix) {
+	uint64_t vx = 121;
+	const unsigned int BUF = 4096;
+	uint64_t buf[BUF];
+	for (unsigned i = 0; i < fix->size; i += BUF) {
+		unsigned n = std::min<unsigned>(BUF, fix->size - i);
+		fix->sd2.decode_ps(i, n, buf);
+		for (unsigned j = 0; j < n; ++j)
+			vx ^= buf[j];
+	}
+}
+
+BENCHMARK_SET(sdarray_scan_benchmark) {
+	srand(RANDSEED);
+	Benchmarker<StmFix> bm;
+	bm.n_samples = 3;
+	auto n = StmFix::SIZE;
+	bm.add_remark("input_length: " + utils::tostr(n));
+	bm.add("sda_b512_enum_scan", sda_512_scan_enum, 5);
+	bm.add("sda_b512_bulk_scan", sda_512_scan_bulk, 5);
+	bm.run_all();
+	bm.report(0); // <-- baseline
+}
+
 BENCHMARK_SET(size_report) {
 	srand(RANDSEED);
 	StmFix x;
@@ -341,6 +396,7 @@ BENCHMARK_SET(sdarray_rnd_benchmark) {
 	bm.add("sda_b64_rnd_access", sda_64, 15);
 	bm.add("sda_b512_rnd_access", sda_512, 15);
 	bm.add("sda_th_rnd_access", sda_fuse1, 15);
+	bm.add("sda_pef_rnd_access", sda_pef, 15);
 
 	bm.add("sda_fuse0_rnd_access", sda_fuse0, 15);
 	bm.add("sda_fuse1_rnd_access", sda_fuse1, 15);
@@ -364,6 +420,7 @@ BENCHMARK_SET(sdarray_seq_benchmark) {
 	bm.add("sda_b64_seq_access", sda_64, 15);
 	bm.add("sda_b512_seq_access", sda_512, 15);
 	bm.add("sda_th_seq_access", sda_th, 15);
+	bm.add("sda_pef_seq_access", sda_pef, 15);
 
 	bm.add("sda_fuse0_seq_access", sda_fuse0, 15);
 	bm.add("sda_fuse1_seq_access", sda_fuse1, 15);
@@ -389,6 +446,7 @@ BENCHMARK_SET(sdarray_rnd_rank_benchmark) {
 	bm.add("sda_b512_rnd_rank", sda_512_rank, 15);
 	bm.add("sda_b512hints_rnd_rank", sda_hints_rank, 15);
 	bm.add("sda_th_rnd_rank", sda_th_rank, 15);
+	bm.add("sda_pef_rnd_rank", sda_pef_rank, 15);
 
 	bm.add("sda_fuse0_rnd_rank", sda_fuse0_rank, 15);
 	bm.add("sda_fuse1_rnd_rank", sda_fuse1_rank, 15);
@@ -415,6 +473,7 @@ BENCHMARK_SET(sdarray_seq_rank_benchmark) {
 	bm.add("sda_b512_seq_rank", sda_512_rank, 15);
 	bm.add("sda_b512hints_seq_rank", sda_hints_rank, 15);
 	bm.add("sda_th_seq_rank", sda_th_rank, 15);
+	bm.add("sda_pef_seq_rank", sda_pef_rank, 15);
 
 	bm.add("sda_fuse0_seq_rank", sda_fuse0_rank, 15);
 	bm.add("sda_fuse1_seq_rank", sda_fuse1_rank, 15);
@@ -14,6 +14,11 @@ Array of integers that uses some generic compression method.
 
   CodeModelBlk<Model>, CodeModelBuilder<Model>: the array 
 
+  The decoded big-blocks (their models) are kept in a bounded cache that is
+  safe to query from several threads (utils::ShardedCache: shards guarded by
+  their own mutex and managed by a CLOCK policy). Blocks are held by shared
+  pointers so an evicted block stays valid for the enumerators using it.
+
 */
 
 #include <utility>
@@ -23,12 +28,14 @@ Array of integers that uses some generic compression method.
 #include <map>
 #include <unordered_set>
 #include <memory>
+#include <ostream>
+#include <algorithm>
 
 #include "sdarray_sml.h"
 #include "bitarray/bitarray.h"
 #include "bitarray/bitstream.h"
 #include "utils/utils.h"
-//#include "utils/mm/cache_map.hpp"
+#include "utils/cache_table.h"
 
 namespace mscds {
 
@@ -36,6 +43,13 @@ namespace mscds {
 template<typename Model>
 class CodeModelArray;
 
+/** decodes `n' values of a block, models with a faster bulk decoder overload this */
+template<typename Model>
+inline void decode_model_n(const Model& m, IWBitStream * is, uint64_t * out, size_t n) {
+	for (size_t i = 0; i < n; ++i)
+		out[i] = m.decode(is);
+}
+
 /* two layers pointer model */
 struct PointerModel {
 	inline unsigned int p0(unsigned int pos) const { return pos / (rate1 * rate2); }
@@ -99,7 +113,12 @@ class CodeModelArray {
 public:
 	typedef std::shared_ptr<const CodeModelBlk<Model> > BlkPtr; 
 
-	CodeModelArray() {}
+	CodeModelArray(): cache(CACHE_SHARDS) { set_cache_size(DEFAULT_CACHE_SIZE); }
+	/** \brief sets the maximum number of decoded blocks kept in memory (drops the cached blocks) */
+	void set_cache_size(unsigned int cache_size);
+	/** \brief numbers of block requests answered from the cache / that decoded a block */
+	uint64_t cache_hits() const;
+	uint64_t cache_misses() const;
 	void load(InpArchive& ar);
 	void save(OutArchive& ar) const;
 	void clear();
@@ -112,7 +131,10 @@ public:
 		Enum() {}
 		bool hasNext() const { return pos < data->ptr.len;}
 		uint64_t next();
+		/** \brief decodes the next `n' values to `out' */
+		void decode_n(uint64_t * out, size_t n);
 	private:
+		void enter_block();
 		unsigned int pos;
 		IWBitStream is;
 		BlkPtr blk;
@@ -121,9 +143,14 @@ public:
 	};
 	void getEnum(unsigned int pos, Enum * e) const;
 	typedef CodeModelBuilder<Model> BuilderTp;
+	/** prints the model of each block, or the cache statistics if `cmd' is "cache" */
 	void inspect(const std::string& cmd, std::ostream& out) const;
+
+	static const unsigned int DEFAULT_CACHE_SIZE = 64;
+	static const unsigned int CACHE_SHARDS = 8;
 private:
-	mutable std::unordered_map<unsigned int, BlkPtr > blkcache;
+	/// decoded blocks, a copy of the array starts with an empty cache of the same size
+	mutable utils::ShardedCache<CodeModelBlk<Model> > cache;
 
 	BlkPtr getBlk(unsigned int blk) const;
 
@@ -257,18 +284,29 @@ template<typename Model>
 CodeModelBuilder<Model>::~CodeModelBuilder() 
 { out.close(); }
 
+template<typename Model>
+const unsigned int CodeModelArray<Model>::DEFAULT_CACHE_SIZE;
+template<typename Model>
+const unsigned int CodeModelArray<Model>::CACHE_SHARDS;
+
+template<typename Model>
+void CodeModelArray<Model>::set_cache_size(unsigned int cache_size) {
+	cache.resize(cache_size);
+}
+
+template<typename Model>
+uint64_t CodeModelArray<Model>::cache_hits() const {
+	return cache.hits();
+}
+
+template<typename Model>
+uint64_t CodeModelArray<Model>::cache_misses() const {
+	return cache.misses();
+}
+
 template<typename Model>
 typename CodeModelArray<Model>::BlkPtr CodeModelArray<Model>::getBlk(unsigned int b) const {
-	auto it = blkcache.find(b);
-	if (it != blkcache.end()) {
-		return it->second;
-	}else {
-		CodeModelBlk<Model> * bx = new CodeModelBlk<Model>();
-		bx->mload(&ptr, b);
-		BlkPtr blk = BlkPtr(bx);
-		blkcache.insert(make_pair(b, blk));
-		return blk;
-	}
+	return cache.get(b, [&](CodeModelBlk<Model>& bx) { bx.mload(&ptr, b); });
 }
 
 template<typename Model>
@@ -286,25 +324,55 @@ void CodeModelArray<Model>::getEnum(unsigned int pos, Enum * e) const {
 	e->blk->set_stream(pos, e->is);
 }
 
+template<typename Model>
+void CodeModelArray<Model>::Enum::enter_block() {
+	// the next block is fetched when its first value is read, so a lookup of
+	// the last value of a block does not decode the following block
+	auto bs = data->ptr.rate1 * data->ptr.rate2;
+	if (pos % bs == 0 && blk->get_blkid() != pos / bs) {
+		blk = data->getBlk(pos / bs);
+		blk->set_stream(pos, is);
+	}
+}
+
 template<typename Model>
 uint64_t CodeModelArray<Model>::Enum::next() {
+	enter_block();
 	auto val = blk->getModel().decode(&is);
 	++pos;
-	if (pos < data->ptr.len) {
-		auto bs = data->ptr.rate1 * data->ptr.rate2;
-		if (pos % bs == 0) {
-			blk = data->getBlk(pos / bs);
-			blk->set_stream(pos, is);
-		}
-	}
 	return val;
 }
 
+template<typename Model>
+void CodeModelArray<Model>::Enum::decode_n(uint64_t * out, size_t n) {
+	assert(pos + n <= data->ptr.len);
+	const size_t bs = data->ptr.rate1 * data->ptr.rate2;
+	while (n > 0) {
+		enter_block();
+		size_t m = std::min<size_t>(n, bs - pos % bs);
+		decode_model_n(blk->getModel(), &is, out, m);
+		pos += m;
+		out += m;
+		n -= m;
+	}
+}
+
 template<typename Model>
 void mscds::CodeModelArray<Model>::inspect(const std::string& cmd, std::ostream& out) const {
+	if (cmd == "cache") {
+		out << "block_cache" << '\n';
+		out << "capacity: " << cache.capacity() << '\n';
+		out << "size: " << cache.size() << '\n';
+		out << "hits: " << cache_hits() << '\n';
+		out << "misses: " << cache_misses() << '\n';
+		return;
+	}
+	// reads the blocks directly to keep the cache untouched
 	unsigned int i = 0, p = 0;
 	while (i < ptr.len) {
-		getBlk(p)->getModel().inspect(cmd, out);
+		CodeModelBlk<Model> blk;
+		blk.mload(&ptr, p);
+		blk.getModel().inspect(cmd, out);
 		i += ptr.rate1 * ptr.rate2;
 		p += 1;
 	}
@@ -342,13 +410,13 @@ void CodeModelArray<Model>::load(InpArchive& ar) {
 	ptr.ptr.load(ar.var("pointers"));
 	ptr.bits.load(ar.var("bits"));
 	ar.endclass();
-	blkcache.clear();
+	cache.reset();
 }
 
 template<typename Model>
 void CodeModelArray<Model>::clear() {
 	ptr.clear();
-	blkcache.clear();
+	cache.reset();
 }
 
 template<typename Model>
@@ -59,6 +59,14 @@ namespace mscds {
 		return c.first - 1;
 	}
 
+	void DeltaCodeArr::Enum::decode_n(uint64_t * out, size_t n) {
+		for (size_t i = 0; i < n; ++i) {
+			coder::CodePr x = coder::DeltaCoder::decode2(is.peek());
+			is.skipw(x.second);
+			out[i] = x.first - 1;
+		}
+	}
+
 	uint64_t DeltaCodeArr::lookup(uint64_t pos) const {
 		Enum e;
 		getEnum(pos, &e);
@@ -63,6 +63,8 @@ public:
 		Enum(const Enum& o): is(o.is), c(o.c) {}
 		bool hasNext() const;
 		uint64_t next();
+		/** \brief decodes the next `n' values to `out' */
+		void decode_n(uint64_t * out, size_t n);
 	private:
 		mscds::IWBitStream is;
 		coder::DeltaCoder dc;
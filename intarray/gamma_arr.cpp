@@ -55,6 +55,8 @@ void GammaArray::getEnum(unsigned int pos, Enum * e) const {
 	e->lpos = upper.prefixsum(pos);
 	upper.getEnum(pos, &(e->e));
 	e->lower = &lower;
+	e->arr = this;
+	e->pos = pos;
 }
 
 void GammaArray::inspect(const std::string& cmd, std::ostream& out) const
@@ -68,11 +70,28 @@ uint64_t GammaArray::Enum::next()
 	unsigned int len = e.next();
 	uint64_t val = lower->bits(lpos, len);
 	lpos += len;
+	++pos;
 	return (val | (1ULL << len)) - 1;
 }
 
+void GammaArray::Enum::decode_n(uint64_t * out, size_t n) {
+	assert(pos + n <= arr->length());
+	if (n == 0) return;
+	// the lengths are written to `out' first and replaced by the values
+	arr->upper.decode(pos, n, out);
+	for (size_t i = 0; i < n; ++i) {
+		unsigned int len = (unsigned int) out[i];
+		uint64_t val = lower->bits(lpos, len);
+		lpos += len;
+		out[i] = (val | (1ULL << len)) - 1;
+	}
+	pos += n;
+	if (pos < arr->length())
+		arr->upper.getEnum(pos, &e);
+}
+
 bool GammaArray::Enum::hasNext() const {
-	return e.hasNext();
+	return pos < arr->length();
 }
 
 
@@ -42,11 +42,16 @@ public:
 		Enum(const Enum& o) {}
 		bool hasNext() const;
 		uint64_t next();
+		/** \brief decodes the next `n' values to `out', the code lengths are
+		decoded in bulk from the SDArraySml */
+		void decode_n(uint64_t * out, size_t n);
 	private:
 		friend class GammaArray;
 		SDArraySml::Enum e;
 		unsigned int lpos;
 		const BitArray * lower;
+		const GammaArray * arr;
+		uint64_t pos;
 	};
 	void getEnum(unsigned int pos, Enum * e) const;
 	void inspect(const std::string& cmd, std::ostream& out) const;
@@ -169,6 +169,27 @@ uint32_t HuffmanModel::decode(IWBitStream * is) const {
 	return val;
 }
 
+void HuffmanModel::decode_n(IWBitStream * is, uint64_t * out, size_t n) const {
+	size_t k = 0;
+	if (freq.size() == 0) {
+		for (; k < n; ++k) out[k] = decode(is);
+		return;
+	}
+	while (k < n) {
+		const coder::HuffmanByteDec::MultiEntry& e = tc.decode_multi(is->peek());
+		unsigned int i = 0, used = 0;
+		for (; i < e.n && k < n; ++i) {
+			if (e.sym[i] == 0) break; // escape, a delta code follows
+			out[k++] = freq[e.sym[i] - 1];
+			used += e.len[i];
+		}
+		is->skipw(used);
+		// the first code is longer than the table or is an escape
+		if (k < n && (e.n == 0 || i < e.n))
+			out[k++] = decode(is);
+	}
+}
+
 void HuffmanModel::clear() {
 	freq.clear();
 	freqset.clear();
@@ -42,6 +42,8 @@ public:
 
 	void encode(uint32_t val, OBitStream * out) const;
 	uint32_t decode(IWBitStream * is) const;
+	/** decodes the next `n' values, up to 3 short codes are decoded per table lookup */
+	void decode_n(IWBitStream * is, uint64_t * out, size_t n) const;
 	void inspect(const std::string& cmd, std::ostream& out) const;
 private:
 	void buildModel_cnt(unsigned int n, const std::unordered_map<uint32_t, unsigned int> & cnt, unsigned int max_symbol_size);
@@ -61,6 +63,11 @@ REGISTER_PARSE_TYPE(mscds::HuffmanModel);
 
 namespace mscds {
 
+/// bulk decoding of CodeModelArray<HuffmanModel> blocks
+inline void decode_model_n(const HuffmanModel& m, IWBitStream * is, uint64_t * out, size_t n) {
+	m.decode_n(is, out, n);
+}
+
 typedef CodeModelArray<HuffmanModel> HuffmanArray;
 typedef CodeModelBuilder<HuffmanModel> HuffmanArrBuilder;
 
@@ -8,6 +8,9 @@
 #include "runlen.h"
 #include "utils/utest.h"
 #include <vector>
+#include <sstream>
+#include <thread>
+#include <atomic>
 
 namespace tests {
 
@@ -240,6 +243,92 @@ TEST(HuffArray, testsuite) {
 }
 
 
+template<typename QueryTp, typename BuilderTp>
+void check_decode_n(const std::vector<unsigned int>& exp, const Config* conf = NULL) {
+	BuilderTp bd;
+	bd.init(conf);
+	for (unsigned int v : exp)
+		bd.add(v);
+	QueryTp qs;
+	bd.build(&qs);
+	std::vector<uint64_t> out(exp.size());
+	typename QueryTp::Enum e;
+	qs.getEnum(0, &e);
+	e.decode_n(out.data(), exp.size());
+	for (size_t i = 0; i < exp.size(); ++i)
+		ASSERT_EQ(exp[i], out[i]) << "i = " << i;
+	ASSERT_FALSE(e.hasNext());
+	for (int k = 0; k < 200; ++k) {
+		size_t st = rand() % exp.size(), n = rand() % (exp.size() - st + 1);
+		size_t m = rand() % (exp.size() - st - n + 1);
+		qs.getEnum(st, &e);
+		e.decode_n(out.data(), n);
+		for (size_t i = 0; i < n; ++i)
+			ASSERT_EQ(exp[st + i], out[i]) << "i = " << st + i;
+		// decode_n and next() can be mixed
+		for (size_t i = 0; i < m; ++i)
+			ASSERT_EQ(exp[st + n + i], e.next());
+		ASSERT_EQ(st + n + m < exp.size(), e.hasNext());
+	}
+}
+
+TEST(codearr, decode_n) {
+	Config conf;
+	conf.add("SAMPLE_RATE", "16");
+	conf.add("BLOCK_RATE", "10");
+	std::vector<unsigned int> vec;
+	for (int i = 0; i < 3; ++i) {
+		vec = gen_rand(5000, 0, i == 0 ? 20 : 1000);
+		check_decode_n<GammaArray, GammaArrayBuilder>(vec);
+		check_decode_n<DeltaCodeArr, DeltaCodeArrBuilder>(vec);
+		check_decode_n<HuffmanArray, HuffmanArrBuilder>(vec);
+		check_decode_n<HuffmanArray, HuffmanArrBuilder>(vec, &conf);
+		check_decode_n<RemapDtArray, RemapDtArrayBuilder>(vec, &conf);
+	}
+	vec = gen_zerosones(3000);
+	check_decode_n<HuffmanArray, HuffmanArrBuilder>(vec, &conf);
+}
+
+TEST(HuffArray, block_cache) {
+	std::vector<unsigned int> vec = gen_rand(40000, 0, 300);
+	Config conf;
+	conf.add("SAMPLE_RATE", "16");
+	conf.add("BLOCK_RATE", "25"); // 100 big-blocks
+	HuffmanArrBuilder bd;
+	bd.init(&conf);
+	for (unsigned int v : vec)
+		bd.add(v);
+	HuffmanArray qs;
+	bd.build(&qs);
+	qs.set_cache_size(16);
+	for (int k = 0; k < 3000; ++k) {
+		unsigned int i = rand() % vec.size();
+		ASSERT_EQ(vec[i], qs.lookup(i));
+	}
+	ASSERT_EQ(3000u, qs.cache_hits() + qs.cache_misses());
+	std::ostringstream ss;
+	qs.inspect("cache", ss);
+	ASSERT_NE(std::string::npos, ss.str().find("capacity: 16"));
+	ASSERT_NE(std::string::npos, ss.str().find("size: 16"));
+
+	// concurrent random lookups and scans
+	std::atomic<unsigned int> errors(0);
+	std::vector<std::thread> thr;
+	for (unsigned int t = 0; t < 4; ++t)
+		thr.push_back(std::thread([&, t]() {
+			for (unsigned int k = 0; k < 3000; ++k) {
+				unsigned int i = (k * 7919 + t * 104729) % vec.size();
+				if (vec[i] != qs.lookup(i)) ++errors;
+			}
+			HuffmanArray::Enum e;
+			qs.getEnum(t * 1000, &e);
+			for (unsigned int i = t * 1000; i < vec.size(); ++i)
+				if (vec[i] != e.next()) ++errors;
+		}));
+	for (auto& th : thr) th.join();
+	ASSERT_EQ(0u, errors.load());
+}
+
 TEST(HuffDiffArray, testsuite) {
 	typedef HuffDiffArray QueryTp;
 	typedef HuffDiffArrBuilder BuilderTp;
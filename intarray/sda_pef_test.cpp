@@ -0,0 +1,144 @@
+
+#include "sdarray_pef.h"
+#include "sdarray_zero.h"
+#include "utils/utest.h"
+#include "mem/info_archive.h"
+
+#include <vector>
+#include <cstdlib>
+
+namespace tests {
+
+using namespace std;
+using namespace mscds;
+
+static void test_cmp(const std::vector<unsigned int>& vals) {
+	size_t len = vals.size();
+	SDArrayPEFBuilder bd;
+	SDArrayPEF arr;
+	SDArrayZero zero;
+	for (unsigned int i = 0; i < len; ++i) {
+		zero.add(vals[i]);
+		bd.add(vals[i]);
+	}
+	bd.build(&arr);
+	ASSERT_EQ(len, arr.length());
+	ASSERT_EQ(zero.total(), arr.total());
+
+	for (unsigned int i = 0; i < len; ++i) {
+		ASSERT_EQ(vals[i], arr.lookup(i));
+		ASSERT_EQ(zero.prefixsum(i), arr.prefixsum(i));
+		uint64_t ps;
+		arr.lookup(i, ps);
+		ASSERT_EQ(zero.prefixsum(i), ps);
+	}
+	ASSERT_EQ(zero.prefixsum(len), arr.prefixsum(len));
+	auto last = zero.prefixsum(len);
+	for (unsigned int p = 0; p <= last; ++p)
+		ASSERT_EQ(zero.rank(p), arr.rank(p));
+
+	SDArrayPEF::Enum e;
+	for (unsigned int st = 0; st < len; st += 97) {
+		arr.getEnum(st, &e);
+		for (unsigned int i = st; i < len; ++i) {
+			ASSERT_TRUE(e.hasNext());
+			ASSERT_EQ(vals[i], e.next());
+		}
+		ASSERT_FALSE(e.hasNext());
+	}
+}
+
+// mixes sparse, dense, constant and zero regions so that every chunk type is used
+static std::vector<unsigned int> mixed_vals(size_t len) {
+	std::vector<unsigned int> vals;
+	while (vals.size() < len) {
+		size_t rlen = 1 + rand() % 700;
+		unsigned int type = rand() % 4;
+		unsigned int c = rand() % 5;
+		for (size_t i = 0; i < rlen && vals.size() < len; ++i) {
+			if (type == 0) vals.push_back(rand() % 2);
+			else if (type == 1) vals.push_back(rand() % 200);
+			else if (type == 2) vals.push_back(c);
+			else vals.push_back(0);
+		}
+	}
+	return vals;
+}
+
+TEST(sdarray_pef, small) {
+	for (unsigned int k = 0; k < 500; ++k) {
+		size_t len = 1 + rand() % 300;
+		std::vector<unsigned int> vals;
+		for (unsigned int i = 0; i < len; ++i)
+			vals.push_back(rand() % 20);
+		test_cmp(vals);
+	}
+}
+
+TEST(sdarray_pef, mixed) {
+	for (unsigned int k = 0; k < 10; ++k)
+		test_cmp(mixed_vals(20000));
+}
+
+TEST(sdarray_pef, constant) {
+	test_cmp(std::vector<unsigned int>(5000, 0));
+	test_cmp(std::vector<unsigned int>(5000, 1));
+	test_cmp(std::vector<unsigned int>(3333, 7));
+}
+
+TEST(sdarray_pef, large_values) {
+	SDArrayPEFBuilder bd;
+	SDArrayPEF arr;
+	std::vector<uint64_t> vals;
+	for (unsigned int i = 0; i < 3000; ++i) {
+		uint64_t v = (i % 500 == 0) ? (1ull << 40) + rand() : rand() % 3;
+		vals.push_back(v);
+		bd.add(v);
+	}
+	bd.build(&arr);
+	uint64_t ps = 0;
+	for (unsigned int i = 0; i < vals.size(); ++i) {
+		ASSERT_EQ(ps, arr.prefixsum(i));
+		ASSERT_EQ(vals[i], arr.lookup(i));
+		ASSERT_LE(arr.rank(ps), i);
+		ASSERT_EQ(ps, arr.prefixsum(arr.rank(ps)));
+		if (vals[i] > 0) {
+			ASSERT_EQ(i + 1, arr.rank(ps + 1));
+		}
+		ps += vals[i];
+	}
+	ASSERT_EQ(ps, arr.total());
+}
+
+TEST(sdarray_pef, empty) {
+	SDArrayPEFBuilder bd;
+	SDArrayPEF arr;
+	bd.build(&arr);
+	ASSERT_EQ(0, arr.length());
+	ASSERT_EQ(0, arr.total());
+	ASSERT_EQ(0, arr.prefixsum(0));
+	ASSERT_EQ(0, arr.rank(0));
+}
+
+TEST(sdarray_pef, saveload) {
+	auto vals = mixed_vals(10000);
+	SDArrayPEFBuilder bd;
+	SDArrayPEF arr, arr2;
+	for (unsigned int i = 0; i < vals.size(); ++i)
+		bd.add(vals[i]);
+	bd.build(&arr);
+	OMemArchive out;
+	arr.save(out);
+	out.close();
+	IMemArchive inp(out);
+	arr2.load(inp);
+	inp.close();
+	ASSERT_EQ(arr.length(), arr2.length());
+	ASSERT_EQ(arr.total(), arr2.total());
+	for (unsigned int i = 0; i < vals.size(); ++i)
+		ASSERT_EQ(vals[i], arr2.lookup(i));
+	for (unsigned int p = 0; p <= arr.total(); p += 3)
+		ASSERT_EQ(arr.rank(p), arr2.rank(p));
+}
+
+}//namespace
@@ -704,6 +704,51 @@ TEST(sdatest_sml, rank4) {
 		}
 }
 
+TEST(sdatest_sml, parallel_build) {
+	for (unsigned int n : {0u, 100u, 512u, 5000u, 100000u}) {
+		vector<uint64_t> vals(n);
+		for (unsigned int i = 0; i < n; ++i)
+			vals[i] = (i % 100 == 0) ? rand() % 100000 : rand() % 100;
+		SDArraySmlBuilder bd;
+		for (auto v : vals) bd.add(v);
+		SDArraySml sda, sdp;
+		bd.build(&sda);
+		SDArraySmlBuilder::build_s(vals, &sdp, 4);
+		ASSERT_EQ(sda.length(), sdp.length());
+		ASSERT_EQ(sda.total(), sdp.total());
+		for (unsigned int i = 0; i <= n; ++i)
+			ASSERT_EQ(sda.prefixsum(i), sdp.prefixsum(i));
+		for (unsigned int i = 0; i < n; ++i)
+			ASSERT_EQ(sda.lookup(i), sdp.lookup(i));
+	}
+}
+
+TEST(sdatest_sml, bulk_decode) {
+	for (unsigned int n : {1u, 511u, 512u, 513u, 5000u, 20000u}) {
+		vector<uint64_t> vals(n);
+		for (unsigned int i = 0; i < n; ++i)
+			vals[i] = (i % 3 == 0) ? 0 : ((i % 100 == 0) ? rand() % 100000 : rand() % 100);
+		SDArraySmlBuilder bd;
+		for (auto v : vals) bd.add(v);
+		SDArraySml sda;
+		bd.build(&sda);
+		vector<uint64_t> out(n);
+		sda.decode_ps(0, n, out.data());
+		for (unsigned int i = 0; i < n; ++i)
+			ASSERT_EQ(sda.prefixsum(i + 1), out[i]);
+		sda.decode(0, n, out.data());
+		for (unsigned int i = 0; i < n; ++i)
+			ASSERT_EQ(vals[i], out[i]);
+		for (unsigned int k = 0; k < 50; ++k) {
+			size_t st = rand() % n;
+			size_t cnt = rand() % (n - st + 1);
+			sda.decode(st, cnt, out.data());
+			for (size_t i = 0; i < cnt; ++i)
+				ASSERT_EQ(vals[st + i], out[i]);
+		}
+	}
+}
+
 TEST(sdatest_sml, bug2) {
 	const int len = 495;
 	int inp[len] = {0, 1, 6, 8, 9, 12, 14, 15, 17, 18, 19, 20, 24, 25, 28, 31, 32, 35, 36, 37, 38, 39, 41, 46, 49, 50,
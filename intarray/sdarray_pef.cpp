@@ -0,0 +1,412 @@
+#include "sdarray_pef.h"
+#include "bitarray/bitop.h"
+
+#include <cassert>
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+namespace mscds {
+
+// estimated size (in bits) of the directory entry of one chunk
+static const uint64_t CHUNK_OVERHEAD = 32;
+// size and sampling rate of the select hints stored in front of an Elias-Fano chunk
+static const unsigned int HINT_WIDTH = 16;
+static const uint64_t HINT_RATE = 64;
+
+static inline uint64_t hint_count(uint64_t n) { return (n - 1) / HINT_RATE; }
+
+static inline unsigned int ef_width(uint64_t n, uint64_t u) {
+	return (u > n) ? msb_intr(u / n) : 0;
+}
+
+static inline uint64_t ef_cost(uint64_t n, uint64_t u) {
+	unsigned int l = ef_width(n, u);
+	return n * l + n + (u >> l) + HINT_WIDTH * hint_count(n);
+}
+
+SDArrayPEFBuilder::SDArrayPEFBuilder(): last(0) {}
+
+void SDArrayPEFBuilder::add(uint64_t val) {
+	vals.push_back(val);
+	last += val;
+}
+
+void SDArrayPEFBuilder::add_inc(uint64_t pos) {
+	assert(pos >= last);
+	add(pos - last);
+}
+
+uint64_t SDArrayPEFBuilder::current_sum() {
+	return last;
+}
+
+void SDArrayPEFBuilder::clear() {
+	vals.clear();
+	last = 0;
+}
+
+// optimal partition of the array into chunks with boundaries at multiples of
+// GRAIN (the end of the array is also a boundary), the cost of a chunk is the
+// smaller of the run (zero if all values are equal) and the Elias-Fano sizes
+void SDArrayPEFBuilder::partition(std::vector<size_t>& cuts) const {
+	const size_t grain = GRAIN;
+	const size_t m = vals.size();
+	const size_t nseg = (m + grain - 1) / grain;
+	const size_t maxseg = MAX_CHUNK / GRAIN;
+	std::vector<uint64_t> segsum(nseg), segval(nseg);
+	std::vector<bool> segconst(nseg);
+	for (size_t s = 0; s < nseg; ++s) {
+		size_t st = s * grain, ed = std::min(st + grain, m);
+		uint64_t sm = 0;
+		bool cst = true;
+		for (size_t i = st; i < ed; ++i) {
+			sm += vals[i];
+			if (vals[i] != vals[st]) cst = false;
+		}
+		segsum[s] = sm;
+		segval[s] = vals[st];
+		segconst[s] = cst;
+	}
+	std::vector<uint64_t> cost(nseg + 1, std::numeric_limits<uint64_t>::max());
+	std::vector<size_t> prev(nseg + 1, 0);
+	cost[0] = 0;
+	for (size_t t = 1; t <= nseg; ++t) {
+		const size_t ed = std::min(t * grain, m);
+		uint64_t u = 0;
+		bool cst = true;
+		for (size_t s = t; s > 0 && t - s < maxseg; --s) {
+			u += segsum[s - 1];
+			cst = cst && segconst[s - 1] && segval[s - 1] == segval[t - 1];
+			const uint64_t n = ed - (s - 1) * grain;
+			uint64_t c = cost[s - 1] + CHUNK_OVERHEAD + (cst ? 0 : ef_cost(n, u));
+			if (c < cost[t]) {
+				cost[t] = c;
+				prev[t] = s - 1;
+			}
+		}
+	}
+	cuts.clear();
+	for (size_t t = nseg; t > 0; t = prev[t])
+		cuts.push_back(std::min(t * grain, m));
+	cuts.push_back(0);
+	std::reverse(cuts.begin(), cuts.end());
+}
+
+// Elias-Fano chunk layout: [select hints of the elements HINT_RATE, 2*HINT_RATE, ...]
+// [lower bits] [upper bits in unary]
+void SDArrayPEFBuilder::encode_chunk(size_t st, size_t ed, OBitStream& bits, uint8_t& info) const {
+	const uint64_t n = ed - st;
+	uint64_t u = 0;
+	bool cst = true;
+	for (size_t i = st; i < ed; ++i) {
+		u += vals[i];
+		if (vals[i] != vals[st]) cst = false;
+	}
+	if (cst) {
+		info = SDArrayPEF::RUN_CHUNK;
+		return;
+	}
+	const unsigned int l = ef_width(n, u);
+	info = l;
+	std::vector<uint64_t> x(n);
+	uint64_t ps = 0;
+	for (size_t k = 0; k < n; ++k) {
+		ps += vals[st + k];
+		x[k] = ps;
+	}
+	for (size_t k = HINT_RATE; k < n; k += HINT_RATE) {
+		uint64_t hp = (x[k] >> l) + k;
+		assert(hp < (1ull << HINT_WIDTH));
+		bits.puts(hp, HINT_WIDTH);
+	}
+	if (l > 0)
+		for (size_t k = 0; k < n; ++k)
+			bits.puts(x[k], l);
+	uint64_t hlast = 0;
+	for (size_t k = 0; k < n; ++k) {
+		uint64_t h = x[k] >> l;
+		for (; hlast < h; ++hlast) bits.put0();
+		bits.put1();
+	}
+}
+
+void SDArrayPEFBuilder::build(SDArrayPEF* out) {
+	out->clear();
+	std::vector<size_t> cuts;
+	partition(cuts);
+	const size_t nchunks = cuts.size() - 1;
+	const size_t nseg = (vals.size() + GRAIN - 1) / GRAIN;
+	SDArraySmlBuilder bsums;
+	std::vector<uint64_t> ptrs(nchunks);
+	FixedWArray info = FixedWArrayBuilder::create(nchunks, 7);
+	FixedWArray cseg = FixedWArrayBuilder::create(nchunks + 1, ceillog2(nseg + 1) + 1);
+	FixedWArray segc = FixedWArrayBuilder::create(nseg, ceillog2(nchunks + 1) + 1);
+	OBitStream bits;
+	for (size_t c = 0; c < nchunks; ++c) {
+		ptrs[c] = bits.length();
+		uint8_t inf;
+		encode_chunk(cuts[c], cuts[c + 1], bits, inf);
+		uint64_t u = 0;
+		for (size_t i = cuts[c]; i < cuts[c + 1]; ++i) u += vals[i];
+		bsums.add(u);
+		info.set(c, inf);
+		cseg.set(c, cuts[c] / GRAIN);
+		for (size_t sg = cuts[c] / GRAIN; sg * GRAIN < cuts[c + 1]; ++sg)
+			segc.set(sg, c);
+	}
+	cseg.set(nchunks, nseg);
+	bits.close();
+	out->ptrs = FixedWArrayBuilder::create(nchunks, ceillog2(bits.length() + 1) + 1);
+	for (size_t c = 0; c < nchunks; ++c)
+		out->ptrs.set(c, ptrs[c]);
+	bits.build(&out->bits);
+	bsums.build(&out->sums);
+	out->info = info;
+	out->chunk_seg = cseg;
+	out->seg_chunk = segc;
+	out->len = vals.size();
+	out->sum = last;
+	clear();
+}
+
+void SDArrayPEFBuilder::build(OutArchive& ar) {
+	SDArrayPEF sda;
+	build(&sda);
+	sda.save(ar);
+	sda.clear();
+}
+
+//---------------------------------------------------------------------------------------
+
+void SDArrayPEF::get_chunk(uint64_t c, Chunk& ch) const {
+	const uint64_t grain = SDArrayPEFBuilder::GRAIN;
+	ch.start = chunk_seg[c] * grain;
+	ch.n = std::min<uint64_t>(chunk_seg[c + 1] * grain, len) - ch.start;
+	ch.u = sums.lookup(c, ch.base);
+	ch.ptr = ptrs[c];
+	ch.info = (uint8_t) info[c];
+}
+
+uint64_t SDArrayPEF::chunk_of(uint64_t i) const {
+	assert(i < len);
+	return seg_chunk[i / SDArrayPEFBuilder::GRAIN];
+}
+
+uint64_t SDArrayPEF::high_pos(const Chunk& ch, uint64_t hibase, uint64_t k) const {
+	uint64_t j = k / HINT_RATE;
+	if (j > 0) {
+		uint64_t hp = bits.bits(ch.ptr + HINT_WIDTH * (j - 1), HINT_WIDTH);
+		return hp + bits.scan_bits(hibase + hp, k - j * HINT_RATE);
+	} else
+		return bits.scan_bits(hibase, k);
+}
+
+uint64_t SDArrayPEF::chunk_value(const Chunk& ch, uint64_t k) const {
+	assert(k < ch.n);
+	if (ch.info == RUN_CHUNK) return (ch.u / ch.n) * (k + 1);
+	const unsigned int l = ch.info;
+	const uint64_t lobase = ch.ptr + HINT_WIDTH * hint_count(ch.n);
+	const uint64_t hibase = lobase + l * ch.n;
+	uint64_t pos = high_pos(ch, hibase, k);
+	uint64_t v = (pos - k) << l;
+	if (l > 0) v |= bits.bits(lobase + k * l, l);
+	return v;
+}
+
+uint64_t SDArrayPEF::chunk_rank(const Chunk& ch, uint64_t v) const {
+	assert(v >= 1 && v <= ch.u);
+	if (ch.info == RUN_CHUNK) {
+		uint64_t c = ch.u / ch.n;
+		return (v + c - 1) / c - 1;
+	}
+	const unsigned int l = ch.info;
+	const uint64_t nhints = hint_count(ch.n);
+	const uint64_t lobase = ch.ptr + HINT_WIDTH * nhints;
+	const uint64_t hibase = lobase + l * ch.n;
+	const uint64_t vhi = v >> l;
+	// find the position p of the first element with upper part >= vhi
+	uint64_t k = 0, p = hibase;
+	if (vhi > 0) {
+		uint64_t z;
+		uint64_t j = nhints;
+		uint64_t hp = 0, hh = 0;
+		for (; j > 0; --j) {
+			hp = bits.bits(ch.ptr + HINT_WIDTH * (j - 1), HINT_WIDTH);
+			hh = hp - j * HINT_RATE;
+			if (hh < vhi) break;
+		}
+		if (j > 0)
+			z = hp + 1 + bits.scan_zeros(hibase + hp + 1, vhi - 1 - hh);
+		else
+			z = bits.scan_zeros(hibase, vhi - 1);
+		k = z - (vhi - 1);
+		p = hibase + z + 1;
+	}
+	// elements with the same upper part are consecutive 1-bits
+	for (;; ++k, ++p) {
+		assert(k < ch.n);
+		if (!bits.bit(p)) return k;
+		if (l == 0) return k;
+		uint64_t x = (vhi << l) | bits.bits(lobase + k * l, l);
+		if (x >= v) return k;
+	}
+}
+
+void SDArrayPEF::decode_chunk(const Chunk& ch, uint64_t* out) const {
+	if (ch.info == RUN_CHUNK) {
+		uint64_t c = ch.u / ch.n;
+		for (uint64_t k = 0; k < ch.n; ++k) out[k] = c * (k + 1);
+		return;
+	}
+	const unsigned int l = ch.info;
+	const uint64_t lobase = ch.ptr + HINT_WIDTH * hint_count(ch.n);
+	const uint64_t hibase = lobase + l * ch.n;
+	uint64_t wi = hibase >> 6;
+	uint64_t w = bits.word(wi) & ((~0ull) << (hibase & 63));
+	for (uint64_t k = 0; k < ch.n; ++k) {
+		while (w == 0) w = bits.word(++wi);
+		uint64_t pos = (wi << 6) + lsb_intr(w) - hibase;
+		w &= w - 1;
+		out[k] = (pos - k) << l;
+		if (l > 0) out[k] |= bits.bits(lobase + k * l, l);
+	}
+}
+
+uint64_t SDArrayPEF::prefixsum(size_t i) const {
+	if (i == 0) return 0;
+	if (i >= len) return sum;
+	Chunk ch;
+	get_chunk(chunk_of(i - 1), ch);
+	return ch.base + chunk_value(ch, i - 1 - ch.start);
+}
+
+uint64_t SDArrayPEF::lookup(uint64_t i, uint64_t& prev_sum) const {
+	assert(i < len);
+	Chunk ch;
+	get_chunk(chunk_of(i), ch);
+	uint64_t k = i - ch.start;
+	if (ch.info == RUN_CHUNK) {
+		uint64_t c = ch.u / ch.n;
+		prev_sum = ch.base + c * k;
+		return c;
+	}
+	if (k == 0) {
+		prev_sum = ch.base;
+		return chunk_value(ch, 0);
+	}
+	// the element k is the next 1-bit after the element k-1
+	const unsigned int l = ch.info;
+	const uint64_t lobase = ch.ptr + HINT_WIDTH * hint_count(ch.n);
+	const uint64_t hibase = lobase + l * ch.n;
+	uint64_t p1 = high_pos(ch, hibase, k - 1);
+	uint64_t p2 = p1 + 1 + bits.scan_next(hibase + p1 + 1);
+	uint64_t v1 = (p1 - k + 1) << l, v2 = (p2 - k) << l;
+	if (l > 0) {
+		v1 |= bits.bits(lobase + (k - 1) * l, l);
+		v2 |= bits.bits(lobase + k * l, l);
+	}
+	prev_sum = ch.base + v1;
+	return v2 - v1;
+}
+
+uint64_t SDArrayPEF::lookup(uint64_t i) const {
+	uint64_t ps;
+	return lookup(i, ps);
+}
+
+uint64_t SDArrayPEF::rank(uint64_t p) const {
+	if (p == 0) return 0;
+	if (p > sum) return len;
+	uint64_t c = sums.rank(p) - 1;
+	Chunk ch;
+	get_chunk(c, ch);
+	return ch.start + chunk_rank(ch, p - ch.base) + 1;
+}
+
+void SDArrayPEF::clear() {
+	len = 0;
+	sum = 0;
+	sums.clear();
+	ptrs.clear();
+	info.clear();
+	chunk_seg.clear();
+	seg_chunk.clear();
+	bits.clear();
+}
+
+void SDArrayPEF::save(OutArchive& ar) const {
+	ar.startclass("SDArrayPEF", 1);
+	ar.var("length").save(len);
+	ar.var("sum").save(sum);
+	sums.save(ar.var("chunk_sums"));
+	ptrs.save(ar.var("chunk_pointers"));
+	info.save(ar.var("chunk_info"));
+	chunk_seg.save(ar.var("chunk_segments"));
+	seg_chunk.save(ar.var("segment_chunks"));
+	bits.save(ar.var("bits"));
+	ar.endclass();
+}
+
+void SDArrayPEF::load(InpArchive& ar) {
+	ar.loadclass("SDArrayPEF");
+	ar.var("length").load(len);
+	ar.var("sum").load(sum);
+	sums.load(ar.var("chunk_sums"));
+	ptrs.load(ar.var("chunk_pointers"));
+	info.load(ar.var("chunk_info"));
+	chunk_seg.load(ar.var("chunk_segments"));
+	seg_chunk.load(ar.var("segment_chunks"));
+	bits.load(ar.var("bits"));
+	ar.endclass();
+}
+
+void SDArrayPEF::inspect(const std::string& cmd, std::ostream& out) const {
+	if (cmd == "comp_size") {
+		size_t nrun = 0, ndense = 0, nef = 0;
+		for (size_t c = 0; c < info.length(); ++c) {
+			uint8_t inf = (uint8_t) info[c];
+			if (inf == RUN_CHUNK) ++nrun;
+			else if (inf == 0) ++ndense;
+			else ++nef;
+		}
+		out << "sdarray_pef" << std::endl;
+		out << "length: " << len << std::endl;
+		out << "sum: " << sum << std::endl;
+		out << "chunks: " << info.length() << " (run: " << nrun << ", dense: "
+			<< ndense << ", elias_fano: " << nef << ")" << std::endl;
+		out << "payload_size: " << (bits.length() + 7) / 8 << std::endl;
+	}
+}
+
+void SDArrayPEF::getEnum(size_t idx, Enum * e) const {
+	e->ptr = this;
+	e->idx = idx;
+	e->buf.clear();
+	e->pos = 0;
+	if (idx >= len) return;
+	e->load_chunk(chunk_of(idx));
+	Chunk ch;
+	get_chunk(e->chunk, ch);
+	e->pos = idx - ch.start;
+}
+
+void SDArrayPEF::Enum::load_chunk(uint64_t c) {
+	Chunk ch;
+	ptr->get_chunk(c, ch);
+	chunk = c;
+	buf.resize(ch.n);
+	ptr->decode_chunk(ch, buf.data());
+	for (size_t k = ch.n - 1; k > 0; --k)
+		buf[k] -= buf[k - 1];
+	pos = 0;
+}
+
+uint64_t SDArrayPEF::Enum::next() {
+	assert(hasNext());
+	if (pos == buf.size()) load_chunk(chunk + 1);
+	++idx;
+	return buf[pos++];
+}
+
+}//namespace
@@ -0,0 +1,145 @@
+#pragma once
+
+/**  \file
+
+Partitioned Elias-Fano array: the prefix sums are cut into chunks of
+variable length, the boundaries and the encoding of each chunk are selected
+by a dynamic programming over the estimated space cost.
+
+A table maps every GRAIN elements to their chunk, hence locating the chunk of
+an index takes constant time.
+
+Each chunk is encoded by one of:
+* run: all values in the chunk are equal (e.g. runs of zeros or of a fixed
+  step), no payload is stored
+* dense: Elias-Fano with zero lower bits i.e. a plain unary bitmap of the gaps
+* Elias-Fano: lower bits + unary upper bits with a chunk specific width
+
+*/
+
+#include "sdarray_interface.h"
+#include "sdarray_sml.h"
+#include "bitarray/bitarray.h"
+#include "bitarray/bitstream.h"
+
+#include <vector>
+#include <string>
+#include <iostream>
+
+namespace mscds {
+
+class SDArrayPEF;
+
+/// Builder class for SDArrayPEF
+class SDArrayPEFBuilder {
+public:
+	SDArrayPEFBuilder();
+	void add(uint64_t val);
+	/** add increasing values */
+	void add_inc(uint64_t pos);
+	uint64_t current_sum();
+
+	void build(SDArrayPEF* out);
+	void build(OutArchive& ar);
+	void clear();
+
+	/** chunk lengths are multiples of GRAIN and at most MAX_CHUNK */
+	static const unsigned int GRAIN = 128;
+	static const unsigned int MAX_CHUNK = 1024;
+	typedef SDArrayPEF QueryTp;
+private:
+	void partition(std::vector<size_t>& cuts) const;
+	void encode_chunk(size_t st, size_t ed, OBitStream& bits, uint8_t& info) const;
+	std::vector<uint64_t> vals;
+	uint64_t last;
+};
+
+/// SDArray with partitioned Elias-Fano encoding
+class SDArrayPEF: public SDArrayInterface {
+public:
+	SDArrayPEF() { clear(); }
+
+	/** returns the value of A[i] */
+	uint64_t lookup(uint64_t i) const;
+
+	/** returns the value of A[i] and  prev_sum=prefix_sum(i) */
+	uint64_t lookup(uint64_t i, uint64_t& prev_sum) const;
+
+	/** return the value of prefix_sum(i) */
+	uint64_t prefixsum(size_t i) const;
+
+	/** return the value of rank(p) */
+	uint64_t rank(uint64_t p) const;
+
+	/** return a pair of rank(p) and prefixsum(rank(p)) */
+	uint64_t rank2(uint64_t p, uint64_t& select) const {
+		uint64_t v = rank(p);
+		select = prefixsum(v);
+		return v;
+	}
+
+	/** clear the array (length becomes 0) */
+	void clear();
+
+	/** save and load functions */
+	void save(OutArchive& ar) const;
+	void load(InpArchive& ar);
+
+	/** returns the sum of all the elements in the array */
+	uint64_t total() const { return sum; }
+
+	/** counts the number of elements in the array */
+	uint64_t length() const { return len; }
+
+	/** number of chunks */
+	uint64_t chunk_count() const { return info.length(); }
+
+	void inspect(const std::string& cmd, std::ostream& out) const;
+
+	typedef SDArrayPEFBuilder BuilderTp;
+
+	/// enumerates A[i], A[i+1], ... (one chunk is decoded at a time)
+	struct Enum: public EnumeratorInt<uint64_t> {
+	public:
+		Enum(): ptr(NULL), idx(0), pos(0) {}
+		bool hasNext() const { return idx < ptr->len; }
+		uint64_t next();
+	private:
+		const SDArrayPEF* ptr;
+		uint64_t idx, chunk;
+		size_t pos;
+		std::vector<uint64_t> buf;
+		void load_chunk(uint64_t c);
+		friend class SDArrayPEF;
+	};
+	void getEnum(size_t idx, Enum * e) const;
+
+	/// chunk types stored in `info`
+	static const uint8_t RUN_CHUNK = 127;
+private:
+	struct Chunk {
+		uint64_t start, n, base, u, ptr;
+		uint8_t info;
+	};
+	void get_chunk(uint64_t c, Chunk& ch) const;
+	uint64_t chunk_of(uint64_t i) const;
+	/** position of the 1-bit of the k-th element in the upper bits */
+	uint64_t high_pos(const Chunk& ch, uint64_t hibase, uint64_t k) const;
+	/** local prefix sum of the first k+1 values in the chunk */
+	uint64_t chunk_value(const Chunk& ch, uint64_t k) const;
+	/** minimal k such that the local prefix sum of k+1 values is at least v (v >= 1) */
+	uint64_t chunk_rank(const Chunk& ch, uint64_t v) const;
+	/** writes the local prefix sums of the whole chunk to `out` */
+	void decode_chunk(const Chunk& ch, uint64_t* out) const;
+
+	uint64_t len, sum;
+	SDArraySml sums;
+	/// per chunk: bit pointer to the payload, type/width, first segment (of GRAIN elements)
+	FixedWArray ptrs, info, chunk_seg;
+	/// the chunk containing each segment
+	FixedWArray seg_chunk;
+	BitArray bits;
+	friend class SDArrayPEFBuilder;
+};
+
+}//namespace
@@ -1,5 +1,6 @@
 #include "sdarray_sml.h"
 #include "bitarray/bitop.h"
+#include "utils/parallel.h"
 
 #include <cassert>
 #include <sstream>
@@ -70,6 +71,12 @@ void SDArraySmlBuilder::clear() {
 }
 
 void SDArraySmlBuilder::build_blk(){
+	build_blk(vals, p_sum, bits, table);
+}
+
+// encodes one block of values into `bits` and appends its 3 words to `table`,
+// `vals` is consumed (cleared)
+void SDArraySmlBuilder::build_blk(std::vector<uint64_t>& vals, uint64_t& p_sum, OBitStream& bits, std::vector<uint64_t>& table) {
 	assert(vals.size() <= BLKSIZE);
 	if (vals.size() == 0) return;
 	while (vals.size() < BLKSIZE) vals.push_back(0);
@@ -117,6 +124,52 @@ void SDArraySmlBuilder::build_blk(){
 	vals.clear();
 }
 
+void SDArraySmlBuilder::build_s(const std::vector<uint64_t>& values, SDArraySml* out, unsigned int nthreads) {
+	nthreads = utils::resolve_threads(nthreads);
+	const size_t nblk = (values.size() + BLKSIZE - 1) / BLKSIZE;
+	if (nthreads <= 1 || nblk <= 1) {
+		SDArraySmlBuilder bd;
+		for (auto v : values) bd.add(v);
+		bd.build(out);
+		return;
+	}
+	// every thread encodes a range of blocks into its own stream and table
+	// with offsets relative to its range, the offsets are fixed after merging
+	std::vector<OBitStream> lbits(nthreads);
+	std::vector<std::vector<uint64_t> > ltable(nthreads);
+	std::vector<uint64_t> lsum(nthreads, 0);
+	utils::parallel_parts(nblk, nthreads, [&](unsigned int t, size_t st, size_t ed) {
+		std::vector<uint64_t> blk;
+		blk.reserve(BLKSIZE);
+		for (size_t b = st; b < ed; ++b) {
+			const size_t vst = b * BLKSIZE, ved = std::min<size_t>(vst + BLKSIZE, values.size());
+			blk.assign(values.begin() + vst, values.begin() + ved);
+			build_blk(blk, lsum[t], lbits[t], ltable[t]);
+		}
+		lbits[t].close();
+	});
+	OBitStream bits;
+	std::vector<uint64_t> table;
+	table.reserve(nblk * 3);
+	uint64_t p_sum = 0;
+	for (unsigned int t = 0; t < nthreads; ++t) {
+		const uint64_t boff = bits.length();
+		for (size_t i = 0; i < ltable[t].size(); i += 3) {
+			table.push_back(ltable[t][i] + p_sum);
+			table.push_back(ltable[t][i + 1] + boff);
+			table.push_back(ltable[t][i + 2]);
+		}
+		bits.append(lbits[t]);
+		lbits[t].clear();
+		p_sum += lsum[t];
+	}
+	bits.close();
+	out->len = values.size();
+	out->sum = p_sum;
+	bits.build(&out->bits);
+	out->table = BitArrayBuilder::create(table.size() * 64, (char*) (table.data()));
+}
+
 //----------------------------------------------------------------------------
 
 struct BlkHintInfo {
@@ -341,6 +394,62 @@ void SDArraySml::load(InpArchive& ar) {
 	ar.endclass();
 }
 
+// decodes the prefix sums of the elements [off..off+n) inside block `blk`
+// the lower bits are read through a buffered stream, the upper bits are
+// extracted word by word with lsb_intr() and clearing the lowest 1-bit
+void SDArraySml::decode_blk(uint64_t blk, uint32_t off, size_t n, uint64_t* out) const {
+	assert(off + n <= BLKSIZE);
+	const uint64_t basesum = table.word(blk * 3);
+	const uint64_t info = table.word(blk * 3 + 1);
+	const uint64_t loptr = info & 0x01FFFFFFFFFFFFFFull;
+	const uint32_t width = info >> 57;
+	const uint64_t hibase = loptr + width * BLKSIZE;
+	const uint64_t hp = hibase + ((off > 0) ? select_hi(table.word(blk * 3 + 2), hibase, off - 1) + 1 : 0);
+	uint64_t wi = hp >> 6;
+	uint64_t w = bits.word(wi) & ((~0ull) << (hp & 63));
+	uint64_t k = off;
+	if (width > 0) {
+		IWBitStream lo;
+		lo.init_array(bits, loptr + width * off);
+		for (size_t c = 0; c < n; ++c, ++k) {
+			while (w == 0) w = bits.word(++wi);
+			const uint64_t hi = (wi << 6) + lsb_intr(w) - hibase - k;
+			w &= w - 1;
+			out[c] = basesum + ((hi << width) | lo.get(width));
+		}
+	} else {
+		for (size_t c = 0; c < n; ++c, ++k) {
+			while (w == 0) w = bits.word(++wi);
+			out[c] = basesum + (wi << 6) + lsb_intr(w) - hibase - k;
+			w &= w - 1;
+		}
+	}
+}
+
+void SDArraySml::decode_ps(size_t start, size_t count, uint64_t* out) const {
+	assert(start + count <= len);
+	const size_t end = start + count;
+	while (start < end) {
+		const uint64_t blk = start / BLKSIZE;
+		const uint32_t off = start % BLKSIZE;
+		const size_t n = std::min<size_t>(end - start, BLKSIZE - off);
+		decode_blk(blk, off, n, out);
+		out += n;
+		start += n;
+	}
+}
+
+void SDArraySml::decode(size_t start, size_t count, uint64_t* out) const {
+	if (count == 0) return;
+	uint64_t prev = prefixsum(start);
+	decode_ps(start, count, out);
+	for (size_t i = 0; i < count; ++i) {
+		uint64_t v = out[i];
+		out[i] = v - prev;
+		prev = v;
+	}
+}
+
 SDArraySml::PSEnum::PSEnum(const SDArraySml * p, uint64_t blk): ptr(p) {
 	moveblk(blk);
 }
@@ -35,6 +35,10 @@ public:
 
 	uint64_t current_sum();
 
+	/** builds the array from `values` using `nthreads` threads (0 means the number
+	of CPU cores), the result is identical to adding the values one by one */
+	static void build_s(const std::vector<uint64_t>& values, SDArraySml* out, unsigned int nthreads = 0);
+
 	static const uint64_t BLKSIZE;
 	static const uint16_t SUBB_PER_BLK;
 	typedef SDArraySml QueryTp;
@@ -44,6 +48,7 @@ private:
 	void packLows(uint64_t begPos, uint64_t width);
 
 	void build_blk();
+	static void build_blk(std::vector<uint64_t>& vals, uint64_t& p_sum, OBitStream& bits, std::vector<uint64_t>& table);
 	std::vector<uint64_t> vals;
 	OBitStream bits;
 	std::vector<uint64_t> table;
@@ -79,6 +84,13 @@ public:
 	/** return a pair of rank(p) and prefixsum(rank(p)) */
 	uint64_t rank2(uint64_t p, uint64_t& select) const;
 
+	/** bulk decoding: writes A[start..start+count) to `out` */
+	void decode(size_t start, size_t count, uint64_t* out) const;
+
+	/** bulk decoding: writes prefix_sum(start+1..start+count) to `out`
+	(i.e. the same values as `count` calls of PSEnum::next() starting from `start`) */
+	void decode_ps(size_t start, size_t count, uint64_t* out) const;
+
 	/** clear the array (length becomes 0) */
 	void clear();
 
@@ -141,6 +153,7 @@ private:
 
 	uint64_t select_zerohi(uint64_t hints, uint64_t start, uint32_t p) const;
 	uint64_t rankBlk(uint64_t blk, uint64_t val) const;
+	void decode_blk(uint64_t blk, uint32_t off, size_t n, uint64_t* out) const;
 	
 	BitArray bits;
 	BitArray table;
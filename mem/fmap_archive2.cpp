@@ -21,11 +21,12 @@ using namespace boost::interprocess;
 
 struct FileMapImpl2 {
 	file_mapping m_file;
+	std::shared_ptr<mapped_region> region;
 	std::ifstream fi;
 	size_t data_start, control_start;
 };
 
-void IFileMapArchive2::open_read(const std::string &fname) {
+void IFileMapArchive2::open_read(const std::string &fname, AccessAdvice advice) {
 	close();
 	FileMapImpl2 * fm = new FileMapImpl2();
 	impl = fm;
@@ -42,6 +43,24 @@ void IFileMapArchive2::open_read(const std::string &fname) {
 	FileMarker::check_control_start(*this);
 	fm->control_start = fm->fi.tellg();
 	fm->m_file = file_mapping(fname.c_str(), read_only);
+	if (control_pos > fm->data_start) {
+		fm->region = std::make_shared<mapped_region>(fm->m_file, read_only,
+			fm->data_start, control_pos - fm->data_start);
+		this->advise(advice);
+	}
+}
+
+void IFileMapArchive2::advise(AccessAdvice advice) {
+	FileMapImpl2 * fm = (FileMapImpl2 *) impl;
+	if (fm == NULL || !fm->region) return;
+	mapped_region::advice_types adv;
+	switch (advice) {
+	case SEQUENTIAL_ACCESS: adv = mapped_region::advice_sequential; break;
+	case RANDOM_ACCESS:     adv = mapped_region::advice_random; break;
+	case WILLNEED_ACCESS:   adv = mapped_region::advice_willneed; break;
+	default:                adv = mapped_region::advice_normal; break;
+	}
+	fm->region->advise(adv); // only a hint, the result is ignored
 }
 
 void IFileMapArchive2::close() {
@@ -71,17 +90,6 @@ InpArchive &IFileMapArchive2::endclass(){
 	return * this;
 }
 
-struct FMDeleter2 {
-	mapped_region * ptr;
-	FMDeleter2() {}
-	FMDeleter2(const FMDeleter2& other): ptr(other.ptr) {}
-	FMDeleter2(mapped_region * p):ptr(p){}
-
-	void operator()(void* p) {
-		delete ptr;
-	}
-};
-
 StaticMemRegionPtr IFileMapArchive2::load_mem_region(MemoryAccessType mtp) {
 	FileMapImpl2 * fm = (FileMapImpl2 *)impl;
 	MemoryAlignmentType align;
@@ -92,9 +100,10 @@ StaticMemRegionPtr IFileMapArchive2::load_mem_region(MemoryAccessType mtp) {
 	load_bin(&ptrx, sizeof(ptrx));
 	std::shared_ptr<void> s;
 	if (nsz > 0) {
-		mapped_region * rg;
-		rg = new mapped_region(fm->m_file, read_only, fm->data_start + ptrx, nsz);
-		s = std::shared_ptr<void>(rg->get_address(), FMDeleter2(rg));
+		if (!fm->region || ptrx + nsz > fm->region->get_size())
+			throw ioerror("memory region out of the data segment");
+		// shares the ownership of the whole mapping, points to the region
+		s = std::shared_ptr<void>(fm->region, (char*)fm->region->get_address() + ptrx);
 	}
 	LocalMemAllocator alloc;
 	return alloc.adoptMem(nsz, s);
@@ -3,7 +3,9 @@
 /** \file
 
 Archive to read data from file. This archive uses memory mapping to avoid loading all
-data to memory at once.
+data to memory at once. The data segment of the file is mapped once when the file is
+opened, and every memory region loaded from the archive points directly into that
+mapping (no copy, the pages are shared through the OS page cache).
 
 This is version 2 archive layout (data and meta-data are in seperated segments.)
 
@@ -21,6 +23,9 @@ struct FileMapImpl2;
 /// file mapping archive
 class IFileMapArchive2: public InpArchive {
 public:
+	/// hints for the expected access pattern of the mapped data (see madvise)
+	enum AccessAdvice { NORMAL_ACCESS, SEQUENTIAL_ACCESS, RANDOM_ACCESS, WILLNEED_ACCESS };
+
 	IFileMapArchive2(): impl(NULL) {}
 	~IFileMapArchive2() {close();}
 
@@ -32,7 +37,9 @@ public:
 
 	size_t ipos() const;
 
-	void open_read(const std::string& fname);
+	void open_read(const std::string& fname, AccessAdvice advice = NORMAL_ACCESS);
+	/** changes the access pattern hint of the mapped data */
+	void advise(AccessAdvice advice);
 	void close();
 	bool eof() const;
 private:
@@ -6,12 +6,24 @@ namespace mscds {
 
 using utils::FNV_hash;
 
+// A class is marked by a 16-bit hash of its name. Classes with version > 1 store
+// the complement of the hash followed by the version byte, so the files of
+// version 0/1 classes keep their layout and load as version 0.
+static uint16_t class_tag(const std::string& name) {
+	uint32_t v = FNV_hash::hash32(name);
+	return (v >> 16) ^ (v & 0xFFFF);
+}
+
 void FileMarker::class_start(OutArchive &out, const std::string &name, unsigned char version) {
 	//uint32_t v = FNV_hash::hash24(name) | (((uint32_t)version) << 24);
 	//out.save_bin((char*)&v, sizeof(v));
-	uint32_t v = FNV_hash::hash32(name);
-	uint16_t h = (v >> 16) ^ (v & 0xFFFF);
-	out.save_bin((char*)&h, sizeof(h));
+	uint16_t h = class_tag(name);
+	if (version > 1) {
+		h = ~h;
+		out.save_bin((char*)&h, sizeof(h));
+		out.save_bin((char*)&version, sizeof(version));
+	} else
+		out.save_bin((char*)&h, sizeof(h));
 }
 
 void FileMarker::class_end(OutArchive &out) {}
@@ -22,12 +34,14 @@ unsigned char FileMarker::check_class_start(InpArchive &inp, const std::string &
 	inp.load_bin(&v, sizeof(v));
 	if ((v & 0xFFFFFF) != hash) throw ioerror(std::string("Wrong hash tag: ") + name);
 	return v >> 24;*/
-	uint32_t v = FNV_hash::hash32(name);
-	uint16_t h = (v >> 16) ^ (v & 0xFFFF);
+	uint16_t h = class_tag(name);
 	uint16_t x;
 	inp.load_bin(&x, sizeof(x));
-	if (x != h) throw ioerror(std::string("Wrong hash tag: ") + name);
-	return 0;
+	if (x == h) return 0;
+	if (x != (uint16_t) ~h) throw ioerror(std::string("Wrong hash tag: ") + name);
+	unsigned char version;
+	inp.load_bin(&version, sizeof(version));
+	return version;
 }
 
 bool FileMarker::check_class_end(InpArchive &inp) {
@@ -154,6 +154,31 @@ TEST(farchive2, fmap_file) {
 	fi.close();
 }
 
+TEST(farchive2, class_version) {
+	OMemArchive out;
+	out.startclass("old_class");
+	out.save((uint32_t) 5);
+	out.startclass("new_class", 2);
+	out.save((uint32_t) 7);
+	out.endclass();
+	out.endclass();
+	out.startclass("other_class", 1);
+	out.endclass();
+	out.close();
+	IMemArchive in(out);
+	uint32_t v;
+	ASSERT_EQ(0, in.loadclass("old_class"));
+	in.load(v);
+	ASSERT_EQ(5u, v);
+	ASSERT_EQ(2, in.loadclass("new_class"));
+	in.load(v);
+	ASSERT_EQ(7u, v);
+	in.endclass();
+	in.endclass();
+	ASSERT_THROW(in.loadclass("new_class"), ioerror);
+	in.close();
+}
+
 template<typename T>
 void check_num(const std::vector<T>& vals) {
 	OMemArchive out;
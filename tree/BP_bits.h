@@ -93,6 +93,7 @@ public:
 		{ return (bit(p)?find_close(p):find_open(p)); }
 	bool bit(uint64_t p) const { return bprank.access(p); }
 	size_t length() const { return bprank.length(); }
+	const BitArray& bit_array() const { return bp_bits; }
 	std::string to_str() const;
 
 	uint64_t find_close(uint64_t p) const;
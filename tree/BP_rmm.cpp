@@ -0,0 +1,674 @@
+#include "BP_rmm.h"
+
+#include "bitarray/bitop.h"
+
+#include <algorithm>
+#include <vector>
+#include <sstream>
+#include <cassert>
+
+#if defined(__SSSE3__) && defined(__GNUC__)
+#include <tmmintrin.h>
+#define BP_RMM_SSSE3
+#endif
+#ifdef __SSE4_1__
+#include <smmintrin.h>
+#endif
+
+namespace mscds {
+
+namespace {
+
+// excess and minimum prefix excess (after 1..4 bits) of the 16 nibbles,
+// the lowest bit comes first
+const int8_t NIB_EXC[16] = {-4, -2, -2, 0, -2, 0, 0, 2, -2, 0, 0, 2, 0, 2, 2, 4};
+const int8_t NIB_MIN[16] = {-4, -2, -2, 0, -2, 0, -1, 1, -3, -1, -1, 1, -2, 0, -1, 1};
+
+inline int byte_exc(uint8_t c) { return NIB_EXC[c & 15] + NIB_EXC[c >> 4]; }
+/// minimum excess after 1..8 bits of the byte
+inline int byte_min(uint8_t c) {
+	return std::min<int>(NIB_MIN[c & 15], NIB_EXC[c & 15] + NIB_MIN[c >> 4]);
+}
+
+inline uint64_t low_mask(unsigned int k) { return k >= 64 ? ~0ull : ((1ull << k) - 1); }
+
+/// excess of the first `k' bits of the chunk (w0, w1)
+inline int chunk_prefix(uint64_t w0, uint64_t w1, unsigned int k) {
+	unsigned int pc = (k <= 64) ? popcnt(w0 & low_mask(k)) : popcnt(w0) + popcnt(w1 & low_mask(k - 64));
+	return 2 * (int)pc - (int)k;
+}
+
+inline int chunk_exc(uint64_t w0, uint64_t w1) { return 2 * (int)(popcnt(w0) + popcnt(w1)) - 128; }
+
+#ifdef BP_RMM_SSSE3
+
+inline __m128i min_epi8(__m128i a, __m128i b) {
+#ifdef __SSE4_1__
+	return _mm_min_epi8(a, b);
+#else
+	const __m128i bias = _mm_set1_epi8((char)0x80);
+	return _mm_xor_si128(_mm_min_epu8(_mm_xor_si128(a, bias), _mm_xor_si128(b, bias)), bias);
+#endif
+}
+
+/// for each byte j of the chunk: `pre' = excess before the byte, `mn' = minimum
+/// excess after the bits of the byte (both relative to the start of the chunk)
+inline void chunk_bytes(uint64_t w0, uint64_t w1, __m128i& pre, __m128i& mn) {
+	const __m128i exc_t = _mm_setr_epi8(-4, -2, -2, 0, -2, 0, 0, 2, -2, 0, 0, 2, 0, 2, 2, 4);
+	const __m128i min_t = _mm_setr_epi8(-4, -2, -2, 0, -2, 0, -1, 1, -3, -1, -1, 1, -2, 0, -1, 1);
+	const __m128i low4 = _mm_set1_epi8(0x0F);
+	__m128i x = _mm_set_epi64x((long long)w1, (long long)w0);
+	__m128i lo = _mm_and_si128(x, low4);
+	__m128i hi = _mm_and_si128(_mm_srli_epi16(x, 4), low4);
+	__m128i elo = _mm_shuffle_epi8(exc_t, lo);
+	__m128i m = min_epi8(_mm_shuffle_epi8(min_t, lo), _mm_add_epi8(elo, _mm_shuffle_epi8(min_t, hi)));
+	// prefix sums of the byte excesses, only the sum of all 16 bytes can
+	// reach 128 and it is shifted out below
+	__m128i s = _mm_add_epi8(elo, _mm_shuffle_epi8(exc_t, hi));
+	s = _mm_adds_epi8(s, _mm_slli_si128(s, 1));
+	s = _mm_adds_epi8(s, _mm_slli_si128(s, 2));
+	s = _mm_adds_epi8(s, _mm_slli_si128(s, 4));
+	s = _mm_adds_epi8(s, _mm_slli_si128(s, 8));
+	pre = _mm_slli_si128(s, 1);
+	mn = _mm_add_epi8(pre, m);
+}
+
+/// bytes that reach the excess `t' (relative, -128 <= t)
+inline uint32_t chunk_fwd_mask(uint64_t w0, uint64_t w1, int t) {
+	__m128i pre, mn;
+	chunk_bytes(w0, w1, pre, mn);
+	__m128i tv = _mm_set1_epi8((char)std::min(t + 1, 127));
+	return (uint32_t)_mm_movemask_epi8(_mm_cmplt_epi8(mn, tv));
+}
+
+/// bytes whose starting or inner positions have excess <= `t'
+inline uint32_t chunk_bwd_mask(uint64_t w0, uint64_t w1, int t) {
+	__m128i pre, mn;
+	chunk_bytes(w0, w1, pre, mn);
+	__m128i tv = _mm_set1_epi8((char)std::min(t + 1, 127));
+	return (uint32_t)_mm_movemask_epi8(_mm_cmplt_epi8(min_epi8(pre, mn), tv));
+}
+
+/// minimum excess of the positions 0..128 of the chunk
+inline int chunk_min(uint64_t w0, uint64_t w1) {
+	__m128i pre, mn;
+	chunk_bytes(w0, w1, pre, mn);
+	__m128i v = min_epi8(pre, mn);
+	v = min_epi8(v, _mm_srli_si128(v, 8));
+	v = min_epi8(v, _mm_srli_si128(v, 4));
+	v = min_epi8(v, _mm_srli_si128(v, 2));
+	v = min_epi8(v, _mm_srli_si128(v, 1));
+	return std::min<int>((int8_t)_mm_cvtsi128_si32(v), chunk_exc(w0, w1));
+}
+
+#else
+
+inline void chunk_bytes(uint64_t w0, uint64_t w1, int8_t pre[16], int8_t mn[16]) {
+	int cur = 0;
+	for (unsigned int j = 0; j < 16; ++j) {
+		uint8_t c = (uint8_t)((j < 8 ? w0 : w1) >> (8 * (j & 7)));
+		pre[j] = (int8_t)cur;
+		mn[j] = (int8_t)(cur + byte_min(c));
+		cur += byte_exc(c);
+	}
+}
+
+inline uint32_t chunk_fwd_mask(uint64_t w0, uint64_t w1, int t) {
+	int8_t pre[16], mn[16];
+	chunk_bytes(w0, w1, pre, mn);
+	uint32_t m = 0;
+	for (unsigned int j = 0; j < 16; ++j)
+		if (mn[j] <= t) m |= 1u << j;
+	return m;
+}
+
+inline uint32_t chunk_bwd_mask(uint64_t w0, uint64_t w1, int t) {
+	int8_t pre[16], mn[16];
+	chunk_bytes(w0, w1, pre, mn);
+	uint32_t m = 0;
+	for (unsigned int j = 0; j < 16; ++j)
+		if (std::min(pre[j], mn[j]) <= t) m |= 1u << j;
+	return m;
+}
+
+inline int chunk_min(uint64_t w0, uint64_t w1) {
+	int8_t pre[16], mn[16];
+	chunk_bytes(w0, w1, pre, mn);
+	int m = chunk_exc(w0, w1);
+	for (unsigned int j = 0; j < 16; ++j)
+		m = std::min<int>(m, std::min(pre[j], mn[j]));
+	return m;
+}
+
+#endif
+
+/// first position (after a bit) in the byte at `pos' where the excess reaches `t'
+inline uint64_t fwd_in_byte(uint8_t c, uint64_t pos, int64_t cur, int64_t t) {
+	for (unsigned int k = 0; k < 8; ++k) {
+		cur += ((c >> k) & 1) ? 1 : -1;
+		if (cur <= t) return pos + k + 1;
+	}
+	assert(false);
+	return BP_rmm::NOTFOUND;
+}
+
+/// last position in the byte at `pos' with excess <= t, `cur' is the excess after the byte
+inline uint64_t bwd_in_byte(uint8_t c, uint64_t pos, int64_t cur, int64_t t) {
+	for (int k = 7; k >= 0; --k) {
+		cur -= ((c >> k) & 1) ? 1 : -1;
+		if (cur <= t) return pos + k;
+	}
+	assert(false);
+	return BP_rmm::NOTFOUND;
+}
+
+inline uint8_t chunk_byte(uint64_t w0, uint64_t w1, unsigned int j) {
+	return (uint8_t)((j < 8 ? w0 : w1) >> (8 * (j & 7)));
+}
+
+}//namespace
+
+//------------------------------------------------------------------------------
+
+const uint64_t BP_rmm::NOTFOUND;
+
+unsigned int BP_rmm::build(const BitArray& bp, unsigned int blksize) {
+	clear();
+	this->blksize = ((std::max(blksize, 128u) + 127) / 128) * 128;
+	bp_bits = bp;
+	Rank6pBuilder::build_aux(&bp_bits, &bprank);
+	init_tree();
+
+	std::vector<int64_t> mn(2 * nleaf2, 0), tot(2 * nleaf2, 0);
+	for (uint64_t b = 0; b < nleaf; ++b) {
+		uint64_t s = b * this->blksize, e = leaf_end(b);
+		int64_t es = excess(s);
+		mn[nleaf2 + b] = range_min(s, e) - es;
+		tot[nleaf2 + b] = excess(e) - es;
+	}
+	for (uint64_t v = nleaf2 - 1; v > 0; --v) {
+		mn[v] = std::min(mn[2 * v], tot[2 * v] + mn[2 * v + 1]);
+		tot[v] = tot[2 * v] + tot[2 * v + 1];
+	}
+	// the minimums are <= 0, they are stored negated
+	int64_t lowest = *std::min_element(mn.begin(), mn.end());
+	unsigned int width = std::max(1u, val_bit_len((uint64_t)(-lowest)));
+	leafmin = FixedWArrayBuilder::create(nleaf, width);
+	for (uint64_t b = 0; b < nleaf; ++b)
+		leafmin.set(b, (uint64_t)(-mn[nleaf2 + b]));
+	nodemin = FixedWArrayBuilder::create(nleaf2, width);
+	for (uint64_t v = 0; v < nleaf2; ++v)
+		nodemin.set(v, (uint64_t)(-mn[v]));
+	init_counts();
+	return height + 1;
+}
+
+// counts the positions of each node (after its first bit) that reach the node minimum
+void BP_rmm::init_counts() {
+	std::vector<uint64_t> cnt(2 * nleaf2, 0);
+	std::vector<int64_t> tot(2 * nleaf2, 0);
+	for (uint64_t b = 0; b < nleaf; ++b) {
+		uint64_t s = b * blksize, e = leaf_end(b);
+		int64_t es = excess(s);
+		cnt[nleaf2 + b] = count_scan(s, e, es + node_min(nleaf2 + b));
+		tot[nleaf2 + b] = excess(e) - es;
+	}
+	for (uint64_t v = nleaf2 - 1; v > 0; --v) {
+		int64_t m = node_min(v);
+		tot[v] = tot[2 * v] + tot[2 * v + 1];
+		cnt[v] = (node_min(2 * v) == m ? cnt[2 * v] : 0)
+			+ (tot[2 * v] + node_min(2 * v + 1) == m ? cnt[2 * v + 1] : 0);
+	}
+	uint64_t highest = *std::max_element(cnt.begin(), cnt.end());
+	unsigned int width = std::max(1u, val_bit_len(highest));
+	leafcnt = FixedWArrayBuilder::create(nleaf, width);
+	for (uint64_t b = 0; b < nleaf; ++b)
+		leafcnt.set(b, cnt[nleaf2 + b]);
+	nodecnt = FixedWArrayBuilder::create(nleaf2, width);
+	for (uint64_t v = 0; v < nleaf2; ++v)
+		nodecnt.set(v, cnt[v]);
+}
+
+void BP_rmm::init_tree() {
+	uint64_t n = bp_bits.length();
+	nleaf = (n + blksize - 1) / blksize;
+	nleaf2 = 1;
+	height = 0;
+	while (nleaf2 < nleaf) {
+		nleaf2 <<= 1;
+		++height;
+	}
+}
+
+void BP_rmm::clear() {
+	if (blksize > 0) {
+		bprank.clear();
+		bp_bits.clear();
+		leafmin.clear();
+		nodemin.clear();
+		leafcnt.clear();
+		nodecnt.clear();
+		blksize = 0;
+		nleaf = nleaf2 = 0;
+	}
+}
+
+inline uint64_t BP_rmm::leaf_end(uint64_t b) const {
+	return std::min<uint64_t>((b + 1) * blksize, bp_bits.length());
+}
+
+inline uint64_t BP_rmm::node_start(uint64_t v) const {
+	unsigned int h = height - msb_intr(v);
+	return ((v << h) - nleaf2) * blksize;
+}
+
+inline int64_t BP_rmm::node_min(uint64_t v) const {
+	if (v >= nleaf2) {
+		uint64_t b = v - nleaf2;
+		return b < nleaf ? -(int64_t)leafmin[b] : 0;
+	} else
+		return -(int64_t)nodemin[v];
+}
+
+// number of positions of the node that reach `t', t <= the minimum of the node
+inline uint64_t BP_rmm::node_count(uint64_t v, int64_t t) const {
+	if (excess(node_start(v)) + node_min(v) != t) return 0;
+	if (v >= nleaf2) {
+		uint64_t b = v - nleaf2;
+		return b < nleaf ? leafcnt[b] : 0;
+	} else
+		return nodecnt[v];
+}
+
+// canonical nodes covering the leaves bl .. br, from left to right
+unsigned int BP_rmm::cover_nodes(uint64_t bl, uint64_t br, uint64_t* nodes) const {
+	unsigned int nl = 0, nr = 0;
+	uint64_t rnodes[65];
+	uint64_t lo = nleaf2 + bl, hi = nleaf2 + br;
+	while (lo <= hi) {
+		if (lo & 1) nodes[nl++] = lo++;
+		if (!(hi & 1)) rnodes[nr++] = hi--;
+		if (lo > hi) break;
+		lo >>= 1;
+		hi >>= 1;
+	}
+	while (nr > 0) nodes[nl++] = rnodes[--nr];
+	return nl;
+}
+
+//------------------------------------------------------------------------------
+
+uint64_t BP_rmm::fwd_scan(uint64_t i, uint64_t e, int64_t cur, int64_t t) const {
+	while (i < e && (i & 7) != 0) {
+		cur += bp_bits.bit(i) ? 1 : -1;
+		++i;
+		if (cur <= t) return i;
+	}
+	for (;;) {
+		if ((i & 127) == 0 && i + 128 <= e) {
+			uint64_t w0 = bp_bits.word(i >> 6), w1 = bp_bits.word((i >> 6) + 1);
+			if (t - cur >= -128) {
+				uint32_t m = chunk_fwd_mask(w0, w1, (int)(t - cur));
+				if (m != 0) {
+					unsigned int j = lsb_intr(m);
+					return fwd_in_byte(chunk_byte(w0, w1, j), i + 8 * j,
+						cur + chunk_prefix(w0, w1, 8 * j), t);
+				}
+			}
+			cur += chunk_exc(w0, w1);
+			i += 128;
+		} else if (i + 8 <= e) {
+			uint8_t c = bp_bits.byte(i >> 3);
+			if (cur + byte_min(c) <= t) return fwd_in_byte(c, i, cur, t);
+			cur += byte_exc(c);
+			i += 8;
+		} else break;
+	}
+	while (i < e) {
+		cur += bp_bits.bit(i) ? 1 : -1;
+		++i;
+		if (cur <= t) return i;
+	}
+	return NOTFOUND;
+}
+
+uint64_t BP_rmm::bwd_scan(uint64_t s, uint64_t i, int64_t cur, int64_t t) const {
+	while (i > s && (i & 7) != 0) {
+		--i;
+		cur -= bp_bits.bit(i) ? 1 : -1;
+		if (cur <= t) return i;
+	}
+	for (;;) {
+		if ((i & 127) == 0 && i >= s + 128) {
+			uint64_t cs = i - 128;
+			uint64_t w0 = bp_bits.word(cs >> 6), w1 = bp_bits.word((cs >> 6) + 1);
+			int64_t ecs = cur - chunk_exc(w0, w1);
+			if (t - ecs >= -128) {
+				uint32_t m = chunk_bwd_mask(w0, w1, (int)(t - ecs));
+				if (m != 0) {
+					unsigned int j = msb_intr(m);
+					return bwd_in_byte(chunk_byte(w0, w1, j), cs + 8 * j,
+						ecs + chunk_prefix(w0, w1, 8 * j + 8), t);
+				}
+			}
+			cur = ecs;
+			i = cs;
+		} else if (i >= s + 8) {
+			uint8_t c = bp_bits.byte((i - 8) >> 3);
+			int64_t before = cur - byte_exc(c);
+			if (std::min<int64_t>(before, before + byte_min(c)) <= t)
+				return bwd_in_byte(c, i - 8, cur, t);
+			cur = before;
+			i -= 8;
+		} else break;
+	}
+	while (i > s) {
+		--i;
+		cur -= bp_bits.bit(i) ? 1 : -1;
+		if (cur <= t) return i;
+	}
+	return NOTFOUND;
+}
+
+int64_t BP_rmm::range_min(uint64_t s, uint64_t e) const {
+	int64_t cur = excess(s), m = cur;
+	uint64_t i = s;
+	while (i < e && (i & 7) != 0) {
+		cur += bp_bits.bit(i) ? 1 : -1;
+		m = std::min(m, cur);
+		++i;
+	}
+	for (;;) {
+		if ((i & 127) == 0 && i + 128 <= e) {
+			uint64_t w0 = bp_bits.word(i >> 6), w1 = bp_bits.word((i >> 6) + 1);
+			m = std::min<int64_t>(m, cur + chunk_min(w0, w1));
+			cur += chunk_exc(w0, w1);
+			i += 128;
+		} else if (i + 8 <= e) {
+			uint8_t c = bp_bits.byte(i >> 3);
+			m = std::min<int64_t>(m, cur + byte_min(c));
+			cur += byte_exc(c);
+			i += 8;
+		} else break;
+	}
+	while (i < e) {
+		cur += bp_bits.bit(i) ? 1 : -1;
+		m = std::min(m, cur);
+		++i;
+	}
+	return m;
+}
+
+//------------------------------------------------------------------------------
+
+uint64_t BP_rmm::fwd_search(uint64_t i, int64_t d) const {
+	assert(d < 0);
+	uint64_t n = length();
+	if (i >= n) return NOTFOUND;
+	int64_t t = excess(i) + d;
+	uint64_t b = i / blksize;
+	uint64_t j = fwd_scan(i, leaf_end(b), excess(i), t);
+	if (j != NOTFOUND) return j;
+	// go up until a right sibling contains the answer
+	uint64_t v = nleaf2 + b;
+	for (;;) {
+		if (v == 1) return NOTFOUND;
+		if ((v & 1) == 0) {
+			uint64_t s = node_start(v + 1);
+			if (s < n && excess(s) + node_min(v + 1) <= t) { ++v; break; }
+		}
+		v >>= 1;
+	}
+	// go down to the leftmost leaf that contains it
+	while (v < nleaf2) {
+		uint64_t l = 2 * v;
+		v = (excess(node_start(l)) + node_min(l) <= t) ? l : l + 1;
+	}
+	b = v - nleaf2;
+	uint64_t s = b * blksize;
+	return fwd_scan(s, leaf_end(b), excess(s), t);
+}
+
+uint64_t BP_rmm::bwd_search(uint64_t i, int64_t d) const {
+	assert(d < 0);
+	uint64_t n = length();
+	if (i == 0 || i > n) return NOTFOUND;
+	int64_t t = excess(i) + d;
+	uint64_t b = (i - 1) / blksize;
+	uint64_t j = bwd_scan(b * blksize, i, excess(i), t);
+	if (j != NOTFOUND) return j;
+	// go up until a left sibling contains the answer
+	uint64_t v = nleaf2 + b;
+	for (;;) {
+		if (v == 1) return NOTFOUND;
+		if ((v & 1) != 0 && excess(node_start(v - 1)) + node_min(v - 1) <= t) { --v; break; }
+		v >>= 1;
+	}
+	// go down to the rightmost leaf that contains it
+	while (v < nleaf2) {
+		uint64_t r = 2 * v + 1, s = node_start(r);
+		v = (s < n && excess(s) + node_min(r) <= t) ? r : r - 1;
+	}
+	b = v - nleaf2;
+	uint64_t e = leaf_end(b);
+	return bwd_scan(b * blksize, e, excess(e), t);
+}
+
+uint64_t BP_rmm::last_min_in_node(uint64_t v, int64_t m) const {
+	uint64_t n = length();
+	while (v < nleaf2) {
+		uint64_t r = 2 * v + 1, s = node_start(r);
+		v = (s < n && excess(s) + node_min(r) <= m) ? r : r - 1;
+	}
+	uint64_t b = v - nleaf2, e = leaf_end(b);
+	int64_t ee = excess(e);
+	if (ee <= m) return e;
+	return bwd_scan(b * blksize, e, ee, m);
+}
+
+uint64_t BP_rmm::min_excess_last(uint64_t l, uint64_t r) const {
+	assert(l <= r && r <= length());
+	if (l == r) return l;
+	uint64_t bl = l / blksize, br = r / blksize;
+	if (br <= bl + 1) {
+		int64_t m = range_min(l, r), er = excess(r);
+		return (er <= m) ? r : bwd_scan(l, r, er, m);
+	}
+	uint64_t lend = (bl + 1) * blksize, rst = br * blksize;
+	int64_t ml = range_min(l, lend), mr = range_min(rst, r);
+	uint64_t nodes[130];
+	unsigned int nl = cover_nodes(bl + 1, br - 1, nodes);
+	int64_t vals[130];
+	int64_t m = std::min(ml, mr);
+	for (unsigned int k = 0; k < nl; ++k) {
+		vals[k] = excess(node_start(nodes[k])) + node_min(nodes[k]);
+		m = std::min(m, vals[k]);
+	}
+	// the right-most part that reaches the minimum contains the answer
+	if (mr <= m) {
+		int64_t er = excess(r);
+		return (er <= m) ? r : bwd_scan(rst, r, er, m);
+	}
+	for (unsigned int k = nl; k > 0; --k)
+		if (vals[k - 1] <= m) return last_min_in_node(nodes[k - 1], m);
+	int64_t ee = excess(lend);
+	return (ee <= m) ? lend : bwd_scan(l, lend, ee, m);
+}
+
+uint64_t BP_rmm::count_scan(uint64_t i, uint64_t e, int64_t t) const {
+	int64_t cur = excess(i);
+	uint64_t c = 0;
+	while (i < e && (i & 7) != 0) {
+		cur += bp_bits.bit(i) ? 1 : -1;
+		++i;
+		if (cur == t) ++c;
+	}
+	while (i + 8 <= e) {
+		uint8_t x = bp_bits.byte(i >> 3);
+		if (cur + byte_min(x) == t) {
+			for (unsigned int k = 0; k < 8; ++k) {
+				cur += ((x >> k) & 1) ? 1 : -1;
+				if (cur == t) ++c;
+			}
+		} else
+			cur += byte_exc(x);
+		i += 8;
+	}
+	while (i < e) {
+		cur += bp_bits.bit(i) ? 1 : -1;
+		++i;
+		if (cur == t) ++c;
+	}
+	return c;
+}
+
+// finds the k-th position that reaches t, or decreases k by the number of those positions
+uint64_t BP_rmm::select_scan(uint64_t i, uint64_t e, int64_t t, uint64_t& k) const {
+	int64_t cur = excess(i);
+	while (i < e && (i & 7) != 0) {
+		cur += bp_bits.bit(i) ? 1 : -1;
+		++i;
+		if (cur == t && --k == 0) return i;
+	}
+	while (i + 8 <= e) {
+		uint8_t x = bp_bits.byte(i >> 3);
+		if (cur + byte_min(x) == t) {
+			for (unsigned int j = 0; j < 8; ++j) {
+				cur += ((x >> j) & 1) ? 1 : -1;
+				if (cur == t && --k == 0) return i + j + 1;
+			}
+		} else
+			cur += byte_exc(x);
+		i += 8;
+	}
+	while (i < e) {
+		cur += bp_bits.bit(i) ? 1 : -1;
+		++i;
+		if (cur == t && --k == 0) return i;
+	}
+	return NOTFOUND;
+}
+
+uint64_t BP_rmm::min_count(uint64_t l, uint64_t r, int64_t t) const {
+	assert(l <= r && r <= length());
+	uint64_t bl = l / blksize, br = r / blksize;
+	if (br <= bl + 1) return count_scan(l, r, t);
+	uint64_t lend = (bl + 1) * blksize, rst = br * blksize;
+	uint64_t c = count_scan(l, lend, t) + count_scan(rst, r, t);
+	uint64_t nodes[130];
+	unsigned int nl = cover_nodes(bl + 1, br - 1, nodes);
+	for (unsigned int k = 0; k < nl; ++k)
+		c += node_count(nodes[k], t);
+	return c;
+}
+
+uint64_t BP_rmm::min_select(uint64_t l, uint64_t r, int64_t t, uint64_t k) const {
+	assert(l <= r && r <= length());
+	if (k == 0) return NOTFOUND;
+	uint64_t bl = l / blksize, br = r / blksize;
+	if (br <= bl + 1) return select_scan(l, r, t, k);
+	uint64_t lend = (bl + 1) * blksize, rst = br * blksize;
+	uint64_t j = select_scan(l, lend, t, k);
+	if (j != NOTFOUND) return j;
+	uint64_t nodes[130];
+	unsigned int nl = cover_nodes(bl + 1, br - 1, nodes);
+	for (unsigned int q = 0; q < nl; ++q) {
+		uint64_t v = nodes[q], c = node_count(v, t);
+		if (k > c) {
+			k -= c;
+			continue;
+		}
+		// go down to the leaf that contains the k-th position
+		while (v < nleaf2) {
+			uint64_t cl = node_count(2 * v, t);
+			if (k <= cl) v = 2 * v;
+			else {
+				k -= cl;
+				v = 2 * v + 1;
+			}
+		}
+		uint64_t b = v - nleaf2;
+		return select_scan(b * blksize, leaf_end(b), t, k);
+	}
+	return select_scan(rst, r, t, k);
+}
+
+//------------------------------------------------------------------------------
+
+uint64_t BP_rmm::find_close(uint64_t p) const {
+	assert(p < length());
+	if (!bit(p)) return p;
+	uint64_t j = fwd_search(p + 1, -1);
+	return j != NOTFOUND ? j - 1 : NOTFOUND;
+}
+
+uint64_t BP_rmm::find_open(uint64_t p) const {
+	assert(p < length());
+	if (bit(p)) return p;
+	return bwd_search(p, -1);
+}
+
+uint64_t BP_rmm::enclose(uint64_t p) const {
+	if (p >= length()) return NOTFOUND;
+	if (!bit(p)) return find_open(p);
+	return bwd_search(p, -1);
+}
+
+uint64_t BP_rmm::min_excess_pos(uint64_t l, uint64_t r) const {
+	if (l >= r || r >= length()) return NOTFOUND;
+	// the last minimum is followed by an open parenthesis, except when it is r
+	uint64_t k = min_excess_last(l, r);
+	return (k < r) ? k : NOTFOUND;
+}
+
+uint64_t BP_rmm::rr_enclose(uint64_t i, uint64_t j) const {
+	assert(i < j && j < length());
+	assert(bit(i) && bit(j));
+	return min_excess_pos(find_close(i) + 1, j);
+}
+
+std::string BP_rmm::to_str() const {
+	assert(length() < (1UL << 16));
+	std::ostringstream ss;
+	for (size_t i = 0; i < length(); i++) {
+		if (i % blksize == 0 && i > 0) ss << '-';
+		if (bit(i)) ss << '(';
+		else ss << ')';
+	}
+	ss << '\n';
+	return ss.str();
+}
+
+OutArchive& BP_rmm::save(OutArchive& ar) const {
+	ar.startclass("BP_rmm", 2);
+	ar.var("blksize").save(blksize);
+	bp_bits.save(ar.var("bp_bits"));
+	bprank.save_aux(ar.var("bps"));
+	leafmin.save(ar.var("leaf_min"));
+	nodemin.save(ar.var("node_min"));
+	leafcnt.save(ar.var("leaf_count"));
+	nodecnt.save(ar.var("node_count"));
+	ar.endclass();
+	return ar;
+}
+
+InpArchive& BP_rmm::load(InpArchive& ar) {
+	clear();
+	int class_version = ar.loadclass("BP_rmm");
+	ar.var("blksize").load(blksize);
+	bp_bits.load(ar.var("bp_bits"));
+	bprank.load_aux(ar.var("bps"), &bp_bits);
+	leafmin.load(ar.var("leaf_min"));
+	nodemin.load(ar.var("node_min"));
+	if (class_version >= 2) {
+		leafcnt.load(ar.var("leaf_count"));
+		nodecnt.load(ar.var("node_count"));
+	}
+	ar.endclass();
+	init_tree();
+	// older versions have no counts, they are computed from the minimums
+	if (class_version < 2) init_counts();
+	return ar;
+}
+
+} //namespace
@@ -0,0 +1,113 @@
+#pragma once
+
+#ifndef __BALANCE_PARATHESIS_RMM_TREE_H_
+#define __BALANCE_PARATHESIS_RMM_TREE_H_
+
+/**  \file
+
+Balanced parentheses operations using a range min tree.
+
+The bit vector is split into leaf blocks; a complete binary tree over the
+blocks stores the minimum excess of every node (relative to the start of the
+node). Searches scan the starting block, go up the tree until a node can
+contain the answer, and go down to the leaf block that contains it. Scanning
+inside a block works on 128-bit chunks: the excess and minimum excess of each
+byte are computed with nibble lookup tables and a byte-wise prefix sum (SSSE3
+when it is available).
+
+Every node also stores the number of positions (after its first bit) that
+reach its minimum, which gives min_count/min_select (used for the degree and the
+i-th child of a node) in logarithmic time.
+
+The class has the same interface as BP_aux and can be used in its place.
+
+Based on:
+
+  K. Sadakane and G. Navarro. Fully-Functional Succinct Trees. SODA 2010.
+
+*/
+
+#include "bitarray/bitarray.h"
+#include "bitarray/rank6p.h"
+
+#include <stdint.h>
+#include <string>
+
+#include "framework/archive.h"
+
+namespace mscds {
+
+/// balanced parentheses operations using a range min tree (rmM-tree)
+class BP_rmm {
+public:
+	BP_rmm(): blksize(0), nleaf(0), nleaf2(0) {}
+	~BP_rmm() { clear(); }
+	/** \brief builds the auxiliary data, `blksize' is rounded up to a multiple of 128.
+	Returns the height of the tree. */
+	unsigned int build(const BitArray& bp, unsigned int blksize = 256);
+	void clear();
+
+	static const uint64_t NOTFOUND = 0xFFFFFFFFFFFFFFFFull;
+public:
+	uint64_t rank(uint64_t i) const { return bprank.rank(i); }
+	uint64_t select(uint64_t i) const { return bprank.select(i); }
+	/** \brief excess of the prefix [0..i) */
+	int64_t excess(uint64_t i) const
+		{ return (int64_t)bprank.rank(i) * 2 - i; }
+	uint64_t find_match(uint64_t p) const
+		{ return (bit(p)?find_close(p):find_open(p)); }
+	bool bit(uint64_t p) const { return bprank.access(p); }
+	size_t length() const { return bprank.length(); }
+	const BitArray& bit_array() const { return bp_bits; }
+	std::string to_str() const;
+
+	uint64_t find_close(uint64_t p) const;
+	uint64_t find_open(uint64_t p) const;
+	uint64_t enclose(uint64_t p) const;
+	uint64_t rr_enclose(uint64_t i, uint64_t j) const;
+	uint64_t min_excess_pos(uint64_t l, uint64_t r) const;
+
+	/** \brief smallest j > i such that excess(j) == excess(i) + d, (d < 0) */
+	uint64_t fwd_search(uint64_t i, int64_t d) const;
+	/** \brief largest j < i such that excess(j) == excess(i) + d, (d < 0) */
+	uint64_t bwd_search(uint64_t i, int64_t d) const;
+	/** \brief the last position j in [l..r] with the minimum excess(j) */
+	uint64_t min_excess_last(uint64_t l, uint64_t r) const;
+	/** \brief number of positions j in (l..r] with excess(j) == t, where t is the
+	minimum excess of [l..r] (or lower) */
+	uint64_t min_count(uint64_t l, uint64_t r, int64_t t) const;
+	/** \brief the k-th (from 1) position j in (l..r] with excess(j) == t (same
+	condition as min_count), NOTFOUND if there are fewer than k */
+	uint64_t min_select(uint64_t l, uint64_t r, int64_t t, uint64_t k) const;
+
+	OutArchive& save(OutArchive& ar) const;
+	InpArchive& load(InpArchive& ar);
+private:
+	int64_t node_min(uint64_t v) const;
+	uint64_t node_start(uint64_t v) const;
+	uint64_t leaf_end(uint64_t b) const;
+	void init_tree();
+	void init_counts();
+	uint64_t node_count(uint64_t v, int64_t t) const;
+	unsigned int cover_nodes(uint64_t bl, uint64_t br, uint64_t* nodes) const;
+
+	uint64_t fwd_scan(uint64_t i, uint64_t e, int64_t cur, int64_t t) const;
+	uint64_t bwd_scan(uint64_t s, uint64_t i, int64_t cur, int64_t t) const;
+	int64_t range_min(uint64_t s, uint64_t e) const;
+	uint64_t count_scan(uint64_t i, uint64_t e, int64_t t) const;
+	uint64_t select_scan(uint64_t i, uint64_t e, int64_t t, uint64_t& k) const;
+	uint64_t last_min_in_node(uint64_t v, int64_t m) const;
+
+	BitArray bp_bits;
+	Rank6pAux bprank;
+	FixedWArray leafmin, nodemin;
+	FixedWArray leafcnt, nodecnt;
+
+	unsigned int blksize;
+	uint64_t nleaf, nleaf2;
+	unsigned int height;
+};
+
+} //namespace
+
+#endif //__BALANCE_PARATHESIS_RMM_TREE_H_
@@ -196,9 +196,72 @@ void RMQ_pm1::load_aux(InpArchive &ar, const BitArrayInterface* barr) {
 	ar.endclass();
 }
 
+void RMQ_pm1::m_idx_batch(const std::vector<std::pair<size_t, size_t> >& ranges, std::vector<size_t>* out) const {
+	out->resize(ranges.size());
+	for (size_t k = 0; k < ranges.size(); ++k) {
+		size_t st = ranges[k].first, ed = ranges[k].second;
+		if (st < ed && ed - st <= SCAN_LIMIT)
+			(*out)[k] = scan_idx(st, ed);
+		else
+			(*out)[k] = m_idx(st, ed);
+	}
+}
+
+// scans the words of [st, ed), the first minimum (maximum) is returned like in m_idx;
+// only the excess relative to `st' is needed, so there is no rank query
+size_t RMQ_pm1::scan_idx(size_t st, size_t ed) const {
+	const BitArrayInterface* b = bits.getBitArray();
+	int base = 0;
+	int best = 0;
+	size_t bpos = st;
+	for (size_t p = st; p < ed; ) {
+		size_t wp = p / WORDSIZE;
+		size_t we = std::min<size_t>(ed, (wp + 1) * WORDSIZE);
+		uint8_t s = (uint8_t)(p - wp * WORDSIZE), e = (uint8_t)(we - wp * WORDSIZE);
+		uint64_t w = b->word(wp);
+		std::pair<int8_t, uint8_t> r = _min_struct ? min_excess_word(w, s, e) : max_excess_word(w, s, e);
+		int v = base + r.first;
+		if (p == st || (_min_struct ? v < best : v > best)) {
+			best = v;
+			bpos = wp * WORDSIZE + r.second;
+		}
+		uint64_t seg = w >> s;
+		if (e - s < WORDSIZE) seg &= (1ull << (e - s)) - 1;
+		base += 2 * (int)popcnt(seg) - (e - s);
+		p = we;
+	}
+	return bpos;
+}
+
 void RMQ_pm1_minmax::build(BitArray b, unsigned int blksize, RMQ_pm1_minmax *out) {
 	RMQ_pm1::build(b, blksize, true, &(out->minidx));
-	RMQ_pm1::build(b, blksize, true, &(out->maxidx));
+	RMQ_pm1::build(b, blksize, false, &(out->maxidx));
+}
+
+std::pair<int, size_t> RMQ_pm1_minmax::find_max(size_t st, size_t ed) const {
+	size_t p = maxidx.m_idx(st, ed);
+	return std::pair<int, size_t>(maxidx.excess(p), p);
+}
+
+std::pair<int, size_t> RMQ_pm1_minmax::find_min(size_t st, size_t ed) const {
+	size_t p = minidx.m_idx(st, ed);
+	return std::pair<int, size_t>(minidx.excess(p), p);
+}
+
+void RMQ_pm1_minmax::find_max_batch(const std::vector<std::pair<size_t, size_t> >& ranges, std::vector<std::pair<int, size_t> >* out) const {
+	std::vector<size_t> pos;
+	maxidx.m_idx_batch(ranges, &pos);
+	out->resize(pos.size());
+	for (size_t i = 0; i < pos.size(); ++i)
+		(*out)[i] = std::pair<int, size_t>(maxidx.excess(pos[i]), pos[i]);
+}
+
+void RMQ_pm1_minmax::find_min_batch(const std::vector<std::pair<size_t, size_t> >& ranges, std::vector<std::pair<int, size_t> >* out) const {
+	std::vector<size_t> pos;
+	minidx.m_idx_batch(ranges, &pos);
+	out->resize(pos.size());
+	for (size_t i = 0; i < pos.size(); ++i)
+		(*out)[i] = std::pair<int, size_t>(minidx.excess(pos[i]), pos[i]);
 }
 
 void RMQ_pm1_minmax::save_aux(OutArchive &ar) const {
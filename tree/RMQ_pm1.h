@@ -42,6 +42,9 @@ public:
 
 	size_t m_idx(size_t st, size_t ed) const;
 	int excess(size_t i) const;
+	/** \brief m_idx of many windows [first, second) (e.g. consecutive windows), short
+	windows are scanned a word at a time instead of using the block index */
+	void m_idx_batch(const std::vector<std::pair<size_t, size_t> >& ranges, std::vector<size_t>* out) const;
 
 	//std::string to_str() const;
 
@@ -50,6 +53,9 @@ public:
 	void clear() { bits.clear(); blks.clear(); }
 
 private:
+	/// windows with at most this number of bits are scanned by m_idx_batch
+	static const size_t SCAN_LIMIT = 512;
+	size_t scan_idx(size_t st, size_t ed) const;
 	size_t getpos(unsigned int wpos, uint8_t st, uint8_t ed) const;
 	void checkpos(const std::vector<unsigned int>& blkpos, std::vector<unsigned int>* out) const;
 	size_t validate(std::vector<unsigned int>& pos) const;
@@ -66,6 +72,10 @@ public:
 	static void build(BitArray b, unsigned int blksize, RMQ_pm1_minmax* out);
 	std::pair<int, size_t> find_max(size_t st, size_t ed) const;
 	std::pair<int, size_t> find_min(size_t st, size_t ed) const;
+	/** \brief find_max of many windows, see RMQ_pm1::m_idx_batch */
+	void find_max_batch(const std::vector<std::pair<size_t, size_t> >& ranges, std::vector<std::pair<int, size_t> >* out) const;
+	/** \brief find_min of many windows, see RMQ_pm1::m_idx_batch */
+	void find_min_batch(const std::vector<std::pair<size_t, size_t> >& ranges, std::vector<std::pair<int, size_t> >* out) const;
 
 	void save_aux(OutArchive& ar) const;
 	void load_aux(InpArchive& ar, const BitArrayInterface* rs);
@@ -1,16 +1,48 @@
 #include "RMQ_sct.h"
 
+#include "bitarray/bitop.h"
+
 #include <stack>
 #include <vector>
 
 namespace mscds {
-	size_t RMQ_sct::m_idx(size_t st, size_t ed) const {
+
+	namespace {
+		/// minimum excess before the bits 0..7 of a byte and its last position
+		struct PrefixMinTable {
+			int8_t mn[256];
+			uint8_t pos[256];
+			PrefixMinTable() {
+				for (unsigned int c = 0; c < 256; ++c) {
+					int cur = 0, m = 0;
+					unsigned int p = 0;
+					for (unsigned int k = 0; k < 8; ++k) {
+						if (cur <= m) { m = cur; p = k; }
+						cur += ((c >> k) & 1) ? 1 : -1;
+					}
+					mn[c] = (int8_t)m;
+					pos[c] = (uint8_t)p;
+				}
+			}
+		};
+
+		const PrefixMinTable& prefix_min_table() {
+			static const PrefixMinTable tbl;
+			return tbl;
+		}
+	}
+
+	template<typename BPAux>
+	size_t RMQ_sct_t<BPAux>::m_idx(size_t st, size_t ed) const {
 		if (st >= ed) return st;
 		ed--;
 		assert(st <= ed && ed < length());
 		if (st == ed) return st;
-		size_t i = bp.select(st);
-		size_t j = bp.select(ed);
+		return m_idx_pos(st, ed, bp.select(st), bp.select(ed));
+	}
+
+	template<typename BPAux>
+	size_t RMQ_sct_t<BPAux>::m_idx_pos(size_t st, size_t ed, size_t i, size_t j) const {
 		size_t fstclose = bp.find_close(i);
 		if (j < fstclose) {
 			return st;
@@ -19,13 +51,103 @@ namespace mscds {
 			if (p != BP_block::NOTFOUND)
 				return bp.rank(p);
 			else
-				return ed;		
+				return ed;
+		}
+	}
+
+	// position of the k-th open parenthesis after the one at p
+	template<typename BPAux>
+	size_t RMQ_sct_t<BPAux>::next_open(size_t p, size_t k) const {
+		if (k == 0) return p;
+		const BitArray& b = bp.bit_array();
+		size_t q = p + 1;
+		uint64_t w = b.word(q >> 6) >> (q & 63);
+		for (;;) {
+			size_t c = popcnt(w);
+			if (c >= k) return q + selectword(w, k - 1);
+			k -= c;
+			q = (q | 63) + 1;
+			w = b.word(q >> 6);
 		}
 	}
 
-	size_t RMQ_sct::length() const {
+	// The answer is the last position with the minimum excess between the
+	// nodes of `st' and `ed-1' (it is always an open parenthesis).
+	template<typename BPAux>
+	size_t RMQ_sct_t<BPAux>::scan_window(size_t st, size_t ed, size_t i, size_t* j) const {
+		const BitArray& b = bp.bit_array();
+		const PrefixMinTable& tbl = prefix_min_table();
+		size_t need = ed - st, seen = 0, p = i, best_idx = st;
+		int64_t cur = 0, best = 0;
+		for (; (p & 7) != 0; ++p) {
+			if (cur <= best) { best = cur; best_idx = st + seen; }
+			if (b.bit(p)) {
+				if (++seen == need) { *j = p; return best_idx; }
+				++cur;
+			} else --cur;
+		}
+		for (;; p += 8) {
+			uint8_t c = b.byte(p >> 3);
+			unsigned int pc = popcnt(c);
+			if (seen + pc >= need) break;
+			if (cur + tbl.mn[c] <= best) {
+				best = cur + tbl.mn[c];
+				best_idx = st + seen + popcnt(c & ((1u << tbl.pos[c]) - 1));
+			}
+			seen += pc;
+			cur += 2 * (int)pc - 8;
+		}
+		for (;; ++p) {
+			if (cur <= best) { best = cur; best_idx = st + seen; }
+			if (b.bit(p)) {
+				if (++seen == need) { *j = p; return best_idx; }
+				++cur;
+			} else --cur;
+		}
+	}
+
+	template<typename BPAux>
+	void RMQ_sct_t<BPAux>::m_idx_batch(const std::vector<std::pair<size_t, size_t> >& ranges, std::vector<size_t>* out) const {
+		out->resize(ranges.size());
+		// the node of the last element of the previous window
+		size_t cidx = 0, cpos = 0;
+		bool cursor = false;
+		for (size_t k = 0; k < ranges.size(); ++k) {
+			size_t st = ranges[k].first, ed = ranges[k].second;
+			if (st + 1 >= ed) { (*out)[k] = st; continue; }
+			assert(ed <= length());
+			size_t i, j;
+			if (cursor && cidx <= st && st - cidx <= SCAN_LIMIT)
+				i = next_open(cpos, st - cidx);
+			else
+				i = bp.select(st);
+			if (ed - st <= SCAN_LIMIT) {
+				(*out)[k] = scan_window(st, ed, i, &j);
+			} else {
+				j = bp.select(ed - 1);
+				(*out)[k] = m_idx_pos(st, ed - 1, i, j);
+			}
+			cidx = ed - 1;
+			cpos = j;
+			cursor = true;
+		}
+	}
+
+	template<typename BPAux>
+	void RMQ_sct_t<BPAux>::m_idx_batch(const std::vector<size_t>& bounds, std::vector<size_t>* out) const {
+		std::vector<std::pair<size_t, size_t> > ranges;
+		for (size_t k = 1; k < bounds.size(); ++k)
+			ranges.push_back(std::make_pair(bounds[k - 1], bounds[k]));
+		m_idx_batch(ranges, out);
+	}
+
+	template<typename BPAux>
+	size_t RMQ_sct_t<BPAux>::length() const {
 		return bp.length() / 2;
 	}
 
+	template class RMQ_sct_t<BP_aux>;
+	template class RMQ_sct_t<BP_rmm>;
+
 
-}//namespace
\ No newline at end of file
+}//namespace
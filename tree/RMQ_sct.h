@@ -12,8 +12,11 @@ based on super cartisian tree.
 */
 
 #include "BP_bits.h"
+#include "BP_rmm.h"
 #include <cassert>
 #include <stack>
+#include <vector>
+#include <utility>
 
 namespace mscds {
 
@@ -26,9 +29,10 @@ E. Ohlebusch and S. Gog. A Compressed Enhanced Suffix Array Supporting Fast Stri
 template<typename RandomAccessIterator>
 BitArray build_supercartisian_tree(bool minimum_tree, RandomAccessIterator first, RandomAccessIterator last);
 
-/// succinct RMQ data structure
-class RMQ_sct {
-	BP_aux bp;
+/// succinct RMQ data structure, `BPAux' is BP_aux or BP_rmm
+template<typename BPAux>
+class RMQ_sct_t {
+	BPAux bp;
 public:
 	template<typename T>
 	void build(const T& arr, bool minstr = true, unsigned int blksize = 256) {
@@ -40,6 +44,13 @@ public:
 	}
 
 	size_t m_idx(size_t st, size_t ed) const;
+	/** \brief m_idx of many windows [first, second). When the windows are sorted
+	(both ends non-decreasing) they are answered in one left to right sweep: short
+	windows are scanned a byte at a time from the end of the previous one, long
+	ones use the tree. */
+	void m_idx_batch(const std::vector<std::pair<size_t, size_t> >& ranges, std::vector<size_t>* out) const;
+	/** \brief m_idx of the windows [bounds[k], bounds[k+1]), `bounds' is sorted */
+	void m_idx_batch(const std::vector<size_t>& bounds, std::vector<size_t>* out) const;
 	//size_t psv(size_t p) const;
 	//size_t nsv(size_t p) const;
 	size_t length() const;
@@ -47,8 +58,18 @@ public:
 	void save(OutArchive& ar) const { bp.save(ar); }
 	void load(InpArchive& ar) { bp.load(ar); }
 	void clear() {bp.clear();}
+private:
+	/// windows with at most this number of elements are scanned
+	static const size_t SCAN_LIMIT = 512;
+	size_t m_idx_pos(size_t st, size_t ed, size_t i, size_t j) const;
+	size_t next_open(size_t p, size_t k) const;
+	size_t scan_window(size_t st, size_t ed, size_t i, size_t* j) const;
 };
 
+typedef RMQ_sct_t<BP_aux> RMQ_sct;
+/// RMQ_sct using the range min tree
+typedef RMQ_sct_t<BP_rmm> RMQ_sct_rmm;
+
 template<typename RandomAccessIterator>
 inline BitArray build_supercartisian_tree(bool minimum_tree, RandomAccessIterator first, RandomAccessIterator last) {
 	BitArray bp = BitArrayBuilder::create(2 * std::distance(first, last));
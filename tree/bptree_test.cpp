@@ -1,4 +1,5 @@
 #include "BP_bits.h"
+#include "BP_rmm.h"
 
 #include <iomanip>
 #include <stack>
@@ -371,6 +372,105 @@ TEST(BP_tree, random_long) {
 	cout << endl;
 }
 
+void test_bp_rmm(BitArray b, unsigned int blksize, unsigned int nquery = 200) {
+	stack<int> pos;
+	vector<int> match(b.length()), enclose(b.length());
+	vector<int64_t> ex(b.length() + 1);
+	ex[0] = 0;
+	for (unsigned i = 0; i < b.length(); i++) {
+		ex[i + 1] = ex[i] + (b[i] ? 1 : -1);
+		if (b[i]) {
+			enclose[i] = pos.empty() ? -1 : pos.top();
+			pos.push(i);
+		} else {
+			int t = pos.top();
+			pos.pop();
+			match[i] = t;
+			match[t] = i;
+			enclose[i] = t;
+		}
+	}
+	BP_rmm bps;
+	bps.build(b, blksize);
+	OMemArchive out;
+	bps.save(out);
+	out.close();
+	bps.clear();
+	IMemArchive inp(out);
+	bps.load(inp);
+
+	for (unsigned i = 0; i < b.length(); i++) {
+		ASSERT_EQ(match[i], bps.find_match(i));
+		if (enclose[i] >= 0) ASSERT_EQ(enclose[i], bps.enclose(i));
+		else ASSERT_EQ(BP_rmm::NOTFOUND, bps.enclose(i));
+	}
+	BP_block blkx(b, b.length());
+	for (unsigned k = 0; k < nquery; k++) {
+		uint64_t i = rand() % (b.length() + 1);
+		int64_t d = -1 - (int64_t)(rand() % 8);
+		uint64_t exp = BP_rmm::NOTFOUND;
+		for (uint64_t j = i + 1; j <= b.length(); ++j)
+			if (ex[j] == ex[i] + d) { exp = j; break; }
+		ASSERT_EQ(exp, bps.fwd_search(i, d));
+		exp = BP_rmm::NOTFOUND;
+		for (uint64_t j = i; j > 0; --j)
+			if (ex[j - 1] == ex[i] + d) { exp = j - 1; break; }
+		ASSERT_EQ(exp, bps.bwd_search(i, d));
+
+		uint64_t l = rand() % b.length(), r = rand() % b.length();
+		if (l > r) std::swap(l, r);
+		ASSERT_EQ(blkx.min_excess_pos_slow(l, r), bps.min_excess_pos(l, r));
+		uint64_t lm = l;
+		for (uint64_t j = l; j <= r; ++j)
+			if (ex[j] <= ex[lm]) lm = j;
+		ASSERT_EQ(lm, bps.min_excess_last(l, r));
+
+		int64_t t = ex[lm] - (int64_t)(rand() % 2);
+		vector<uint64_t> hits;
+		for (uint64_t j = l + 1; j <= r; ++j)
+			if (ex[j] == t) hits.push_back(j);
+		ASSERT_EQ(hits.size(), bps.min_count(l, r, t));
+		for (uint64_t q = 1; q <= hits.size() + 1; ++q) {
+			exp = q <= hits.size() ? hits[q - 1] : BP_rmm::NOTFOUND;
+			ASSERT_EQ(exp, bps.min_select(l, r, t, q));
+		}
+	}
+}
+
+TEST(BP_tree, rmm_random) {
+	test_bp_rmm(str2bits("()(()())(())()()"), 128);
+	test_bp_rmm(str2bits("((()(()()(()))(((((())))()())()(())))())"), 128);
+	for (int i = 0; i < 200; i++)
+		test_bp_rmm(generate_BPS(2 + 2 * (rand() % 600)), 128);
+	for (int i = 0; i < 5; i++) {
+		test_bp_rmm(generate_BPS(100000), 128);
+		test_bp_rmm(generate_BPS(100002), 256);
+	}
+	// long chains cross many blocks
+	string deep = string(30000, '(') + string(30000, ')') + "(" + string(5000, '(') + string(5000, ')') + ")";
+	test_bp_rmm(str2bits(deep), 128, 50);
+	string wide;
+	for (int i = 0; i < 20000; i++) wide += "()";
+	test_bp_rmm(str2bits("(" + wide + ")" + wide), 256);
+}
+
+TEST(BP_tree, rmm_rmq) {
+	for (int k = 0; k < 20; k++) {
+		unsigned int len = 1 + rand() % 5000;
+		vector<int> vals(len);
+		for (unsigned int i = 0; i < len; i++) vals[i] = rand() % 100;
+		RMQ_sct sct;
+		RMQ_sct_rmm rmm;
+		sct.build(vals, true, 16);
+		rmm.build(vals, true);
+		for (int i = 0; i < 500; i++) {
+			unsigned int st = rand() % len, ed = rand() % (len + 1);
+			if (st > ed) std::swap(st, ed);
+			ASSERT_EQ(sct.m_idx(st, ed), rmm.m_idx(st, ed));
+		}
+	}
+}
+
 }//namespace
 
 /*
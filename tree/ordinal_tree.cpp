@@ -0,0 +1,112 @@
+#include "ordinal_tree.h"
+
+#include <stdexcept>
+
+namespace mscds {
+
+void OrdinalTreeBuilder::open() {
+	bits.put1();
+	nopen++;
+}
+
+void OrdinalTreeBuilder::close() {
+	if (nclose >= nopen) throw std::runtime_error("unbalanced parentheses");
+	bits.put0();
+	nclose++;
+}
+
+void OrdinalTreeBuilder::clear() {
+	bits.clear();
+	nopen = 0;
+	nclose = 0;
+}
+
+void OrdinalTreeBuilder::build(OrdinalTree* out) {
+	if (nopen != nclose) throw std::runtime_error("unbalanced parentheses");
+	bits.close();
+	BitArray b;
+	bits.build(&b);
+	build(b, out);
+	clear();
+}
+
+void OrdinalTreeBuilder::build(OutArchive& ar) {
+	OrdinalTree out;
+	build(&out);
+	out.save(ar);
+}
+
+void OrdinalTreeBuilder::build(const BitArray& bp, OrdinalTree* out) {
+	out->clear();
+	if (bp.length() > 0) {
+		out->bp.build(bp);
+		out->nnodes = bp.length() / 2;
+	}
+}
+
+//------------------------------------------------------------------------------
+
+const OrdinalTree::NodeTp OrdinalTree::NONE;
+
+OrdinalTree::NodeTp OrdinalTree::last_child(NodeTp x) const {
+	uint64_t c = bp.find_close(x);
+	if (c == x + 1) return NONE;
+	return bp.find_open(c - 1);
+}
+
+OrdinalTree::NodeTp OrdinalTree::next_sibling(NodeTp x) const {
+	uint64_t y = bp.find_close(x) + 1;
+	return (y < bp.length() && bp.bit(y)) ? y : NONE;
+}
+
+OrdinalTree::NodeTp OrdinalTree::prev_sibling(NodeTp x) const {
+	return (x > 0 && !bp.bit(x - 1)) ? bp.find_open(x - 1) : NONE;
+}
+
+// the children of x start at the positions of (x..close(x)) with excess depth(x) + 1,
+// which is the minimum excess inside x; close(x) has the same excess
+OrdinalTree::NodeTp OrdinalTree::child(NodeTp x, unsigned int i) const {
+	if (is_leaf(x)) return NONE;
+	if (i == 0) return x + 1;
+	uint64_t c = bp.find_close(x);
+	uint64_t y = bp.min_select(x + 1, c, bp.excess(x) + 1, i);
+	return (y == BP_rmm::NOTFOUND || y == c) ? NONE : y;
+}
+
+unsigned int OrdinalTree::degree(NodeTp x) const {
+	if (is_leaf(x)) return 0;
+	return (unsigned int) bp.min_count(x + 1, bp.find_close(x), bp.excess(x) + 1);
+}
+
+OrdinalTree::NodeTp OrdinalTree::lca(NodeTp x, NodeTp y) const {
+	if (x > y) std::swap(x, y);
+	if (x == y || y < bp.find_close(x)) return x;
+	// the outermost ancestor of y that starts after the subtree of x is
+	// a child of the lca
+	NodeTp k = bp.rr_enclose(x, y);
+	return parent(k != NONE ? k : y);
+}
+
+OrdinalTree::NodeTp OrdinalTree::level_ancestor(NodeTp x, uint64_t d) const {
+	if (d == 0) return x;
+	if (d > depth(x)) return NONE;
+	return bp.bwd_search(x, -(int64_t)d);
+}
+
+void OrdinalTree::save(OutArchive& ar) const {
+	ar.startclass("ordinal_tree", 1);
+	uint64_t n = size();
+	ar.var("size").save(n);
+	if (n > 0) bp.save(ar.var("bp"));
+	ar.endclass();
+}
+
+void OrdinalTree::load(InpArchive& ar) {
+	clear();
+	ar.loadclass("ordinal_tree");
+	ar.var("size").load(nnodes);
+	if (nnodes > 0) bp.load(ar.var("bp"));
+	ar.endclass();
+}
+
+}//namespace
@@ -0,0 +1,138 @@
+#pragma once
+
+#ifndef __SUCCINCT_ORDINAL_TREE_H_
+#define __SUCCINCT_ORDINAL_TREE_H_
+
+/**  \file
+
+Succinct ordinal tree using the balanced parentheses representation.
+
+A tree with n nodes takes 2n bits plus the range min tree of BP_rmm. A node is
+identified by the position of its opening parenthesis; the preorder number of
+a node (starting from 0 at the root) is the number of opening parentheses before
+it.
+
+*/
+
+#include "BP_rmm.h"
+#include "tree.h"
+#include "bitarray/bitstream.h"
+#include "framework/archive.h"
+
+#include <vector>
+#include <utility>
+
+namespace mscds {
+
+class OrdinalTree;
+
+/// Builder class for OrdinalTree, the nodes are given in depth-first order
+class OrdinalTreeBuilder {
+public:
+	OrdinalTreeBuilder() { clear(); }
+	/** \brief starts a node (its children follow until the matching close()) */
+	void open();
+	/** \brief finishes the last opened node */
+	void close();
+
+	void build(OrdinalTree* out);
+	void build(OutArchive& ar);
+	void clear();
+
+	/** \brief builds from a pointer-based tree, `labels' (if not NULL) receives
+	the node data in preorder */
+	template<typename T>
+	static void build(GTreeNode<T>* root, OrdinalTree* out, std::vector<T>* labels = NULL);
+	/** \brief builds from a balanced parentheses bit array (1 = open) */
+	static void build(const BitArray& bp, OrdinalTree* out);
+
+	typedef OrdinalTree QueryTp;
+private:
+	OBitStream bits;
+	uint64_t nopen, nclose;
+};
+
+/// Succinct ordinal tree
+class OrdinalTree {
+public:
+	typedef uint64_t NodeTp;
+	/// returned when the node does not exist
+	static const NodeTp NONE = BP_rmm::NOTFOUND;
+
+	OrdinalTree(): nnodes(0) {}
+
+	/** \brief number of nodes */
+	uint64_t size() const { return nnodes; }
+	NodeTp root() const { return size() > 0 ? 0 : NONE; }
+
+	bool is_leaf(NodeTp x) const { return !bp.bit(x + 1); }
+	/** \brief the root has depth 0 */
+	uint64_t depth(NodeTp x) const { return (uint64_t) bp.excess(x); }
+	/** \brief number of nodes in the subtree of x (including x) */
+	uint64_t subtree_size(NodeTp x) const { return (bp.find_close(x) - x + 1) / 2; }
+	/** \brief true if x is an ancestor of y, or x == y */
+	bool is_ancestor(NodeTp x, NodeTp y) const { return x <= y && y < bp.find_close(x); }
+
+	NodeTp parent(NodeTp x) const { return bp.enclose(x); }
+	NodeTp first_child(NodeTp x) const { return bp.bit(x + 1) ? x + 1 : NONE; }
+	NodeTp last_child(NodeTp x) const;
+	NodeTp next_sibling(NodeTp x) const;
+	NodeTp prev_sibling(NodeTp x) const;
+	/** \brief the i-th child (from 0) of x, NONE if x has fewer children */
+	NodeTp child(NodeTp x, unsigned int i) const;
+	/** \brief number of children */
+	unsigned int degree(NodeTp x) const;
+
+	/** \brief preorder number of x */
+	uint64_t preorder(NodeTp x) const { return bp.rank(x); }
+	/** \brief node with preorder number i */
+	NodeTp preorder_select(uint64_t i) const { return bp.select(i); }
+
+	/** \brief lowest common ancestor */
+	NodeTp lca(NodeTp x, NodeTp y) const;
+	/** \brief the ancestor of x that is d levels above it (d = 0 returns x) */
+	NodeTp level_ancestor(NodeTp x, uint64_t d) const;
+
+	void save(OutArchive& ar) const;
+	void load(InpArchive& ar);
+	void clear() { bp.clear(); nnodes = 0; }
+
+	const BP_rmm& bp_structure() const { return bp; }
+	typedef OrdinalTreeBuilder BuilderTp;
+private:
+	BP_rmm bp;
+	uint64_t nnodes;
+	friend class OrdinalTreeBuilder;
+};
+
+template<typename T>
+void OrdinalTreeBuilder::build(GTreeNode<T>* root, OrdinalTree* out, std::vector<T>* labels) {
+	OrdinalTreeBuilder bd;
+	if (labels != NULL) labels->clear();
+	if (root == NULL) {
+		bd.build(out);
+		return;
+	}
+	// iterative depth-first traversal (deep trees would overflow the call stack)
+	std::vector<std::pair<GTreeNode<T>*, size_t> > stack;
+	stack.emplace_back(root, 0);
+	bd.open();
+	if (labels != NULL) labels->push_back(root->data);
+	while (!stack.empty()) {
+		auto& top = stack.back();
+		if (top.second < top.first->children.size()) {
+			GTreeNode<T>* c = top.first->children[top.second++];
+			bd.open();
+			if (labels != NULL) labels->push_back(c->data);
+			stack.emplace_back(c, 0);
+		} else {
+			bd.close();
+			stack.pop_back();
+		}
+	}
+	bd.build(out);
+}
+
+}//namespace
+
+#endif //__SUCCINCT_ORDINAL_TREE_H_
@@ -0,0 +1,205 @@
+#include "ordinal_tree.h"
+#include "ReadTree.h"
+
+#include <vector>
+#include <string>
+#include <cstdlib>
+
+#include "mem/file_archive2.h"
+#include "mem/info_archive.h"
+
+#include "utils/utest.h"
+#include "utils/utils.h"
+
+namespace tests {
+
+using namespace std;
+using namespace utils;
+using namespace mscds;
+
+// pointer-free reference tree: nodes are numbered in preorder
+struct NaiveTree {
+	vector<int> par, dep, sz;
+	vector<vector<int> > ch;
+
+	int lca(int x, int y) const {
+		while (dep[x] > dep[y]) x = par[x];
+		while (dep[y] > dep[x]) y = par[y];
+		while (x != y) { x = par[x]; y = par[y]; }
+		return x;
+	}
+};
+
+static GTreeNode<int>* random_tree(unsigned int n, unsigned int maxwidth) {
+	vector<GTreeNode<int>*> nodes;
+	for (unsigned int i = 0; i < n; ++i) {
+		GTreeNode<int>* u = new GTreeNode<int>();
+		u->data = i;
+		if (i > 0) {
+			// pick among the last few nodes to get both deep and wide trees
+			unsigned int lo = (i > maxwidth) ? i - maxwidth : 0;
+			nodes[lo + rand() % (i - lo)]->children.push_back(u);
+		}
+		nodes.push_back(u);
+	}
+	return nodes[0];
+}
+
+template<typename T>
+static void to_naive(GTreeNode<T>* root, NaiveTree& nt, vector<T>* labels = NULL) {
+	struct F {
+		static int rec(GTreeNode<T>* u, int p, int d, NaiveTree& nt, vector<T>* labels) {
+			int id = nt.par.size();
+			if (labels != NULL) labels->push_back(u->data);
+			nt.par.push_back(p);
+			nt.dep.push_back(d);
+			nt.sz.push_back(1);
+			nt.ch.push_back(vector<int>());
+			for (size_t i = 0; i < u->children.size(); ++i) {
+				nt.ch[id].push_back(nt.par.size());
+				nt.sz[id] += rec(u->children[i], id, d + 1, nt, labels);
+			}
+			return nt.sz[id];
+		}
+	};
+	F::rec(root, -1, 0, nt, labels);
+}
+
+static void check_tree(const OrdinalTree& t, const NaiveTree& nt) {
+	ASSERT_EQ(nt.par.size(), t.size());
+	ASSERT_EQ(0u, t.root());
+	vector<OrdinalTree::NodeTp> pos(nt.par.size());
+	for (unsigned int i = 0; i < nt.par.size(); ++i) {
+		pos[i] = t.preorder_select(i);
+		ASSERT_EQ(i, t.preorder(pos[i]));
+	}
+	const OrdinalTree::NodeTp NONE = OrdinalTree::NONE;
+	for (unsigned int i = 0; i < nt.par.size(); ++i) {
+		OrdinalTree::NodeTp x = pos[i];
+		ASSERT_EQ(nt.dep[i], (int) t.depth(x));
+		ASSERT_EQ(nt.sz[i], (int) t.subtree_size(x));
+		ASSERT_EQ(nt.par[i] < 0 ? NONE : pos[nt.par[i]], t.parent(x));
+		const vector<int>& c = nt.ch[i];
+		ASSERT_EQ(c.empty(), t.is_leaf(x));
+		ASSERT_EQ(c.size(), t.degree(x));
+		ASSERT_EQ(c.empty() ? NONE : pos[c.front()], t.first_child(x));
+		ASSERT_EQ(c.empty() ? NONE : pos[c.back()], t.last_child(x));
+		for (unsigned int j = 0; j < c.size(); ++j) {
+			OrdinalTree::NodeTp y = pos[c[j]];
+			ASSERT_EQ(y, t.child(x, j));
+			ASSERT_EQ(j + 1 < c.size() ? pos[c[j + 1]] : NONE, t.next_sibling(y));
+			ASSERT_EQ(j > 0 ? pos[c[j - 1]] : NONE, t.prev_sibling(y));
+		}
+		ASSERT_EQ(NONE, t.child(x, c.size()));
+	}
+	// level ancestors on a sample of the nodes (the paths can be long)
+	unsigned int stride = std::max<unsigned int>(1, nt.par.size() / 256);
+	for (unsigned int i = 0; i < nt.par.size(); i += stride) {
+		int ds[] = {0, 1, nt.dep[i] / 2, nt.dep[i]};
+		for (unsigned int k = 0; k < 4; ++k) {
+			if (ds[k] > nt.dep[i]) continue;
+			int a = i;
+			for (int d = 0; d < ds[k]; ++d) a = nt.par[a];
+			ASSERT_EQ(pos[a], t.level_ancestor(pos[i], ds[k]));
+		}
+		ASSERT_EQ(NONE, t.level_ancestor(pos[i], nt.dep[i] + 1));
+	}
+	if (t.size() == 1) {
+		ASSERT_EQ(NONE, t.next_sibling(0));
+		ASSERT_EQ(NONE, t.prev_sibling(0));
+	}
+	unsigned int nq = std::min<unsigned int>(2000, nt.par.size() * nt.par.size());
+	for (unsigned int k = 0; k < nq; ++k) {
+		int a = rand() % nt.par.size(), b = rand() % nt.par.size();
+		ASSERT_EQ(pos[nt.lca(a, b)], t.lca(pos[a], pos[b]));
+		ASSERT_EQ(nt.lca(a, b) == a, t.is_ancestor(pos[a], pos[b]));
+	}
+}
+
+TEST(ordinal_tree, readtree) {
+	GTreeNode<LabelNode>* root = readTree("((a,b)c,(d,(e)f,g)h,i)r;");
+	NaiveTree nt;
+	to_naive(root, nt);
+	OrdinalTree t;
+	vector<LabelNode> labels;
+	OrdinalTreeBuilder::build(root, &t, &labels);
+	GTreeNode<LabelNode>::free(root);
+
+	ASSERT_EQ("((()())(()(())())())", t.bp_structure().to_str().substr(0, 20));
+	const char* order[] = {"r", "c", "a", "b", "h", "d", "f", "e", "g", "i"};
+	ASSERT_EQ(10u, labels.size());
+	for (unsigned int i = 0; i < labels.size(); ++i)
+		ASSERT_EQ(string(order[i]), labels[i].name);
+	check_tree(t, nt);
+}
+
+TEST(ordinal_tree, builder) {
+	OrdinalTreeBuilder bd;
+	// r(a(b), c)
+	bd.open(); bd.open(); bd.open(); bd.close(); bd.close(); bd.open(); bd.close();
+	EXPECT_THROW(bd.build((OrdinalTree*) NULL), std::runtime_error);
+	bd.close();
+	OrdinalTree t;
+	bd.build(&t);
+	ASSERT_EQ(4u, t.size());
+	ASSERT_EQ(2u, t.degree(0));
+	ASSERT_EQ(1u, t.lca(1, 2));
+	ASSERT_EQ(0u, t.lca(2, 5));
+	ASSERT_EQ(5u, t.next_sibling(1));
+	EXPECT_THROW(bd.close(), std::runtime_error);
+
+	OrdinalTree e;
+	bd.clear();
+	bd.build(&e);
+	ASSERT_EQ(0u, e.size());
+	ASSERT_EQ(OrdinalTree::NONE, e.root());
+}
+
+TEST(ordinal_tree, random) {
+	for (unsigned int n = 1; n <= 64; ++n) {
+		GTreeNode<int>* root = random_tree(n, 1 + rand() % 8);
+		NaiveTree nt;
+		vector<int> exp_labels, labels;
+		to_naive(root, nt, &exp_labels);
+		OrdinalTree t;
+		OrdinalTreeBuilder::build(root, &t, &labels);
+		GTreeNode<int>::free(root);
+		ASSERT_EQ(exp_labels, labels);
+		check_tree(t, nt);
+	}
+}
+
+TEST(ordinal_tree, large) {
+	// several levels of pioneers in BP_aux
+	unsigned int widths[] = {2, 16, 1000};
+	for (unsigned int k = 0; k < 3; ++k) {
+		GTreeNode<int>* root = random_tree(20000, widths[k]);
+		NaiveTree nt;
+		to_naive(root, nt);
+		OrdinalTree t;
+		OrdinalTreeBuilder::build(root, &t);
+		GTreeNode<int>::free(root);
+		check_tree(t, nt);
+	}
+}
+
+TEST(ordinal_tree, saveload) {
+	GTreeNode<int>* root = random_tree(5000, 10);
+	NaiveTree nt;
+	to_naive(root, nt);
+	OMemArchive out;
+	{
+		OrdinalTree t;
+		OrdinalTreeBuilder::build(root, &t);
+		t.save(out);
+	}
+	out.close();
+	GTreeNode<int>::free(root);
+
+	OrdinalTree t2;
+	IMemArchive inp(out);
+	t2.load(inp);
+	check_tree(t2, nt);
+}
+
+}//namespace
@@ -111,6 +111,7 @@ public:
 		RMQ_index_table::build(vals, true, &tblsim);
 		RMQ_index_blk::build(vals, blksize, true, &tblblk);
 		sct.build(vals, true);
+		sct_rmm.build(vals, true);
 		queries.clear();
 		for (unsigned int i = 0; i < querycnt; ++i) {
 			unsigned int st = rand() % len;
@@ -129,6 +130,7 @@ public:
 		tblsim.clear();
 		tblblk.clear();
 		sct.clear();
+		sct_rmm.clear();
 	}
 
 	BitArray b;
@@ -138,6 +140,7 @@ public:
 	RMQ_index_table tblsim;
 	RMQ_index_blk tblblk;
 	RMQ_sct sct;
+	RMQ_sct_rmm sct_rmm;
 };
 /*
 template<class T> void DoNotOptimizeAway(T&& datum)
@@ -179,6 +182,177 @@ void RMQ_pm1_sct(RMQQuerySFixture * fixture) {
 	}
 }
 
+void RMQ_pm1_sct_rmm(RMQQuerySFixture * fixture) {
+	for (auto p : fixture->queries) {
+		fixture->sct_rmm.m_idx(p.first, p.second);
+	}
+}
+
+// balanced parentheses operations: BP_aux (pioneers, byte tables) vs BP_rmm
+class BPOpsFixture {
+public:
+	void SetUp() {
+		unsigned int len = 10000000;
+		unsigned int querycnt = 100000;
+		vector<int> vals(len);
+		int last = 0;
+		for (unsigned int i = 0; i < len; ++i) {
+			last += (rand() % 2) ? 1 : -1;
+			vals[i] = last;
+		}
+		BitArray b = build_supercartisian_tree(true, vals.begin(), vals.end());
+		aux.build(b, 256);
+		rmm.build(b, 256);
+		pos.clear();
+		for (unsigned int i = 0; i < querycnt; ++i)
+			pos.push_back(((uint64_t)rand() * RAND_MAX + rand()) % b.length());
+	}
+
+	void TearDown() {
+		aux.clear();
+		rmm.clear();
+		pos.clear();
+	}
+
+	BP_aux aux;
+	BP_rmm rmm;
+	std::vector<uint64_t> pos;
+	uint64_t sink;
+};
+
+void BP_aux_find_match(BPOpsFixture * fixture) {
+	uint64_t s = 0;
+	for (auto p : fixture->pos) s += fixture->aux.find_match(p);
+	fixture->sink = s;
+}
+
+void BP_rmm_find_match(BPOpsFixture * fixture) {
+	uint64_t s = 0;
+	for (auto p : fixture->pos) s += fixture->rmm.find_match(p);
+	fixture->sink = s;
+}
+
+void BP_aux_enclose(BPOpsFixture * fixture) {
+	uint64_t s = 0;
+	for (auto p : fixture->pos) s += fixture->aux.enclose(p);
+	fixture->sink = s;
+}
+
+void BP_rmm_enclose(BPOpsFixture * fixture) {
+	uint64_t s = 0;
+	for (auto p : fixture->pos) s += fixture->rmm.enclose(p);
+	fixture->sink = s;
+}
+
+BENCHMARK_SET(bp_ops_benchmark) {
+	Benchmarker<BPOpsFixture> bm;
+	bm.n_samples = 3;
+
+	bm.add("BP_aux_find_match", BP_aux_find_match, 10);
+	bm.add("BP_rmm_find_match", BP_rmm_find_match, 10);
+	bm.add("BP_aux_enclose", BP_aux_enclose, 10);
+	bm.add("BP_rmm_enclose", BP_rmm_enclose, 10);
+
+	bm.run_all();
+	bm.report(0);
+
+	BPOpsFixture f;
+	f.SetUp();
+	OSizeEstArchive ar;
+	f.aux.save(ar);
+	size_t sz1 = ar.opos();
+	f.rmm.save(ar);
+	size_t sz2 = ar.opos() - sz1;
+	cout << "BP_aux size = " << sz1 << " bytes, BP_rmm size = " << sz2 << " bytes" << endl;
+	f.TearDown();
+}
+
+// consecutive windows (e.g. the bins of a summary): one query per window vs m_idx_batch
+class RMQWindowFixture {
+public:
+	void SetUp() {
+		unsigned int len = 10000000;
+		vector<bool> bv = rand_bitvec(len);
+		BitArray b = BitArrayBuilder::create(len);
+		vector<int> vals(len);
+		int last = 0;
+		for (unsigned int i = 0; i < len; ++i) {
+			b.setbit(i, bv[i]);
+			last += bv[i] ? 1 : -1;
+			vals[i] = last;
+		}
+		RMQ_pm1::build(b, 32, true, &rmq);
+		sct.build(vals, true);
+		unsigned int wsz[] = {16, 64, 1024};
+		for (unsigned int k = 0; k < 3; ++k) {
+			windows[k].clear();
+			for (size_t st = 0; st + wsz[k] <= len && windows[k].size() < 100000; st += wsz[k])
+				windows[k].push_back(make_pair(st, st + wsz[k]));
+		}
+		bits = b;
+	}
+
+	void TearDown() {
+		rmq.clear();
+		sct.clear();
+		for (unsigned int k = 0; k < 3; ++k) windows[k].clear();
+		bits.clear();
+	}
+
+	BitArray bits;
+	RMQ_pm1 rmq;
+	RMQ_sct sct;
+	std::vector<std::pair<size_t, size_t> > windows[3];
+	std::vector<size_t> out;
+};
+
+template<unsigned int K>
+void RMQ_sct_window(RMQWindowFixture * fixture) {
+	const std::vector<std::pair<size_t, size_t> >& w = fixture->windows[K];
+	fixture->out.resize(w.size());
+	for (size_t i = 0; i < w.size(); ++i)
+		fixture->out[i] = fixture->sct.m_idx(w[i].first, w[i].second);
+}
+
+template<unsigned int K>
+void RMQ_sct_window_batch(RMQWindowFixture * fixture) {
+	fixture->sct.m_idx_batch(fixture->windows[K], &fixture->out);
+}
+
+template<unsigned int K>
+void RMQ_pm1_window(RMQWindowFixture * fixture) {
+	const std::vector<std::pair<size_t, size_t> >& w = fixture->windows[K];
+	fixture->out.resize(w.size());
+	for (size_t i = 0; i < w.size(); ++i)
+		fixture->out[i] = fixture->rmq.m_idx(w[i].first, w[i].second);
+}
+
+template<unsigned int K>
+void RMQ_pm1_window_batch(RMQWindowFixture * fixture) {
+	fixture->rmq.m_idx_batch(fixture->windows[K], &fixture->out);
+}
+
+BENCHMARK_SET(rmq_window_benchmark) {
+	Benchmarker<RMQWindowFixture> bm;
+	bm.n_samples = 3;
+
+	bm.add("RMQ_sct_window16", RMQ_sct_window<0>, 10);
+	bm.add("RMQ_sct_window16_batch", RMQ_sct_window_batch<0>, 10);
+	bm.add("RMQ_sct_window64", RMQ_sct_window<1>, 10);
+	bm.add("RMQ_sct_window64_batch", RMQ_sct_window_batch<1>, 10);
+	bm.add("RMQ_sct_window1024", RMQ_sct_window<2>, 10);
+	bm.add("RMQ_sct_window1024_batch", RMQ_sct_window_batch<2>, 10);
+	bm.add("RMQ_pm1_window16", RMQ_pm1_window<0>, 10);
+	bm.add("RMQ_pm1_window16_batch", RMQ_pm1_window_batch<0>, 10);
+	bm.add("RMQ_pm1_window64", RMQ_pm1_window<1>, 10);
+	bm.add("RMQ_pm1_window64_batch", RMQ_pm1_window_batch<1>, 10);
+	bm.add("RMQ_pm1_window1024", RMQ_pm1_window<2>, 10);
+	bm.add("RMQ_pm1_window1024_batch", RMQ_pm1_window_batch<2>, 10);
+
+	bm.run_all();
+	bm.report(0);
+}
+
 BENCHMARK_SET(rmq_benchmark) {
 	Benchmarker<RMQQuerySFixture> bm;
 	bm.n_samples = 3;
@@ -187,6 +361,7 @@ BENCHMARK_SET(rmq_benchmark) {
 	bm.add("RMQ_pm1_table_smaller", RMQ_pm1_table_smaller, 10);
 	bm.add("RMQ_pm1_rmq1", RMQ_pm1_rmq1, 10);
 	bm.add("RMQ_pm1_sct", RMQ_pm1_sct, 10);
+	bm.add("RMQ_pm1_sct_rmm", RMQ_pm1_sct_rmm, 10);
 
 	bm.run_all();
 	bm.report(0);
@@ -129,6 +129,48 @@ TEST(RMQ, random_long) {
 	std::cout << std::endl;
 }
 
+template<typename SCT>
+void test_sct_batch(const vector<uint64_t>& x) {
+	SCT sct;
+	sct.build(x);
+	// consecutive windows, both the scanned and the tree sizes
+	vector<size_t> bounds;
+	bounds.push_back(0);
+	while (bounds.back() < x.size()) {
+		size_t w = (rand() % 4 == 0) ? rand() % 2000 : rand() % 64;
+		bounds.push_back(std::min<size_t>(x.size(), bounds.back() + w));
+	}
+	vector<size_t> out;
+	sct.m_idx_batch(bounds, &out);
+	ASSERT_EQ(bounds.size() - 1, out.size());
+	for (size_t k = 0; k + 1 < bounds.size(); ++k)
+		ASSERT_EQ(sct.m_idx(bounds[k], bounds[k + 1]), out[k]);
+	// overlapping sorted windows and unsorted windows
+	vector<pair<size_t, size_t> > ranges;
+	size_t st = 0;
+	for (size_t k = 0; k < 500; ++k) {
+		st = std::min<size_t>(x.size() - 1, st + rand() % 40);
+		ranges.push_back(make_pair(st, std::min<size_t>(x.size(), st + 1 + rand() % 600)));
+	}
+	for (size_t k = 0; k < 500; ++k) {
+		size_t l = rand() % x.size(), r = rand() % (x.size() + 1);
+		if (l > r) std::swap(l, r);
+		ranges.push_back(make_pair(l, r));
+	}
+	sct.m_idx_batch(ranges, &out);
+	for (size_t k = 0; k < ranges.size(); ++k)
+		ASSERT_EQ(sct.m_idx(ranges[k].first, ranges[k].second), out[k]);
+}
+
+TEST(RMQ, sct_batch) {
+	for (size_t i = 0; i < 20; i++) {
+		test_sct_batch<RMQ_sct>(rand_vec<uint64_t>(rand() % 10 + 20000, 20));
+		test_sct_batch<RMQ_sct>(rand_vec<uint64_t>(rand() % 10 + 20000));
+		test_sct_batch<RMQ_sct_rmm>(rand_vec<uint64_t>(rand() % 10 + 20000, 20));
+		test_sct_batch<RMQ_sct_rmm>(rand_vec<uint64_t>(rand() % 10 + 20000));
+	}
+}
+
 }//namespace
 
 /*
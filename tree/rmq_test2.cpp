@@ -211,6 +211,59 @@ TEST(rmq_pm1, rmq_pm1) {
 	cout << endl;
 }
 
+void test_rmq_pm1_batch(unsigned int len, unsigned blksize) {
+	BitArray b = BitArrayBuilder::create(len);
+	vector<bool> bv = rand_bitvec(len);
+	for (unsigned int i = 0; i < len; ++i)
+		b.setbit(i, bv[i]);
+	RMQ_pm1 rmin, rmax;
+	RMQ_pm1::build(b, blksize, true, &rmin);
+	RMQ_pm1::build(b, blksize, false, &rmax);
+	RMQ_pm1_minmax mm;
+	RMQ_pm1_minmax::build(b, blksize, &mm);
+
+	vector<pair<size_t, size_t> > ranges;
+	size_t st = 0;
+	while (st < len) {
+		size_t w = (rand() % 4 == 0) ? rand() % 2000 : 1 + rand() % 100;
+		ranges.push_back(make_pair(st, std::min<size_t>(len, st + w)));
+		st = ranges.back().second - (rand() % 2 == 0 && ranges.back().second > st ? 1 : 0);
+		if (ranges.back().second == len) break;
+	}
+	for (unsigned int k = 0; k < 300; ++k) {
+		size_t l = rand() % len, r = rand() % (len + 1);
+		if (l > r) std::swap(l, r);
+		ranges.push_back(make_pair(l, r));
+	}
+	vector<size_t> omin, omax;
+	rmin.m_idx_batch(ranges, &omin);
+	rmax.m_idx_batch(ranges, &omax);
+	vector<pair<int, size_t> > fmin, fmax;
+	mm.find_min_batch(ranges, &fmin);
+	mm.find_max_batch(ranges, &fmax);
+	ASSERT_EQ(ranges.size(), omin.size());
+	ASSERT_EQ(ranges.size(), fmax.size());
+	for (size_t k = 0; k < ranges.size(); ++k) {
+		size_t l = ranges[k].first, r = ranges[k].second;
+		ASSERT_EQ(rmin.m_idx(l, r), omin[k]);
+		ASSERT_EQ(rmax.m_idx(l, r), omax[k]);
+		ASSERT_EQ(mm.find_min(l, r), fmin[k]);
+		ASSERT_EQ(mm.find_max(l, r), fmax[k]);
+		ASSERT_EQ(omin[k], fmin[k].second);
+		ASSERT_EQ(omax[k], fmax[k].second);
+		if (l < r) {
+			ASSERT_EQ(rmin.excess(omin[k]), fmin[k].first);
+			ASSERT_LE(fmin[k].first, fmax[k].first);
+		}
+	}
+}
+
+TEST(rmq_pm1, batch) {
+	test_rmq_pm1_batch(1000, 4);
+	for (unsigned int i = 0; i < 10; ++i)
+		test_rmq_pm1_batch(50000 + rand() % 128, 8);
+}
+
 TEST(rmq_pm1, saveload) {
 	unsigned int len = 10000, blksize = 8;
 	bool min_struct = true;
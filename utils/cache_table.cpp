@@ -100,4 +100,118 @@ void LRU_Policy::init(size_t capacity) {
 
 size_t LRU_Policy::max_capacity() { return std::min(map.max_size(), freelst.max_size()); }
 
+//------------------------------------------------------------------------------
+
+CLOCK_Policy::OpResultTp CLOCK_Policy::check(const CLOCK_Policy::KeyTp &key) {
+	auto it = map.find(key);
+	if (it != map.end())
+		return OpResultTp(it->second, FOUND_ENTRY);
+	else
+		return OpResultTp(0, NOT_FOUND);
+}
+
+CLOCK_Policy::OpResultTp CLOCK_Policy::access(const CLOCK_Policy::KeyTp &key) {
+	auto it = map.find(key);
+	if (it != map.end()) {
+		touch(it->second);
+		return OpResultTp(it->second, FOUND_ENTRY);
+	}
+	if (_capacity == 0) return OpResultTp(0, NOT_FOUND);
+	EntryIndexTp idx;
+	EntryResultTp type;
+	if (map.size() == _capacity) {
+		idx = sweep();
+		map.erase(keys[idx]);
+		type = REPLACED_ENTRY;
+	} else {
+		idx = freelst.back();
+		freelst.pop_back();
+		type = NEW_ENTRY;
+	}
+	keys[idx] = key;
+	used[idx] = true;
+	ref[idx].store(1, std::memory_order_relaxed);
+	map[key] = idx;
+	return OpResultTp(idx, type);
+}
+
+CLOCK_Policy::OpResultTp CLOCK_Policy::remove(const CLOCK_Policy::KeyTp &key) {
+	auto it = map.find(key);
+	if (it != map.end()) {
+		EntryIndexTp idx = it->second;
+		used[idx] = false;
+		freelst.push_back(idx);
+		map.erase(it);
+		return OpResultTp(idx, FOUND_ENTRY);
+	} else
+		return OpResultTp(0, NOT_FOUND);
+}
+
+// moves the clock hand until an used entry without the reference bit is found,
+// the reference bits of the passed entries are cleared
+CLOCK_Policy::EntryIndexTp CLOCK_Policy::sweep() {
+	assert(map.size() > 0);
+	while (true) {
+		size_t i = hand;
+		hand = (hand + 1) % _capacity;
+		if (!used[i]) continue;
+		if (ref[i].exchange(0, std::memory_order_relaxed) == 0)
+			return i;
+	}
+}
+
+CLOCK_Policy::EntryInfoTp CLOCK_Policy::envict() {
+	if (size() == 0) return EntryInfoTp(0, 0);
+	EntryIndexTp idx = sweep();
+	KeyTp key = keys[idx];
+	remove(key);
+	return EntryInfoTp(key, idx);
+}
+
+void CLOCK_Policy::clear() {
+	map.clear();
+	init(_capacity);
+}
+
+std::vector<CLOCK_Policy::EntryInfoTp> CLOCK_Policy::get_data() {
+	std::vector<EntryInfoTp > out;
+	out.reserve(map.size());
+	for (auto it = map.begin(); it != map.end(); ++it)
+		out.push_back(EntryInfoTp(it->first, it->second));
+	return out;
+}
+
+void CLOCK_Policy::resize_capacity(size_t new_cap) {
+	assert(new_cap > 0);
+	if (new_cap >= _capacity) {
+		std::unique_ptr<std::atomic<uint8_t>[]> nref(new std::atomic<uint8_t>[new_cap]);
+		for (size_t i = 0; i < new_cap; ++i)
+			nref[i].store(i < _capacity ? ref[i].load() : 0);
+		ref = std::move(nref);
+		keys.resize(new_cap);
+		used.resize(new_cap, false);
+		for (size_t i = new_cap; i > _capacity; --i)
+			freelst.push_back(i - 1);
+		_capacity = new_cap;
+	} else {
+		map.clear();
+		init(new_cap);
+	}
+}
+
+void CLOCK_Policy::init(size_t capacity) {
+	_capacity = capacity;
+	hand = 0;
+	keys.assign(capacity, 0);
+	used.assign(capacity, false);
+	ref.reset(new std::atomic<uint8_t>[capacity]);
+	freelst.clear();
+	for (size_t i = capacity; i > 0; --i) {
+		ref[i - 1].store(0);
+		freelst.push_back(i - 1);
+	}
+}
+
+size_t CLOCK_Policy::max_capacity() { return std::min(map.max_size(), freelst.max_size()); }
+
 }//namespace
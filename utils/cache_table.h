@@ -7,12 +7,16 @@ Least Recent Used cache table
 */
 
 #include <list>
+#include <algorithm>
 #include <utility>
 #include <unordered_map>
 #include <cassert>
 #include <vector>
 #include <cstddef>
 #include <stdint.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
 
 namespace utils {
 /**
@@ -101,6 +105,186 @@ private:
 	size_t _capacity;
 };
 
+/**
+CLOCK (second chance) cache policy
+
+Approximates LRU with one reference bit per entry. Unlike LRU_Policy, a hit
+does not need to modify the shared structure: touch() only sets the reference
+bit of an entry (atomically), hence it can be called concurrently by many
+readers while the other methods are protected by an exclusive lock.
+*/
+class CLOCK_Policy : public CacheTablePolicyInterface {
+public:
+	CLOCK_Policy() : _capacity(0), hand(0) {}
+	CLOCK_Policy(size_t capacity) : _capacity(0), hand(0) { assert(capacity > 0);  init(capacity); }
+
+	OpResultTp check(const KeyTp& key);
+	OpResultTp access(const KeyTp& key);
+	OpResultTp remove(const KeyTp& key);
+
+	/** marks the entry as recently used, safe to call from concurrent readers */
+	void touch(EntryIndexTp index) const { ref[index].store(1, std::memory_order_relaxed); }
+
+	size_t size() { return map.size(); }
+	size_t capacity() { return _capacity; }
+	size_t max_capacity();
+	void clear();
+
+	EntryInfoTp envict();
+	std::vector<EntryInfoTp > get_data();
+
+	void resize_capacity(size_t new_cap);
+private:
+	void init(size_t capacity);
+	EntryIndexTp sweep();
+
+	std::vector<KeyTp> keys;
+	std::vector<bool> used;
+	std::unique_ptr<std::atomic<uint8_t>[]> ref;
+	std::vector<EntryIndexTp> freelst;
+	std::unordered_map<KeyTp, EntryIndexTp> map;
+	size_t _capacity, hand;
+};
+
+/**
+Bounded cache of shared read-only values (e.g. decoded blocks) indexed by
+integer keys, safe to use from concurrent threads.
+
+The keys are split into `nshards' shards (by key modulo `nshards'), each guarded
+by its own mutex and managed by a CLOCK policy. The values are held by shared
+pointers so an evicted value stays valid for the readers still using it. A
+missing value is loaded without holding the lock, hence two threads may load
+the same value. A copy of the cache starts empty with the same capacity.
+*/
+template<typename T>
+class ShardedCache {
+public:
+	typedef std::shared_ptr<const T> ValuePtr;
+
+	explicit ShardedCache(unsigned int nshards = 1): nshards(nshards), shards(new Shard[nshards]) {}
+	ShardedCache(const ShardedCache& o): nshards(o.nshards), shards(new Shard[o.nshards]) { resize(o.capacity()); }
+	ShardedCache& operator=(const ShardedCache& o) {
+		if (this != &o) {
+			nshards = o.nshards;
+			shards.reset(new Shard[nshards]);
+			resize(o.capacity());
+		}
+		return *this;
+	}
+
+	/** \brief sets the total number of cached values (at least one per shard), drops the values */
+	void resize(size_t capacity);
+	/** \brief drops the values and resets the counters */
+	void reset();
+
+	/** \brief returns the value of `key', calls `load(T&)' on a new value if it is not cached */
+	template<typename Loader>
+	ValuePtr get(unsigned int key, Loader load);
+
+	/** \brief numbers of get() calls answered from the cache / that loaded a value */
+	uint64_t hits() const;
+	uint64_t misses() const;
+	size_t capacity() const;
+	size_t size() const;
+private:
+	struct Shard {
+		Shard(): hits(0), misses(0) {}
+		std::mutex mtx;
+		std::vector<ValuePtr> slots;
+		CLOCK_Policy policy;
+		std::atomic<uint64_t> hits, misses;
+	};
+	unsigned int nshards;
+	std::unique_ptr<Shard[]> shards;
+};
+
+template<typename T>
+void ShardedCache<T>::resize(size_t capacity) {
+	size_t per_shard = (capacity + nshards - 1) / nshards;
+	if (per_shard == 0) per_shard = 1;
+	for (unsigned int i = 0; i < nshards; ++i) {
+		Shard& sh = shards[i];
+		std::lock_guard<std::mutex> lock(sh.mtx);
+		sh.policy.clear();
+		sh.policy.resize_capacity(per_shard);
+		sh.slots.clear();
+		sh.slots.resize(per_shard);
+		sh.hits = 0;
+		sh.misses = 0;
+	}
+}
+
+template<typename T>
+void ShardedCache<T>::reset() {
+	for (unsigned int i = 0; i < nshards; ++i) {
+		Shard& sh = shards[i];
+		std::lock_guard<std::mutex> lock(sh.mtx);
+		sh.policy.clear();
+		std::fill(sh.slots.begin(), sh.slots.end(), ValuePtr());
+		sh.hits = 0;
+		sh.misses = 0;
+	}
+}
+
+template<typename T>
+template<typename Loader>
+typename ShardedCache<T>::ValuePtr ShardedCache<T>::get(unsigned int key, Loader load) {
+	Shard& sh = shards[key % nshards];
+	const unsigned int skey = key / nshards;
+	{
+		std::lock_guard<std::mutex> lock(sh.mtx);
+		auto r = sh.policy.check(skey);
+		if (r.type == CLOCK_Policy::FOUND_ENTRY) {
+			sh.policy.touch(r.index);
+			++sh.hits;
+			return sh.slots[r.index];
+		}
+	}
+	std::shared_ptr<T> val = std::make_shared<T>();
+	load(*val);
+	++sh.misses;
+	std::lock_guard<std::mutex> lock(sh.mtx);
+	auto r = sh.policy.access(skey);
+	if (r.type == CLOCK_Policy::FOUND_ENTRY)
+		return sh.slots[r.index];
+	sh.slots[r.index] = val;
+	return val;
+}
+
+template<typename T>
+uint64_t ShardedCache<T>::hits() const {
+	uint64_t ret = 0;
+	for (unsigned int i = 0; i < nshards; ++i) ret += shards[i].hits;
+	return ret;
+}
+
+template<typename T>
+uint64_t ShardedCache<T>::misses() const {
+	uint64_t ret = 0;
+	for (unsigned int i = 0; i < nshards; ++i) ret += shards[i].misses;
+	return ret;
+}
+
+template<typename T>
+size_t ShardedCache<T>::capacity() const {
+	size_t ret = 0;
+	for (unsigned int i = 0; i < nshards; ++i) {
+		std::lock_guard<std::mutex> lock(shards[i].mtx);
+		ret += shards[i].policy.capacity();
+	}
+	return ret;
+}
+
+template<typename T>
+size_t ShardedCache<T>::size() const {
+	size_t ret = 0;
+	for (unsigned int i = 0; i < nshards; ++i) {
+		std::lock_guard<std::mutex> lock(shards[i].mtx);
+		ret += shards[i].policy.size();
+	}
+	return ret;
+}
+
 /// Tree LRU policy
 class TreePLRU_Policy : public CacheTablePolicyInterface {
 public:
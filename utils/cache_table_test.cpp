@@ -85,6 +85,85 @@ TEST(lru_cache, test_rlu2) {
 	ASSERT_EQ(oldpos, ret.index);
 }
 
+TEST(clock_cache, test_general) {
+	CLOCK_Policy cache(3);
+	CLOCK_Policy::OpResultTp ret;
+	ret = cache.check(1);
+	ASSERT_EQ(CLOCK_Policy::NOT_FOUND, ret.type);
+	ret = cache.access(1);
+	ASSERT_EQ(CLOCK_Policy::NEW_ENTRY, ret.type);
+	ret = cache.check(1);
+	ASSERT_EQ(CLOCK_Policy::FOUND_ENTRY, ret.type);
+	ret = cache.access(2);
+	ASSERT_EQ(CLOCK_Policy::NEW_ENTRY, ret.type);
+	ret = cache.access(3);
+	ASSERT_EQ(CLOCK_Policy::NEW_ENTRY, ret.type);
+	ASSERT_EQ(3, cache.size());
+
+	ret = cache.access(4);
+	ASSERT_EQ(CLOCK_Policy::REPLACED_ENTRY, ret.type);
+	ASSERT_EQ(3, cache.size());
+	ASSERT_EQ(CLOCK_Policy::FOUND_ENTRY, cache.check(4).type);
+
+	ret = cache.remove(4);
+	ASSERT_EQ(CLOCK_Policy::FOUND_ENTRY, ret.type);
+	ASSERT_EQ(CLOCK_Policy::NOT_FOUND, cache.check(4).type);
+	ASSERT_EQ(2, cache.size());
+	ASSERT_EQ(3, cache.capacity());
+}
+
+TEST(clock_cache, second_chance) {
+	CLOCK_Policy cache(4);
+	for (unsigned int k = 1; k <= 4; ++k)
+		cache.access(k);
+	// the first sweep clears all reference bits and evicts the first entry
+	auto e = cache.envict();
+	ASSERT_EQ(1, e.key);
+	// key 2 is touched and survives, key 3 is the next victim
+	cache.touch(cache.check(2).index);
+	e = cache.envict();
+	ASSERT_EQ(3, e.key);
+	cache.access(5);
+	e = cache.envict();
+	ASSERT_EQ(4, e.key);
+	ASSERT_EQ(2, cache.size());
+	cache.resize_capacity(8);
+	ASSERT_EQ(CLOCK_Policy::FOUND_ENTRY, cache.check(2).type);
+	ASSERT_EQ(CLOCK_Policy::FOUND_ENTRY, cache.check(5).type);
+	for (unsigned int k = 10; k < 16; ++k)
+		ASSERT_EQ(CLOCK_Policy::NEW_ENTRY, cache.access(k).type);
+	ASSERT_EQ(8, cache.size());
+}
+
+TEST(sharded_cache, get) {
+	ShardedCache<unsigned int> cache(4);
+	cache.resize(8);
+	ASSERT_EQ(8, cache.capacity());
+	unsigned int loads = 0;
+	auto load = [&](unsigned int k) {
+		return cache.get(k, [&](unsigned int& v) { ++loads; v = k * 10; });
+	};
+	for (unsigned int k = 0; k < 8; ++k)
+		ASSERT_EQ(k * 10, *load(k));
+	for (unsigned int k = 0; k < 8; ++k)
+		ASSERT_EQ(k * 10, *load(k));
+	ASSERT_EQ(8, loads);
+	ASSERT_EQ(8, cache.hits());
+	ASSERT_EQ(8, cache.misses());
+	// an evicted value stays valid for its holders
+	auto held = load(0);
+	for (unsigned int k = 100; k < 140; ++k)
+		load(k);
+	ASSERT_EQ(8, cache.size());
+	ASSERT_EQ(0, *held);
+	ShardedCache<unsigned int> copy(cache);
+	ASSERT_EQ(8, copy.capacity());
+	ASSERT_EQ(0, copy.size());
+	cache.reset();
+	ASSERT_EQ(0, cache.size());
+	ASSERT_EQ(0, cache.hits());
+}
+
 }//namespace
 
 /*
@@ -0,0 +1,175 @@
+#include "line_reader.h"
+#include "file_utils.h"
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <stdexcept>
+
+#if defined(__SSE2__) && defined(__GNUC__)
+#include <emmintrin.h>
+#define LINE_READER_SSE2
+#endif
+
+namespace utils {
+
+const char* find_blank(const char* p, const char* end) {
+#ifdef LINE_READER_SSE2
+	const __m128i tab = _mm_set1_epi8('\t'), space = _mm_set1_epi8(' ');
+	while (end - p >= 16) {
+		__m128i x = _mm_loadu_si128((const __m128i*) p);
+		int m = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(x, tab), _mm_cmpeq_epi8(x, space)));
+		if (m != 0) return p + __builtin_ctz(m);
+		p += 16;
+	}
+#endif
+	while (p < end && *p != '\t' && *p != ' ') ++p;
+	return p;
+}
+
+bool parse_uint(const char*& p, const char* end, unsigned int& out) {
+	const char* s = p;
+	unsigned int v = 0;
+	while (p < end && *p >= '0' && *p <= '9') {
+		v = v * 10 + (*p - '0');
+		++p;
+	}
+	out = v;
+	return p != s;
+}
+
+bool parse_double(const char*& p, const char* end, double& out) {
+	double sign = 1.0, value = 0.0, scale = 1.0;
+	bool frac = false, digits = false;
+	if (p < end && *p == '-') { sign = -1.0; ++p; }
+	else if (p < end && *p == '+') ++p;
+	for (; p < end && *p >= '0' && *p <= '9'; ++p) {
+		value = value * 10.0 + (*p - '0');
+		digits = true;
+	}
+	if (p < end && *p == '.') {
+		double pow10 = 10.0;
+		++p;
+		for (; p < end && *p >= '0' && *p <= '9'; ++p) {
+			value += (*p - '0') / pow10;
+			pow10 *= 10.0;
+			digits = true;
+		}
+	}
+	if (digits && p < end && (*p == 'e' || *p == 'E')) {
+		unsigned int expon = 0;
+		++p;
+		if (p < end && *p == '-') { frac = true; ++p; }
+		else if (p < end && *p == '+') ++p;
+		for (; p < end && *p >= '0' && *p <= '9'; ++p)
+			expon = expon * 10 + (*p - '0');
+		if (expon > 308) expon = 308;
+		while (expon >= 50) { scale *= 1E50; expon -= 50; }
+		while (expon >=  8) { scale *= 1E8;  expon -=  8; }
+		while (expon >   0) { scale *= 10.0; expon -=  1; }
+	}
+	out = sign * (frac ? (value / scale) : (value * scale));
+	return digits;
+}
+
+//------------------------------------------------------------------------------
+
+struct MappedLineReader::Mapping {
+	boost::interprocess::file_mapping file;
+	boost::interprocess::mapped_region region;
+};
+
+MappedLineReader::MappedLineReader(): base_(NULL), cur_(NULL), end_(NULL) {}
+
+MappedLineReader::~MappedLineReader() { close(); }
+
+void MappedLineReader::open(const std::string& fname) {
+	using namespace boost::interprocess;
+	close();
+	if (!file_exists(fname)) throw std::runtime_error("cannot open file: " + fname);
+	if (filesize(fname) == 0) return;
+	map_.reset(new Mapping());
+	map_->file = file_mapping(fname.c_str(), read_only);
+	map_->region = mapped_region(map_->file, read_only);
+	map_->region.advise(mapped_region::advice_sequential);
+	base_ = cur_ = (const char*) map_->region.get_address();
+	end_ = base_ + map_->region.get_size();
+}
+
+void MappedLineReader::assign(const char* data, size_t len) {
+	close();
+	base_ = cur_ = data;
+	end_ = data + len;
+}
+
+void MappedLineReader::close() {
+	map_.reset();
+	base_ = cur_ = end_ = NULL;
+}
+
+bool MappedLineReader::next(StrRef& line) {
+	if (cur_ >= end_) return false;
+	const char* e = find_newline(cur_, end_);
+	const char* le = e;
+	if (le > cur_ && *(le - 1) == '\r') --le;
+	line = StrRef(cur_, le - cur_);
+	cur_ = (e < end_) ? e + 1 : end_;
+	return true;
+}
+
+//------------------------------------------------------------------------------
+
+bool FieldTokenizer::next(StrRef& field) {
+	skip_blank();
+	if (p >= end) return false;
+	const char* e = find_blank(p, end);
+	field = StrRef(p, e - p);
+	p = e;
+	return true;
+}
+
+bool FieldTokenizer::next_uint(unsigned int& v) {
+	skip_blank();
+	if (!parse_uint(p, end, v)) return false;
+	return p == end || *p == '\t' || *p == ' ';
+}
+
+bool FieldTokenizer::next_double(double& v) {
+	skip_blank();
+	if (!parse_double(p, end, v)) return false;
+	return p == end || *p == '\t' || *p == ' ';
+}
+
+StrRef FieldTokenizer::rest() {
+	skip_blank();
+	const char* e = end;
+	while (e > p && (*(e - 1) == '\t' || *(e - 1) == ' ')) --e;
+	return StrRef(p, e - p);
+}
+
+StrRef FieldTokenizer::remainder() {
+	if (p < end && (*p == '\t' || *p == ' ')) ++p;
+	return StrRef(p, end - p);
+}
+
+bool parse_bed_line(const StrRef& line, BedRecord& out) {
+	FieldTokenizer tk(line);
+	if (!tk.next(out.chrom)) return false;
+	if (!tk.next_uint(out.st) || !tk.next_uint(out.ed)) return false;
+	out.val = 0;
+	out.raw_rest = tk.remainder();
+	out.rest = tk.rest();
+	return true;
+}
+
+bool parse_bedgraph_line(const StrRef& line, BedRecord& out) {
+	FieldTokenizer tk(line);
+	if (!tk.next(out.chrom)) return false;
+	if (!tk.next_uint(out.st) || !tk.next_uint(out.ed)) return false;
+	if (!tk.next_double(out.val)) return false;
+	out.raw_rest = tk.remainder();
+	out.rest = tk.rest();
+	return true;
+}
+
+}//namespace
@@ -0,0 +1,117 @@
+#pragma once
+
+/**  \file
+
+Zero-copy reading and tokenizing of text files (BED, BedGraph, ...).
+
+The file is memory mapped and the lines/fields are returned as references
+into the mapped data; numbers are parsed in place without allocation.
+
+*/
+
+#include <string>
+#include <memory>
+#include <cstring>
+#include <cstddef>
+
+namespace utils {
+
+/// a reference to a range of characters (not owned, not null-terminated)
+struct StrRef {
+	const char* ptr;
+	size_t len;
+	StrRef(): ptr(NULL), len(0) {}
+	StrRef(const char* p, size_t l): ptr(p), len(l) {}
+	explicit StrRef(const std::string& s): ptr(s.c_str()), len(s.length()) {}
+
+	const char* begin() const { return ptr; }
+	const char* end() const { return ptr + len; }
+	size_t size() const { return len; }
+	bool empty() const { return len == 0; }
+	char operator[](size_t i) const { return ptr[i]; }
+
+	std::string str() const { return std::string(ptr, len); }
+	bool equals(const std::string& s) const {
+		return s.length() == len && (len == 0 || memcmp(ptr, s.data(), len) == 0);
+	}
+};
+
+/** \brief returns the first tab or space in [p..end), or `end' if there is none */
+const char* find_blank(const char* p, const char* end);
+
+/** \brief returns the first new line character in [p..end), or `end' if there is none */
+inline const char* find_newline(const char* p, const char* end) {
+	const void* r = memchr(p, '\n', end - p);
+	return r ? (const char*) r : end;
+}
+
+/** \brief parses an unsigned decimal integer at `p' and moves `p' after it.
+Returns false if there is no digit. */
+bool parse_uint(const char*& p, const char* end, unsigned int& out);
+
+/** \brief parses a decimal number (optional sign, fraction and exponent) at `p'
+and moves `p' after it, gives the same values as atof2. Returns false if there is no digit. */
+bool parse_double(const char*& p, const char* end, double& out);
+
+/// reads a text file line by line from a read-only memory mapping
+class MappedLineReader {
+public:
+	MappedLineReader();
+	~MappedLineReader();
+	/** \brief maps the file `fname' */
+	void open(const std::string& fname);
+	/** \brief reads the lines of a buffer (it must outlive the reader) */
+	void assign(const char* data, size_t len);
+	void close();
+
+	/** \brief returns the next line without its end of line characters */
+	bool next(StrRef& line);
+
+	size_t size() const { return end_ - base_; }
+	size_t position() const { return cur_ - base_; }
+private:
+	struct Mapping;
+	std::unique_ptr<Mapping> map_;
+	const char *base_, *cur_, *end_;
+};
+
+/// splits a line into fields separated by (runs of) tabs or spaces
+class FieldTokenizer {
+public:
+	FieldTokenizer(): p(NULL), end(NULL) {}
+	/// a trailing '\r' (CRLF line read with getline) is not part of the line
+	explicit FieldTokenizer(const StrRef& line): p(line.begin()), end(line.end()) {
+		if (end > p && *(end - 1) == '\r') --end;
+	}
+
+	bool next(StrRef& field);
+	bool next_uint(unsigned int& v);
+	bool next_double(double& v);
+	/** \brief the rest of the line after skipping the separators */
+	StrRef rest();
+	/** \brief the rest of the line after skipping one separator, empty fields
+	and blanks are kept */
+	StrRef remainder();
+private:
+	void skip_blank() { while (p < end && (*p == '\t' || *p == ' ')) ++p; }
+	const char *p, *end;
+};
+
+/// fields of a BED/BedGraph line, the references point into the line
+struct BedRecord {
+	StrRef chrom;
+	unsigned int st, ed;
+	double val;
+	/// the remaining fields (after `end' for BED, after `value' for BedGraph)
+	StrRef rest;
+	/// same as `rest' but exactly as in the line (only the first separator is skipped)
+	StrRef raw_rest;
+};
+
+/** \brief parses "chrom start end [rest]", returns false for malformed lines */
+bool parse_bed_line(const StrRef& line, BedRecord& out);
+
+/** \brief parses "chrom start end value [rest]", returns false for malformed lines */
+bool parse_bedgraph_line(const StrRef& line, BedRecord& out);
+
+}//namespace
@@ -0,0 +1,81 @@
+#include "utils/line_reader.h"
+#include "utils/str_utils.h"
+#include "utils/benchmark.h"
+#include "utils/utils.h"
+
+#include <sstream>
+#include <string>
+#include <iostream>
+#include <cstdlib>
+
+namespace tests {
+using namespace std;
+using namespace utils;
+
+// a synthetic BedGraph text of about `size` bytes
+static string gen_bedgraph(size_t size) {
+	ostringstream ss;
+	unsigned int pos = 0, chr = 1;
+	while ((size_t) ss.tellp() < size) {
+		unsigned int len = 1 + rand() % 100;
+		ss << "chr" << chr << '\t' << pos << '\t' << pos + len << '\t' << (rand() % 10000) / 100.0 << '\n';
+		pos += len + rand() % 50;
+		if (rand() % 200000 == 0) { ++chr; pos = 0; }
+	}
+	return ss.str();
+}
+
+// the parser used by the tools before: std::getline + quick parse over std::string
+static double parse_getline(const string& text) {
+	istringstream fi(text);
+	string line, curchr;
+	double total = 0;
+	while (getline(fi, line)) {
+		const char* p = line.c_str();
+		while (*p != ' ' && *p != '\t' && *p) ++p;
+		string chrom(line.c_str(), p);
+		if (chrom != curchr) curchr = chrom;
+		++p;
+		unsigned int st = 0, ed = 0;
+		while (*p >= '0' && *p <= '9') st = st * 10 + (*(p++) - '0');
+		++p;
+		while (*p >= '0' && *p <= '9') ed = ed * 10 + (*(p++) - '0');
+		++p;
+		total += (ed - st) * atof2(p);
+	}
+	return total;
+}
+
+static double parse_mapped(const string& text) {
+	MappedLineReader rd;
+	rd.assign(text.c_str(), text.length());
+	StrRef line;
+	BedRecord r;
+	string curchr;
+	double total = 0;
+	while (rd.next(line)) {
+		if (!parse_bedgraph_line(line, r)) continue;
+		if (!r.chrom.equals(curchr)) curchr = r.chrom.str();
+		total += (r.ed - r.st) * r.val;
+	}
+	return total;
+}
+
+BENCHMARK_SET(bedgraph_parse_benchmark) {
+	const size_t size = 200 << 20;
+	string text = gen_bedgraph(size);
+	const unsigned int nrun = 3;
+	double gb = text.length() * nrun / 1e9;
+	double chk1 = 0, chk2 = 0;
+	Timer tm;
+	for (unsigned int i = 0; i < nrun; ++i) chk1 += parse_getline(text);
+	double t1 = tm.current();
+	tm.reset();
+	for (unsigned int i = 0; i < nrun; ++i) chk2 += parse_mapped(text);
+	double t2 = tm.current();
+	cout << "bedgraph parsing of " << text.length() / (1 << 20) << "MB (checksums: " << chk1 << " " << chk2 << ")" << endl;
+	cout << "getline + quick_parse: " << gb / t1 << " GB/s" << endl;
+	cout << "MappedLineReader:      " << gb / t2 << " GB/s" << endl;
+}
+
+}//namespace
@@ -0,0 +1,139 @@
+#include "utils/line_reader.h"
+#include "utils/str_utils.h"
+#include "utils/file_utils.h"
+#include "utils/utest.h"
+
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <cstdlib>
+#include <cstdio>
+
+namespace tests {
+using namespace std;
+using namespace utils;
+
+TEST(line_reader, lines) {
+	const string text = "a\tb\n\nlong line with  spaces\r\nlast";
+	MappedLineReader rd;
+	rd.assign(text.c_str(), text.length());
+	vector<string> lines;
+	StrRef line;
+	while (rd.next(line))
+		lines.push_back(line.str());
+	ASSERT_EQ(4, lines.size());
+	ASSERT_EQ("a\tb", lines[0]);
+	ASSERT_EQ("", lines[1]);
+	ASSERT_EQ("long line with  spaces", lines[2]);
+	ASSERT_EQ("last", lines[3]);
+	ASSERT_EQ(text.length(), rd.position());
+}
+
+TEST(line_reader, find_blank) {
+	for (unsigned int k = 0; k < 1000; ++k) {
+		string s(rand() % 70, 'x');
+		for (size_t i = 0; i < s.length(); ++i)
+			if (rand() % 20 == 0) s[i] = (rand() % 2) ? ' ' : '\t';
+		size_t st = s.empty() ? 0 : rand() % s.length();
+		size_t exp = s.find_first_of(" \t", st);
+		if (exp == string::npos) exp = s.length();
+		ASSERT_EQ(exp, find_blank(s.c_str() + st, s.c_str() + s.length()) - s.c_str());
+	}
+}
+
+TEST(line_reader, numbers) {
+	const char* vals[] = {"0", "12", "-3.25", "+7.5", "1e3", "2.5E-2", "1234567.125", "-0.000001"};
+	for (unsigned int i = 0; i < sizeof(vals) / sizeof(vals[0]); ++i) {
+		const char* p = vals[i];
+		double v;
+		ASSERT_TRUE(parse_double(p, vals[i] + strlen(vals[i]), v));
+		ASSERT_EQ(atof2(vals[i]), v);
+		ASSERT_EQ(vals[i] + strlen(vals[i]), p);
+	}
+	const string s = "4294967295x";
+	const char* p = s.c_str();
+	unsigned int u;
+	ASSERT_TRUE(parse_uint(p, s.c_str() + s.length(), u));
+	ASSERT_EQ(4294967295u, u);
+	ASSERT_EQ('x', *p);
+	double d;
+	p = s.c_str() + 10;
+	ASSERT_FALSE(parse_double(p, s.c_str() + s.length(), d));
+}
+
+TEST(line_reader, bed_records) {
+	BedRecord r;
+	string line = "chr1\t100\t200\t-1.5";
+	ASSERT_TRUE(parse_bedgraph_line(StrRef(line), r));
+	ASSERT_TRUE(r.chrom.equals("chr1"));
+	ASSERT_EQ(100, r.st);
+	ASSERT_EQ(200, r.ed);
+	ASSERT_EQ(-1.5, r.val);
+	ASSERT_TRUE(r.rest.empty());
+
+	line = "chrX 5 10 gene name  ";
+	ASSERT_TRUE(parse_bed_line(StrRef(line), r));
+	ASSERT_EQ("chrX", r.chrom.str());
+	ASSERT_EQ(5, r.st);
+	ASSERT_EQ(10, r.ed);
+	ASSERT_EQ("gene name", r.rest.str());
+
+	const char* bad[] = {"chr1 12a 20", "chr1 12", ""};
+	for (unsigned int i = 0; i < 3; ++i)
+		ASSERT_FALSE(parse_bed_line(StrRef(bad[i], strlen(bad[i])), r));
+	line = "chr1 1 2";
+	ASSERT_TRUE(parse_bed_line(StrRef(line), r));
+	ASSERT_FALSE(parse_bedgraph_line(StrRef(line), r));
+}
+
+TEST(line_reader, empty_columns_crlf) {
+	BedRecord r;
+	string line = "chr1\t10\t20\t\t0\t+";
+	ASSERT_TRUE(parse_bed_line(StrRef(line), r));
+	ASSERT_EQ("\t0\t+", r.raw_rest.str());
+	ASSERT_EQ("0\t+", r.rest.str());
+
+	line = "chr1\t10\t20\r";
+	ASSERT_TRUE(parse_bed_line(StrRef(line), r));
+	ASSERT_EQ(20, r.ed);
+	ASSERT_TRUE(r.raw_rest.empty());
+	line = "chr1\t10\t20\t2.5\r";
+	ASSERT_TRUE(parse_bedgraph_line(StrRef(line), r));
+	ASSERT_EQ(2.5, r.val);
+	ASSERT_TRUE(r.rest.empty());
+	line = "chr1 10 20 a\t\tb \r";
+	ASSERT_TRUE(parse_bed_line(StrRef(line), r));
+	ASSERT_EQ("a\t\tb ", r.raw_rest.str());
+}
+
+TEST(line_reader, mapped_file) {
+	string fn = get_temp_path() + "line_reader_test.bedGraph";
+	ostringstream ss;
+	for (unsigned int i = 0; i < 10000; ++i)
+		ss << "chr" << (i / 1000) << '\t' << i * 10 << '\t' << i * 10 + 5 << '\t' << (i % 7) * 0.5 << '\n';
+	{
+		ofstream fo(fn.c_str(), ios::binary);
+		fo << ss.str();
+	}
+	MappedLineReader rd;
+	rd.open(fn);
+	ASSERT_EQ(ss.str().length(), rd.size());
+	StrRef line;
+	BedRecord r;
+	unsigned int i = 0;
+	while (rd.next(line)) {
+		ASSERT_TRUE(parse_bedgraph_line(line, r));
+		ostringstream chr;
+		chr << "chr" << (i / 1000);
+		ASSERT_TRUE(r.chrom.equals(chr.str()));
+		ASSERT_EQ(i * 10, r.st);
+		ASSERT_EQ(i * 10 + 5, r.ed);
+		ASSERT_EQ((i % 7) * 0.5, r.val);
+		++i;
+	}
+	ASSERT_EQ(10000, i);
+	rd.close();
+	std::remove(fn.c_str());
+}
+
+}//namespace
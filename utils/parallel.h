@@ -0,0 +1,134 @@
+#pragma once
+
+/**  \file
+
+Simple fork-join helpers for parallel construction of data structures.
+
+*/
+
+#include <thread>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <exception>
+#include <cstddef>
+
+namespace utils {
+
+/// returns the number of threads to use when `nthreads` is 0 (i.e. auto)
+inline unsigned int resolve_threads(unsigned int nthreads) {
+	if (nthreads > 0) return nthreads;
+	unsigned int hw = std::thread::hardware_concurrency();
+	return hw > 0 ? hw : 1;
+}
+
+/**
+splits the range [0..n) into `nparts` contiguous parts and calls f(part, start, end)
+for each part on its own thread. Returns after all parts finish. The first
+exception thrown by a worker is re-thrown in the calling thread.
+*/
+template<typename Func>
+void parallel_parts(size_t n, unsigned int nparts, Func f) {
+	if (nparts <= 1 || n <= 1) {
+		f(0u, (size_t)0, n);
+		return;
+	}
+	const size_t step = (n + nparts - 1) / nparts;
+	nparts = (unsigned int)((n + step - 1) / step);
+	std::vector<std::thread> workers;
+	std::vector<std::exception_ptr> errors(nparts);
+	for (unsigned int t = 0; t < nparts; ++t) {
+		size_t st = t * step, ed = st + step;
+		if (ed > n) ed = n;
+		workers.emplace_back([&f, &errors, t, st, ed]() {
+			try { f(t, st, ed); }
+			catch (...) { errors[t] = std::current_exception(); }
+		});
+	}
+	for (auto& w : workers) w.join();
+	for (auto& e : errors)
+		if (e) std::rethrow_exception(e);
+}
+
+/**
+fixed pool of worker threads that run submitted tasks in FIFO order. At most
+`max_pending` tasks wait in the queue, submit() blocks when the queue is full
+(this bounds the memory held by the inputs of queued tasks; 0 means unbounded).
+The first exception thrown by a task is re-thrown by wait().
+*/
+class TaskQueue {
+public:
+	explicit TaskQueue(unsigned int nthreads, size_t max_pending = 0)
+		: max_pending(max_pending), running(0), stopping(false) {
+		nthreads = resolve_threads(nthreads);
+		for (unsigned int t = 0; t < nthreads; ++t)
+			workers.emplace_back([this]() { work(); });
+	}
+
+	~TaskQueue() {
+		{
+			std::unique_lock<std::mutex> lock(mtx);
+			stopping = true;
+		}
+		has_task.notify_all();
+		for (auto& w : workers) w.join();
+	}
+
+	void submit(std::function<void()> task) {
+		std::unique_lock<std::mutex> lock(mtx);
+		while (max_pending > 0 && tasks.size() >= max_pending)
+			has_room.wait(lock);
+		tasks.push_back(std::move(task));
+		has_task.notify_one();
+	}
+
+	/// waits until all submitted tasks finish
+	void wait() {
+		std::unique_lock<std::mutex> lock(mtx);
+		while (!tasks.empty() || running > 0)
+			idle.wait(lock);
+		if (error) {
+			std::exception_ptr e = error;
+			error = std::exception_ptr();
+			std::rethrow_exception(e);
+		}
+	}
+
+	unsigned int thread_count() const { return (unsigned int) workers.size(); }
+private:
+	void work() {
+		std::unique_lock<std::mutex> lock(mtx);
+		while (true) {
+			while (tasks.empty() && !stopping)
+				has_task.wait(lock);
+			if (tasks.empty()) return;
+			std::function<void()> task = std::move(tasks.front());
+			tasks.pop_front();
+			++running;
+			has_room.notify_one();
+			lock.unlock();
+			try { task(); }
+			catch (...) {
+				std::lock_guard<std::mutex> elock(mtx);
+				if (!error) error = std::current_exception();
+			}
+			lock.lock();
+			--running;
+			if (tasks.empty() && running == 0)
+				idle.notify_all();
+		}
+	}
+
+	std::vector<std::thread> workers;
+	std::deque<std::function<void()> > tasks;
+	std::mutex mtx;
+	std::condition_variable has_task, has_room, idle;
+	std::exception_ptr error;
+	size_t max_pending;
+	unsigned int running;
+	bool stopping;
+};
+
+}//namespace
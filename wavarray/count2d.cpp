@@ -9,7 +9,21 @@ namespace mscds{
 	
 using namespace std;
 
-void Count2DBuilder::build(std::vector<Point>& list, SubQuery * out) {
+namespace {
+void grid_counts(const WatQuery& wq, const std::vector<unsigned int>& X, const std::vector<unsigned int>& Y,
+		std::vector<unsigned int>* result) {
+	GridQuery gq;
+	gq.process(&wq, X, Y, result);
+}
+
+void grid_counts(const WatMatrixQuery& wq, const std::vector<unsigned int>& X, const std::vector<unsigned int>& Y,
+		std::vector<unsigned int>* result) {
+	wq.count_grid(X, Y, result);
+}
+}
+
+template<typename WaveletTp>
+void Count2DBuilderGen<WaveletTp>::build(std::vector<Point>& list, SubQuery * out, unsigned int nthreads) {
 	assert(list.size() < (1ULL<<32));
 	assert(list.size() > 0);
 	out->clear();
@@ -40,21 +54,25 @@ void Count2DBuilder::build(std::vector<Point>& list, SubQuery * out) {
 	out->SX.build(X);
 	
 	// work on points
-	vector<uint64_t> wlst;
+	// the ranks fit in 32 bits (list.size() < 2^32)
+	vector<uint32_t> wlst;
+	wlst.reserve(list.size());
 	sort(list.begin(), list.end());
 	for (unsigned int i = 0; i < list.size(); ++i)
-		wlst.push_back(out->SY.rank(list[i].y));
+		wlst.push_back((uint32_t) out->SY.rank(list[i].y));
 	//WatBuilder bd;
-	SubBuilder::build(wlst, &out->wq);
+	SubBuilder::build(wlst, &out->wq, nthreads);
 }
 
-void Count2DBuilder::build(std::vector<Point>& list, OutArchive& ar) {
+template<typename WaveletTp>
+void Count2DBuilderGen<WaveletTp>::build(std::vector<Point>& list, OutArchive& ar, unsigned int nthreads) {
 	SubQuery out;
-	build(list, &out);
+	build(list, &out, nthreads);
 	out.save(ar);
 }
 
-void Count2DQuery::save(OutArchive& ar) const {
+template<typename WaveletTp>
+void Count2DQueryGen<WaveletTp>::save(OutArchive& ar) const {
 	ar.startclass("count2d", 1);
 	ar.var("max_x").save(max_x);
 	ar.var("max_y").save(max_y);
@@ -66,7 +84,8 @@ void Count2DQuery::save(OutArchive& ar) const {
 }
 
 
-void Count2DQuery::load(InpArchive& ar) {
+template<typename WaveletTp>
+void Count2DQueryGen<WaveletTp>::load(InpArchive& ar) {
 	clear();
 	ar.loadclass("count2d");
 	ar.var("max_x").load(max_x);
@@ -78,7 +97,8 @@ void Count2DQuery::load(InpArchive& ar) {
 	ar.endclass();
 }
 
-void Count2DQuery::clear() {
+template<typename WaveletTp>
+void Count2DQueryGen<WaveletTp>::clear() {
 	max_x = 0;
 	max_y = 0;
 	wq.clear();
@@ -87,20 +107,23 @@ void Count2DQuery::clear() {
 	DPX.clear();
 }
 
-uint64_t Count2DQuery::count(unsigned int x, unsigned int y) const {
+template<typename WaveletTp>
+uint64_t Count2DQueryGen<WaveletTp>::count(unsigned int x, unsigned int y) const {
 	return wq.rankLessThan(map_y(y), map_x(x));
 }
 
-unsigned int Count2DQuery::map_x(unsigned int x) const {
+template<typename WaveletTp>
+unsigned int Count2DQueryGen<WaveletTp>::map_x(unsigned int x) const {
 	return DPX.select(SX.rank(x));
 }
 
-unsigned int Count2DQuery::map_y(unsigned int y) const {
+template<typename WaveletTp>
+unsigned int Count2DQueryGen<WaveletTp>::map_y(unsigned int y) const {
 	return SY.rank(y);
 }
 
-std::vector<unsigned int> Count2DQuery::count_grid(const std::vector<unsigned int>& X, const std::vector<unsigned int>& Y) const {
-	GridQuery gq;
+template<typename WaveletTp>
+std::vector<unsigned int> Count2DQueryGen<WaveletTp>::count_grid(const std::vector<unsigned int>& X, const std::vector<unsigned int>& Y) const {
 	std::vector<unsigned int> Xp(X), Yp(Y);
 	for (unsigned int i = 0; i < Xp.size(); i++) 
 		Xp[i] = map_x(Xp[i]);
@@ -109,13 +132,13 @@ std::vector<unsigned int> Count2DQuery::count_grid(const std::vector<unsigned in
 	sort(Xp.begin(), Xp.end());
 	sort(Yp.begin(), Yp.end());
 	std::vector<unsigned int> result;
-	gq.process(&wq,  Xp, Yp, &result);
+	grid_counts(wq, Xp, Yp, &result);
 	return result;
 }
 
-std::vector<unsigned int> Count2DQuery::heatmap(unsigned int x1, unsigned int x2, 
+template<typename WaveletTp>
+std::vector<unsigned int> Count2DQueryGen<WaveletTp>::heatmap(unsigned int x1, unsigned int x2, 
 	unsigned int y1, unsigned int y2, unsigned int nx, unsigned int ny) const {
-	GridQuery gq;
 	if (x2 - x1 < nx || y2 - y1 < ny) throw std::runtime_error("too small width");
 	std::vector<unsigned int> Xp(nx+1), Yp(ny+1);
 
@@ -146,14 +169,18 @@ std::vector<unsigned int> Count2DQuery::heatmap(unsigned int x1, unsigned int x2
 	sort(Xp.begin(), Xp.end());
 	sort(Yp.begin(), Yp.end());
 	std::vector<unsigned int> result;
-	gq.process(&wq,  Xp, Yp, &result);
+	grid_counts(wq, Xp, Yp, &result);
 	return result;
 }
 
-size_t Count2DQuery::size() {
+template<typename WaveletTp>
+size_t Count2DQueryGen<WaveletTp>::size() {
 	return wq.length();
 }
 
-
+template class Count2DBuilderGen<WatQuery>;
+template class Count2DQueryGen<WatQuery>;
+template class Count2DBuilderGen<WatMatrixQuery>;
+template class Count2DQueryGen<WatMatrixQuery>;
 
 }//namespace
@@ -12,6 +12,7 @@ Data structure for 2D counting problem
 #include <stdint.h>
 #include "framework/archive.h"
 #include "wat_array.h"
+#include "wat_matrix.h"
 #include "intarray/sdarray_sml.h"
 
 namespace mscds{
@@ -28,25 +29,32 @@ struct Point {
 	}
 };
 
-class Count2DQuery;
+template<typename WaveletTp>
+class Count2DQueryGen;
 
-class Count2DBuilder {
+template<typename WaveletTp>
+class Count2DBuilderGen {
 public:
-	typedef WatBuilder SubBuilder;
-	typedef Count2DQuery SubQuery;
-	void build(std::vector<Point>& list, SubQuery * out);
-	void build(std::vector<Point>& list, OutArchive& ar);
+	typedef typename WaveletTp::BuilderTp SubBuilder;
+	typedef Count2DQueryGen<WaveletTp> SubQuery;
+	/** builds the structure, the wavelet tree/matrix is built using `nthreads' threads
+	(0 means the number of CPU cores) */
+	void build(std::vector<Point>& list, SubQuery * out, unsigned int nthreads = 0);
+	void build(std::vector<Point>& list, OutArchive& ar, unsigned int nthreads = 0);
 };
 
 
 /// stores a set of 2D points, and provide counting query for a rectangle region (parallel with axes)
-class Count2DQuery {
+/** `WaveletTp' is WatQuery (wavelet tree) or WatMatrixQuery (wavelet matrix),
+the two versions have different archives */
+template<typename WaveletTp>
+class Count2DQueryGen {
 public:
 	uint64_t count(unsigned int x, unsigned int y) const;
 	std::vector<unsigned int> count_grid(const std::vector<unsigned int>& X, const std::vector<unsigned int>& Y) const;
 	std::vector<unsigned int> heatmap(unsigned int x1, unsigned int x2, 
 		unsigned int y1, unsigned int y2, unsigned int nx, unsigned int ny) const;
-	typedef WatQuery::ListCallback ListCallback;
+	typedef typename WaveletTp::ListCallback ListCallback;
 	/** return the points in  */
 	void list_each(uint64_t min_x, uint64_t max_x, uint64_t min_y, uint64_t max_y, ListCallback cb, void* context) const;
 
@@ -55,10 +63,10 @@ public:
 	void save(OutArchive& ar) const;
 	size_t size();
 private:
-	WatQuery wq;
+	WaveletTp wq;
 	SDRankSelectSml SX, SY, DPX;
 	unsigned int max_x, max_y;
-	friend class Count2DBuilder;
+	friend class Count2DBuilderGen<WaveletTp>;
 
 	unsigned int map_x(unsigned int x) const;
 	unsigned int map_y(unsigned int y) const;
@@ -67,6 +75,12 @@ private:
 
 };
 
+typedef Count2DQueryGen<WatQuery> Count2DQuery;
+typedef Count2DBuilderGen<WatQuery> Count2DBuilder;
+
+typedef Count2DQueryGen<WatMatrixQuery> Count2DMatrixQuery;
+typedef Count2DBuilderGen<WatMatrixQuery> Count2DMatrixBuilder;
+
 } //namespace
 
 #endif //__COUNT_2D_H_
@@ -131,6 +131,7 @@ TEST(count2d, test3) {
 }
 
 
+template<typename BuilderTp>
 void test_grid_query1(unsigned int n, double p) {
 	//const unsigned int n = 150;
 	vector<vector<bool> > matrix;
@@ -153,13 +154,13 @@ void test_grid_query1(unsigned int n, double p) {
 		if (matrix[i-1][j-1]) count[i][j] += 1;
 		}
 	std::vector<Point> list;
-	Count2DBuilder bd;
+	BuilderTp bd;
 
 	for (int i = 0; i < n; ++i)
 		for (int j = 0; j < n; ++j)
 			if (matrix[i][j])
 				list.push_back(Point(i, j));
-	Count2DQuery cq;
+	typename BuilderTp::SubQuery cq;
 	bd.build(list, &cq);
 
 	for (int i = 0; i < n+1; ++i)
@@ -167,7 +168,7 @@ void test_grid_query1(unsigned int n, double p) {
 		int exp = count[i][j];
 		int val = cq.count(i, j);
 		if (exp != val) {
-			Count2DQuery cqxx;
+			typename BuilderTp::SubQuery cqxx;
 			bd.build(list, &cqxx);
 			cq.count(i, j);
 			ASSERT_EQ(exp, val);
@@ -230,17 +231,23 @@ void test_performance() {
 
 TEST(count2d, all_rnd) {
 	test2x(150, 0.125);
-	test_grid_query1(150, 0.125);
+	test_grid_query1<Count2DBuilder>(150, 0.125);
 	for (int i = 0; i < 100; ++i) {
 		test2x(100, (1.0 + (rand() % 50)) / 100.0);
 		if (i % 10 == 0) cout << '.';
 	}
 	for (int i = 0; i < 100; ++i) {
-		test_grid_query1(100, (1.0 + (rand() % 50)) / 100.0);
+		test_grid_query1<Count2DBuilder>(100, (1.0 + (rand() % 50)) / 100.0);
 		if (i % 10 == 0) cout << '.';
 	}
 	//test_performance();
 	cout << endl;
 }
 
+TEST(count2d, matrix_rnd) {
+	test_grid_query1<Count2DMatrixBuilder>(150, 0.125);
+	for (int i = 0; i < 100; ++i)
+		test_grid_query1<Count2DMatrixBuilder>(100, (1.0 + (rand() % 50)) / 100.0);
+}
+
 }//namespace
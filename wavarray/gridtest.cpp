@@ -252,6 +252,25 @@ TEST(watarr, listing) {
 	}
 }
 
+TEST(watarr, parallel_build) {
+	// large enough for several parts, with both 32 and 64-bit work arrays
+	uint64_t ranges[] = {2, 3, 1000, 1ULL << 40};
+	for (unsigned int k = 0; k < 4; ++k) {
+		vector<uint64_t> v(300000 + rand() % 1000);
+		for (size_t i = 0; i < v.size(); ++i)
+			v[i] = (((uint64_t)rand() << 31) ^ rand()) % ranges[k];
+		WatQuery w1, w3;
+		WatBuilder::build(v, &w1, 1);
+		WatBuilder::build(v, &w3, 3);
+		const BitArrayInterface* b1 = w1.bit_layers().getBitArray(), * b3 = w3.bit_layers().getBitArray();
+		ASSERT_EQ(b1->length(), b3->length());
+		for (size_t i = 0; i < b1->word_count(); ++i)
+			ASSERT_EQ(b1->word(i), b3->word(i));
+		for (size_t i = 0; i < v.size(); i += 997)
+			ASSERT_EQ(v[i], w3.access(i));
+	}
+}
+
 //------------------------------------------------------------------------------
 
 TEST(grid, gridquerytest_x) {
@@ -86,11 +86,14 @@ private:
 template<typename RankSelect = Rank6p> 
 class WatBuilderGen {
 public:
-	//static std::vector<uint64_t> convert(const std::vector<unsigned int>& list);
-	static void build(const std::vector<uint64_t>& list, WatQueryGen<RankSelect> * out);
-	static void build(const std::vector<uint32_t>& list, WatQueryGen<RankSelect> * out);
-	static void build(const std::vector<uint64_t>& list, OutArchive & ar);
+	/** builds the tree using `nthreads' threads (0 means the number of CPU cores),
+	the output is the same for any number of threads */
+	static void build(const std::vector<uint64_t>& list, WatQueryGen<RankSelect> * out, unsigned int nthreads = 0);
+	static void build(const std::vector<uint32_t>& list, WatQueryGen<RankSelect> * out, unsigned int nthreads = 0);
+	static void build(const std::vector<uint64_t>& list, OutArchive & ar, unsigned int nthreads = 0);
 private:
+	template<typename T>
+	static void build_gen(const std::vector<T>& list, WatQueryGen<RankSelect> * out, unsigned int nthreads);
 };
 
 
@@ -20,6 +20,7 @@ Implementation of generic wavelet tree functions
 #include "wat_array.h"
 
 #include "bitarray/bitop.h"
+#include "utils/parallel.h"
 
 
 namespace mscds {
@@ -33,79 +34,141 @@ namespace mscds {
 		return x >> (bit_num - len);
 	}
 
-	static inline void _sortrun(unsigned int d, unsigned int bit_num, std::vector<uint64_t>& pos, std::vector<uint64_t>& runlen) {
-		std::vector<uint64_t> nextrunlen, r0, r1;
-		uint64_t i = 0;
-		for (uint64_t r = 0; r < runlen.size(); ++r) {
-			uint64_t len = runlen[r];
-			if (len > 0) {
-				uint64_t zero_cnt = 0;
-				for (uint64_t j = 0; j < len; j++)
-				if (_getMSB(pos[i + j], d, bit_num) == 0) {
-					zero_cnt++;
-					r0.push_back(pos[i + j]);
-				}
-				else
-					r1.push_back(pos[i + j]);
-				uint64_t one_cnt = len - zero_cnt;
-				i += len;
-				nextrunlen.push_back(zero_cnt);
-				nextrunlen.push_back(one_cnt);
-			}
+	// number of zeros in the bits [st, ed) of b
+	static inline uint64_t _count_zeros(const BitArray& b, uint64_t st, uint64_t ed) {
+		if (st >= ed) return 0;
+		uint64_t ws = st / 64, we = (ed - 1) / 64, ones;
+		uint64_t first = b.word(ws) >> (st % 64);
+		if (ws == we) {
+			uint64_t len = ed - st;
+			ones = popcnt(len < 64 ? first & ((1ULL << len) - 1) : first);
+		} else {
+			ones = popcnt(first);
+			for (uint64_t w = ws + 1; w < we; ++w)
+				ones += popcnt(b.word(w));
+			uint64_t len = ed - we * 64;
+			uint64_t last = b.word(we);
+			ones += popcnt(len < 64 ? last & ((1ULL << len) - 1) : last);
 		}
-		i = 0;
-		runlen.clear();
-		uint64_t r0p = 0, r1p = 0;
-		for (uint64_t k = 0; k < nextrunlen.size(); k += 2) {
-			uint64_t zero_cnt = nextrunlen[k];
-			uint64_t one_cnt = nextrunlen[k + 1];
-			for (uint64_t j = 0; j < zero_cnt; j++)
-				pos[i + j] = r0[r0p + j];
-			i += zero_cnt;
-			r0p += zero_cnt;
-			for (uint64_t j = 0; j < one_cnt; j++)
-				pos[i + j] = r1[r1p + j];
-			i += one_cnt;
-			r1p += one_cnt;
-		}
-		r0.clear();
-		r1.clear();
-		runlen.swap(nextrunlen);
+		return (ed - st) - ones;
 	}
 
-	template<typename RankSelect>
-	void WatBuilderGen<RankSelect>::build(const std::vector<uint64_t>& list, WatQueryGen<RankSelect> * out) {
-		uint64_t alphabet_num = 0;
-		for (size_t i = 0; i < list.size(); ++i){
-			if (list[i] >= alphabet_num)
-				alphabet_num = list[i];
+	/**
+	Writes the levels of a wavelet tree (or of a wavelet matrix when `matrix' is
+	true) of `input' to `v'. Level d is the input stably sorted by the first d bits
+	of the values (by the reversed first d bits for the matrix).
+
+	Every level is split into chunks that start at word boundaries of `v'. Each
+	thread writes the bits of its chunk and counts its zeros; with the prefix sums
+	of these counts every thread moves the values of its chunk to their places in
+	the next level (zeros before ones inside each node of the tree, or inside the
+	whole level for the matrix). The values are kept in two arrays of T while sorting.
+	*/
+	template<typename T, typename InT>
+	void _wat_build_levels(const std::vector<InT>& input, unsigned int bitwidth, bool matrix,
+			BitArray& v, unsigned int nthreads) {
+		const uint64_t n = input.size();
+		if (n == 0 || bitwidth == 0) return;
+		unsigned int nparts = utils::resolve_threads(nthreads);
+		// small inputs are not worth the threads
+		const uint64_t MIN_PART = 1ULL << 16;
+		if (n / MIN_PART < nparts) nparts = (unsigned int) std::max<uint64_t>(1, n / MIN_PART);
+
+		std::vector<T> cur(input.begin(), input.end()), next(n);
+		std::vector<uint64_t> bounds(nparts + 1), zc(nparts + 1);
+		for (unsigned int d = 0; d < bitwidth; ++d) {
+			const unsigned int shift = bitwidth - 1 - d;
+			const uint64_t base = d * n;
+			const uint64_t step = (n + nparts - 1) / nparts;
+			bounds[0] = 0;
+			for (unsigned int t = 1; t < nparts; ++t) {
+				uint64_t b = ((base + t * step + 63) / 64) * 64 - base;
+				bounds[t] = std::min(std::max(b, bounds[t - 1]), n);
+			}
+			bounds[nparts] = n;
+
+			utils::parallel_parts(nparts, nparts, [&](unsigned int t, size_t, size_t) {
+				uint64_t w = 0, ones = 0;
+				for (uint64_t i = bounds[t]; i < bounds[t + 1]; ++i) {
+					const uint64_t g = base + i;
+					const uint64_t bit = (cur[i] >> shift) & 1;
+					w |= bit << (g & 63);
+					ones += bit;
+					if ((g & 63) == 63 || i + 1 == bounds[t + 1]) {
+						v.setword(g / 64, v.word(g / 64) | w);
+						w = 0;
+					}
+				}
+				zc[t + 1] = (bounds[t + 1] - bounds[t]) - ones;
+			});
+			if (d + 1 == bitwidth) break;
+			zc[0] = 0;
+			for (unsigned int t = 0; t < nparts; ++t)
+				zc[t + 1] += zc[t];
+
+			utils::parallel_parts(nparts, nparts, [&](unsigned int t, size_t, size_t) {
+				const uint64_t cs = bounds[t], ce = bounds[t + 1];
+				uint64_t zi = zc[t]; // zeros before i in the level
+				if (matrix) {
+					const uint64_t ztotal = zc[nparts];
+					for (uint64_t i = cs; i < ce; ++i) {
+						if ((cur[i] >> shift) & 1) next[ztotal + i - zi] = cur[i];
+						else next[zi++] = cur[i];
+					}
+					return;
+				}
+				// the nodes are the runs of values with the same first d bits
+				const unsigned int psh = shift + 1;
+				auto prefix = [psh](T x) -> uint64_t { return psh >= sizeof(T) * 8 ? 0 : (uint64_t)(x >> psh); };
+				uint64_t i = cs;
+				while (i < ce) {
+					const uint64_t p = prefix(cur[i]);
+					uint64_t rs = i, zrs = zi;
+					if (i == cs && cs > 0 && prefix(cur[cs - 1]) == p) {
+						// the node started in an earlier chunk
+						rs = std::partition_point(cur.begin(), cur.begin() + cs,
+							[&](T x) { return prefix(x) < p; }) - cur.begin();
+						zrs = zi - _count_zeros(v, base + rs, base + cs);
+					}
+					// galloping search for the end of the node
+					uint64_t lo = i, gap = 1;
+					while (lo + gap < n && prefix(cur[lo + gap]) == p) { lo += gap; gap *= 2; }
+					const uint64_t re = std::partition_point(cur.begin() + lo + 1, cur.begin() + std::min(n, lo + gap),
+						[&](T x) { return prefix(x) == p; }) - cur.begin();
+					const uint64_t zre = zi + _count_zeros(v, base + i, base + re);
+					const uint64_t e = std::min(re, ce);
+					for (; i < e; ++i) {
+						if ((cur[i] >> shift) & 1) next[i + zre - zi] = cur[i];
+						else next[rs + zi++ - zrs] = cur[i];
+					}
+				}
+			});
+			cur.swap(next);
 		}
+	}
 
-		uint64_t alphabet_bit_num_ = ceillog2(alphabet_num + 1);
-		//assert(Log2(alphabet_num) == msb_intr(alphabet_num - 1) + 1);
+	/// writes the bit levels, see _wat_build_levels
+	template<typename InT>
+	void _wat_build_bits(const std::vector<InT>& input, unsigned int bitwidth, bool matrix,
+			BitArray& v, unsigned int nthreads) {
+		if (bitwidth <= 32)
+			_wat_build_levels<uint32_t>(input, bitwidth, matrix, v, nthreads);
+		else
+			_wat_build_levels<uint64_t>(input, bitwidth, matrix, v, nthreads);
+	}
 
-		uint64_t length = static_cast<uint64_t>(list.size());
-		out->clear();
-		out->max_val = alphabet_num;
-		out->slength = length;
-		out->bitwidth = alphabet_bit_num_;
-		BitArray v = BitArrayBuilder::create(length * alphabet_bit_num_);
-		v.fillzero();
+	template<typename RankSelect>
+	void _wat_build_rank(BitArray& v, RankSelect* out, unsigned int) {
+		RankSelect::BuilderTp::build(v, out);
+	}
 
-		std::vector<uint64_t> runlen, pos(list.begin(), list.end());
-		runlen.push_back(length);
-		for (unsigned int d = 0; d < alphabet_bit_num_; ++d) {
-			for (unsigned int i = 0; i < length; ++i)
-				v.setbit(d*length + i, _getMSB(pos[i], d, alphabet_bit_num_) != 0);
-			if (d + 1 <  alphabet_bit_num_) {
-				_sortrun(d, alphabet_bit_num_, pos, runlen);
-			}
-		}
-		RankSelect::BuilderTp::build(v, &(out->bit_array));
+	inline void _wat_build_rank(BitArray& v, Rank6p* out, unsigned int nthreads) {
+		Rank6pBuilder::build(v, out, nthreads);
 	}
 
 	template<typename RankSelect>
-	void WatBuilderGen<RankSelect>::build(const std::vector<uint32_t>& list, WatQueryGen<RankSelect> * out) {
+	template<typename T>
+	void WatBuilderGen<RankSelect>::build_gen(const std::vector<T>& list, WatQueryGen<RankSelect> * out, unsigned int nthreads) {
 		uint64_t alphabet_num = 0;
 		for (size_t i = 0; i < list.size(); ++i) {
 			if (list[i] >= alphabet_num)
@@ -113,7 +176,6 @@ namespace mscds {
 		}
 
 		uint64_t alphabet_bit_num_ = ceillog2(alphabet_num + 1);
-		//assert(Log2(alphabet_num) == msb_intr(alphabet_num - 1) + 1);
 
 		uint64_t length = static_cast<uint64_t>(list.size());
 		out->clear();
@@ -122,24 +184,24 @@ namespace mscds {
 		out->bitwidth = alphabet_bit_num_;
 		BitArray v = BitArrayBuilder::create(length * alphabet_bit_num_);
 		v.fillzero();
+		_wat_build_bits(list, alphabet_bit_num_, false, v, nthreads);
+		_wat_build_rank(v, &(out->bit_array), nthreads);
+	}
 
-		std::vector<uint64_t> runlen, pos(list.begin(), list.end());
-		runlen.push_back(length);
-		for (unsigned int d = 0; d < alphabet_bit_num_; ++d) {
-			for (unsigned int i = 0; i < length; ++i)
-				v.setbit(d*length + i, _getMSB(pos[i], d, alphabet_bit_num_) != 0);
-			if (d + 1 <  alphabet_bit_num_) {
-				_sortrun(d, alphabet_bit_num_, pos, runlen);
-			}
-		}
-		RankSelect::BuilderTp::build(v, &(out->bit_array));
+	template<typename RankSelect>
+	void WatBuilderGen<RankSelect>::build(const std::vector<uint64_t>& list, WatQueryGen<RankSelect> * out, unsigned int nthreads) {
+		build_gen(list, out, nthreads);
 	}
 
+	template<typename RankSelect>
+	void WatBuilderGen<RankSelect>::build(const std::vector<uint32_t>& list, WatQueryGen<RankSelect> * out, unsigned int nthreads) {
+		build_gen(list, out, nthreads);
+	}
 
 	template<typename RankSelect>
-	void WatBuilderGen<RankSelect>::build(const std::vector<uint64_t>& list, OutArchive & ar) {
-		WatQuery q;
-		build(list, &q);
+	void WatBuilderGen<RankSelect>::build(const std::vector<uint64_t>& list, OutArchive & ar, unsigned int nthreads) {
+		WatQueryGen<RankSelect> q;
+		build(list, &q, nthreads);
 		q.save(ar);
 	}
 
@@ -503,13 +565,14 @@ namespace mscds {
 		//std::sort(pos.begin(), pos.end());
 		assert(pos.back() <= wt->length());
 		//assert(num_lst.back() <= wt->alphabet_num());
-		assert(num_lst.back() <= 1ULL << (wt->bitwidth));
+		// the numbers that do not fit in bitwidth bits count the whole prefix
+		unsigned int nlow = std::lower_bound(num_lst.begin(), num_lst.end(), 1ULL << (wt->bitwidth)) - num_lst.begin();
 		Query2 q;
 		q.beg_node = 0;
 		q.end_node = wt->length();
 		q.depth = 0;
 		q.beg_plst = 0;
-		q.end_plst = num_lst.size();
+		q.end_plst = nlow;
 		typedef typename GridQueryGen<WavTree>::Query2::PosInfo PosInfo;
 		//assert(wt->bit_array.size() == wt->bitwidth);
 		for (auto it = pos.begin(); it != pos.end(); it++)
@@ -519,6 +582,8 @@ namespace mscds {
 		//for (unsigned int i = 0; i < results->size(); i++)
 		//	(*results)[i].resize(pos.size());
 		result->resize(num.size() * pos.size());
+		for (unsigned int i = nlow; i < num_lst.size(); ++i)
+			std::copy(pos.begin(), pos.end(), result->begin() + i * poslen);
 
 		std::deque<Query2> cur, next;
 		cur.push_back(q);
@@ -0,0 +1,124 @@
+#pragma once
+
+#ifndef __WAVELET_MATRIX_H_
+#define __WAVELET_MATRIX_H_
+
+/**  \file
+
+Wavelet matrix in generic form
+
+The levels are stored one after another in a single bit array. Unlike the
+wavelet tree in wat_array.h, a level is not split into nodes: the zeros of a
+level go to the front of the next level and the ones go to the back (both
+stable), so a position is mapped to the next level with one rank query and
+the node boundaries never have to be computed.
+
+Based on:
+
+  F. Claude, G. Navarro, and A. Ordonez. The wavelet matrix: An efficient
+  wavelet tree for large alphabets. Information Systems, 2015.
+
+*/
+
+#include <vector>
+#include <stdint.h>
+#include <string>
+#include "bitarray/rank6p.h"
+#include "bitarray/rrr3.h"
+#include "framework/archive.h"
+
+namespace mscds {
+
+template<typename>
+class WatMatrixBuilderGen;
+
+/// generic wavelet matrix class, same interface as WatQueryGen (default use Rank6p)
+template<typename RankSelect = Rank6p>
+class WatMatrixQueryGen {
+public:
+	typedef RankSelect RankSelectTp;
+	static const uint64_t NOTFOUND = 0xFFFFFFFFFFFFFFFFULL;
+
+	uint64_t access(uint64_t pos) const;
+	uint64_t rank(uint64_t c, uint64_t pos) const;
+	uint64_t select(uint64_t c, uint64_t r) const;
+	uint64_t rankLessThan(uint64_t c, uint64_t pos) const;
+	uint64_t rankMoreThan(uint64_t c, uint64_t pos) const;
+	void rankAll(uint64_t c, uint64_t pos,
+		uint64_t& rank, uint64_t& rank_less_than, uint64_t& rank_more_than) const;
+
+	uint64_t kthValue(uint64_t begin_pos, uint64_t end_pos, uint64_t k, uint64_t & pos) const;
+	uint64_t maxValue(uint64_t begin_pos, uint64_t end_pos, uint64_t & pos) const;
+	uint64_t minValue(uint64_t begin_pos, uint64_t end_pos, uint64_t & pos) const;
+	uint64_t operator[](uint64_t pos) const { return access(pos); }
+
+	uint64_t length() const { return slength; }
+
+	WatMatrixQueryGen(): slength(0), bitwidth(0), max_val(0) {}
+	~WatMatrixQueryGen() { if (slength > 0) clear(); }
+
+	uint64_t count2d(uint64_t min_c, uint64_t max_c, uint64_t beg_pos, uint64_t end_pos) const;
+	typedef bool (*ListCallback) (void * context, uint64_t c, uint64_t pos);
+	/** return the numbers in range [min_c, max_c) and [beg_pos, end_pos) */
+	void list_each(uint64_t min_c, uint64_t max_c, uint64_t beg_pos, uint64_t end_pos,
+		ListCallback cb, void* context) const;
+	/** \brief rankLessThan(num[i], pos[j]) for all pairs, stored at result[i*pos.size() + j].
+	Both lists must be sorted; same as GridQueryGen::process for the wavelet tree. */
+	void count_grid(const std::vector<unsigned int>& pos, const std::vector<unsigned int>& num,
+		std::vector<unsigned int> * result) const;
+
+	void load(InpArchive& ar);
+	void save(OutArchive& ar) const;
+	void clear();
+	std::string to_str() const;
+
+	const RankSelect& bit_layers() const { return bit_array; }
+	typedef class WatMatrixBuilderGen<RankSelect> BuilderTp;
+private:
+	uint64_t slength;
+	uint64_t bitwidth;
+	uint64_t max_val;
+	RankSelect bit_array;
+	/// number of zeros before each level (one more entry for the end)
+	std::vector<uint64_t> zeros_before;
+
+	void init_levels();
+	uint64_t nzeros(unsigned int level) const { return zeros_before[level + 1] - zeros_before[level]; }
+	/// number of zeros in the prefix [0..p) of a level
+	uint64_t rank0(unsigned int level, uint64_t p) const
+		{ return bit_array.rankzero(level * slength + p) - zeros_before[level]; }
+	bool cbit(uint64_t c, unsigned int level) const { return ((c >> (bitwidth - 1 - level)) & 1) != 0; }
+	uint64_t range_less(uint64_t c, uint64_t beg, uint64_t end) const;
+	uint64_t trace_up(uint64_t c, uint64_t p) const;
+	void list_rec(unsigned int level, uint64_t beg, uint64_t end, uint64_t prefix,
+		uint64_t min_c, uint64_t max_c, ListCallback cb, void* context) const;
+
+	template <typename>
+	friend class WatMatrixBuilderGen;
+};
+
+template<typename RankSelect = Rank6p>
+class WatMatrixBuilderGen {
+public:
+	/** builds the matrix using `nthreads' threads (0 means the number of CPU cores),
+	the output is the same for any number of threads */
+	static void build(const std::vector<uint64_t>& list, WatMatrixQueryGen<RankSelect> * out, unsigned int nthreads = 0);
+	static void build(const std::vector<uint32_t>& list, WatMatrixQueryGen<RankSelect> * out, unsigned int nthreads = 0);
+	static void build(const std::vector<uint64_t>& list, OutArchive & ar, unsigned int nthreads = 0);
+private:
+	template<typename T>
+	static void build_gen(const std::vector<T>& list, WatMatrixQueryGen<RankSelect> * out, unsigned int nthreads);
+};
+
+typedef WatMatrixQueryGen<Rank6p> WatMatrixQuery;
+typedef WatMatrixBuilderGen<Rank6p> WatMatrixBuilder;
+
+typedef WatMatrixQueryGen<RRR3_Rank> WatMatrixRRRQuery;
+typedef WatMatrixBuilderGen<RRR3_Rank> WatMatrixRRRBuilder;
+
+} //namespace
+
+
+#endif // __WAVELET_MATRIX_H_
+
+#include "wat_matrix.hxx"
@@ -0,0 +1,378 @@
+#pragma once
+
+#ifndef __WAVELET_MATRIX_IMPL_
+#define __WAVELET_MATRIX_IMPL_
+
+/**  \file
+
+Implementation of generic wavelet matrix functions
+
+*/
+
+#include "wat_matrix.h"
+#include "wat_array.h"
+
+#include <algorithm>
+#include <cassert>
+#include <sstream>
+#include <stdexcept>
+
+#include "bitarray/bitop.h"
+
+
+namespace mscds {
+
+	template<typename RankSelect>
+	template<typename T>
+	void WatMatrixBuilderGen<RankSelect>::build_gen(const std::vector<T>& list, WatMatrixQueryGen<RankSelect> * out, unsigned int nthreads) {
+		uint64_t alphabet_num = 0;
+		for (size_t i = 0; i < list.size(); ++i)
+			if (list[i] > alphabet_num)
+				alphabet_num = list[i];
+		unsigned int bitwidth = ceillog2(alphabet_num + 1);
+
+		uint64_t length = list.size();
+		out->clear();
+		out->max_val = alphabet_num;
+		out->slength = length;
+		out->bitwidth = bitwidth;
+		BitArray v = BitArrayBuilder::create(length * bitwidth);
+		v.fillzero();
+
+		_wat_build_bits(list, bitwidth, true, v, nthreads);
+		_wat_build_rank(v, &(out->bit_array), nthreads);
+		out->init_levels();
+	}
+
+	template<typename RankSelect>
+	void WatMatrixBuilderGen<RankSelect>::build(const std::vector<uint64_t>& list, WatMatrixQueryGen<RankSelect> * out, unsigned int nthreads) {
+		build_gen(list, out, nthreads);
+	}
+
+	template<typename RankSelect>
+	void WatMatrixBuilderGen<RankSelect>::build(const std::vector<uint32_t>& list, WatMatrixQueryGen<RankSelect> * out, unsigned int nthreads) {
+		build_gen(list, out, nthreads);
+	}
+
+	template<typename RankSelect>
+	void WatMatrixBuilderGen<RankSelect>::build(const std::vector<uint64_t>& list, OutArchive & ar, unsigned int nthreads) {
+		WatMatrixQueryGen<RankSelect> q;
+		build(list, &q, nthreads);
+		q.save(ar);
+	}
+
+	//--------------------------------------------------------------------------------------
+
+	template<typename RankSelect>
+	const uint64_t WatMatrixQueryGen<RankSelect>::NOTFOUND;
+
+	template<typename RankSelect>
+	void WatMatrixQueryGen<RankSelect>::init_levels() {
+		zeros_before.assign(bitwidth + 1, 0);
+		if (slength == 0) return;
+		for (unsigned int l = 1; l <= bitwidth; ++l)
+			zeros_before[l] = bit_array.rankzero(l * slength);
+	}
+
+	template<typename RankSelect>
+	void WatMatrixQueryGen<RankSelect>::load(InpArchive& ar) {
+		clear();
+		ar.loadclass("wavelet_matrix");
+		ar.var("length").load(slength);
+		ar.var("bitwidth").load(bitwidth);
+		ar.var("max_value").load(max_val);
+		ar.var("bits");
+		bit_array.load(ar);
+		ar.endclass();
+		init_levels();
+	}
+
+	template<typename RankSelect>
+	void WatMatrixQueryGen<RankSelect>::save(OutArchive& ar) const {
+		ar.startclass("wavelet_matrix", 1);
+		ar.var("length").save(slength);
+		ar.var("bitwidth").save(bitwidth);
+		ar.var("max_value").save(max_val);
+		ar.var("bits");
+		bit_array.save(ar);
+		ar.endclass();
+	}
+
+	template<typename RankSelect>
+	void WatMatrixQueryGen<RankSelect>::clear() {
+		slength = 0;
+		bitwidth = 0;
+		max_val = 0;
+		zeros_before.clear();
+		bit_array.clear();
+	}
+
+	template<typename RankSelect>
+	uint64_t WatMatrixQueryGen<RankSelect>::access(uint64_t pos) const {
+		if (pos >= slength) throw std::runtime_error("out of range");
+		uint64_t c = 0;
+		for (unsigned int l = 0; l < bitwidth; ++l) {
+			const uint64_t r0 = rank0(l, pos);
+			c <<= 1;
+			if (bit_array.bit(l * slength + pos)) {
+				pos = nzeros(l) + pos - r0;
+				c |= 1ULL;
+			} else
+				pos = r0;
+		}
+		return c;
+	}
+
+	template<typename RankSelect>
+	uint64_t WatMatrixQueryGen<RankSelect>::rank(uint64_t c, uint64_t pos) const {
+		uint64_t rank_less_than = 0, rank_more_than = 0, rank = 0;
+		rankAll(c, pos, rank, rank_less_than, rank_more_than);
+		return rank;
+	}
+
+	template<typename RankSelect>
+	uint64_t WatMatrixQueryGen<RankSelect>::rankLessThan(uint64_t c, uint64_t pos) const {
+		if (pos > slength) pos = slength;
+		return range_less(c, 0, pos);
+	}
+
+	template<typename RankSelect>
+	uint64_t WatMatrixQueryGen<RankSelect>::rankMoreThan(uint64_t c, uint64_t pos) const {
+		uint64_t rank_less_than = 0, rank_more_than = 0, rank = 0;
+		rankAll(c, pos, rank, rank_less_than, rank_more_than);
+		return rank_more_than;
+	}
+
+	template<typename RankSelect>
+	void WatMatrixQueryGen<RankSelect>::rankAll(uint64_t c, uint64_t pos,
+		uint64_t& rank, uint64_t& rank_less_than, uint64_t& rank_more_than) const {
+		if (pos > slength) pos = slength;
+		rank = 0;
+		rank_less_than = 0;
+		rank_more_than = 0;
+		if (c > max_val) {
+			rank_less_than = pos;
+			return;
+		}
+		// [beg, pos) is the part of the prefix in the node of c
+		uint64_t beg = 0;
+		for (unsigned int l = 0; l < bitwidth; ++l) {
+			const uint64_t r0b = rank0(l, beg), r0p = rank0(l, pos);
+			if (!cbit(c, l)) {
+				rank_more_than += (pos - beg) - (r0p - r0b);
+				beg = r0b;
+				pos = r0p;
+			} else {
+				rank_less_than += r0p - r0b;
+				beg = nzeros(l) + beg - r0b;
+				pos = nzeros(l) + pos - r0p;
+			}
+		}
+		rank = pos - beg;
+	}
+
+	template<typename RankSelect>
+	uint64_t WatMatrixQueryGen<RankSelect>::range_less(uint64_t c, uint64_t beg, uint64_t end) const {
+		if (c > max_val) return end - beg;
+		uint64_t ret = 0;
+		for (unsigned int l = 0; l < bitwidth && beg < end; ++l) {
+			const uint64_t r0b = rank0(l, beg), r0e = rank0(l, end);
+			if (!cbit(c, l)) {
+				beg = r0b;
+				end = r0e;
+			} else {
+				ret += r0e - r0b;
+				beg = nzeros(l) + beg - r0b;
+				end = nzeros(l) + end - r0e;
+			}
+		}
+		return ret;
+	}
+
+	// maps the position `p' of the last level (in the node of `c') back to the input
+	template<typename RankSelect>
+	uint64_t WatMatrixQueryGen<RankSelect>::trace_up(uint64_t c, uint64_t p) const {
+		for (unsigned int l = bitwidth; l > 0; --l) {
+			const unsigned int lv = l - 1;
+			const uint64_t lvstart = lv * slength;
+			if (!cbit(c, lv))
+				p = bit_array.selectzero(zeros_before[lv] + p) - lvstart;
+			else
+				p = bit_array.select((lvstart - zeros_before[lv]) + p - nzeros(lv)) - lvstart;
+		}
+		return p;
+	}
+
+	template<typename RankSelect>
+	uint64_t WatMatrixQueryGen<RankSelect>::select(uint64_t c, uint64_t r) const {
+		if (c > max_val) return NOTFOUND;
+		uint64_t beg = 0, end = slength;
+		for (unsigned int l = 0; l < bitwidth && beg < end; ++l) {
+			const uint64_t r0b = rank0(l, beg), r0e = rank0(l, end);
+			if (!cbit(c, l)) {
+				beg = r0b;
+				end = r0e;
+			} else {
+				beg = nzeros(l) + beg - r0b;
+				end = nzeros(l) + end - r0e;
+			}
+		}
+		if (beg + r >= end) return NOTFOUND;
+		return trace_up(c, beg + r);
+	}
+
+	template<typename RankSelect>
+	uint64_t WatMatrixQueryGen<RankSelect>::kthValue(uint64_t begin_pos, uint64_t end_pos, uint64_t k, uint64_t & pos) const {
+		if (end_pos > slength || begin_pos >= end_pos || k >= end_pos - begin_pos) {
+			assert(false);
+			return NOTFOUND;
+		}
+		uint64_t val = 0;
+		for (unsigned int l = 0; l < bitwidth; ++l) {
+			const uint64_t r0b = rank0(l, begin_pos), r0e = rank0(l, end_pos);
+			if (r0e - r0b > k) {
+				begin_pos = r0b;
+				end_pos = r0e;
+				val = val << 1;
+			} else {
+				k -= r0e - r0b;
+				begin_pos = nzeros(l) + begin_pos - r0b;
+				end_pos = nzeros(l) + end_pos - r0e;
+				val = (val << 1) + 1;
+			}
+		}
+		// the first occurrence of val in the range, like WatQueryGen
+		pos = trace_up(val, begin_pos);
+		return val;
+	}
+
+	template<typename RankSelect>
+	uint64_t WatMatrixQueryGen<RankSelect>::maxValue(uint64_t begin_pos, uint64_t end_pos, uint64_t & pos) const {
+		return kthValue(begin_pos, end_pos, end_pos - begin_pos - 1, pos);
+	}
+
+	template<typename RankSelect>
+	uint64_t WatMatrixQueryGen<RankSelect>::minValue(uint64_t begin_pos, uint64_t end_pos, uint64_t & pos) const {
+		return kthValue(begin_pos, end_pos, 0, pos);
+	}
+
+	template<typename RankSelect>
+	uint64_t WatMatrixQueryGen<RankSelect>::count2d(uint64_t min_c, uint64_t max_c, uint64_t beg_pos, uint64_t end_pos) const {
+		if (min_c > max_val) return 0;
+		if (max_c <= min_c) return 0;
+		if (end_pos > length() || beg_pos > end_pos) return 0;
+		return range_less(max_c, beg_pos, end_pos) - range_less(min_c, beg_pos, end_pos);
+	}
+
+	template<typename RankSelect>
+	void WatMatrixQueryGen<RankSelect>::list_rec(unsigned int level, uint64_t beg, uint64_t end, uint64_t prefix,
+			uint64_t min_c, uint64_t max_c, ListCallback cb, void* context) const {
+		if (beg >= end) return;
+		if (level == bitwidth) {
+			if (prefix < min_c || prefix >= max_c) return;
+			for (uint64_t i = beg; i < end; ++i)
+				cb(context, prefix, trace_up(prefix, i));
+			return;
+		}
+		// values under the child with this prefix: [p << sh, (p + 1) << sh)
+		const unsigned int sh = bitwidth - level - 1;
+		const uint64_t r0b = rank0(level, beg), r0e = rank0(level, end);
+		uint64_t p = prefix << 1;
+		if ((p << sh) < max_c && ((p + 1) << sh) > min_c)
+			list_rec(level + 1, r0b, r0e, p, min_c, max_c, cb, context);
+		p += 1;
+		if ((p << sh) < max_c && ((p + 1) << sh) > min_c)
+			list_rec(level + 1, nzeros(level) + beg - r0b, nzeros(level) + end - r0e, p, min_c, max_c, cb, context);
+	}
+
+	template<typename RankSelect>
+	void WatMatrixQueryGen<RankSelect>::list_each(uint64_t min_c, uint64_t max_c, uint64_t beg_pos, uint64_t end_pos,
+			ListCallback cb, void* context) const {
+		if (min_c >= max_c || beg_pos >= end_pos) return;
+		if (end_pos > slength) end_pos = slength;
+		list_rec(0, beg_pos, end_pos, 0, min_c, max_c, cb, context);
+	}
+
+	template<typename RankSelect>
+	void WatMatrixQueryGen<RankSelect>::count_grid(const std::vector<unsigned int>& pos, const std::vector<unsigned int>& num,
+			std::vector<unsigned int> * result) const {
+		const size_t npos = pos.size();
+		result->assign(num.size() * npos, 0);
+		if (npos == 0) return;
+		assert(pos.back() <= slength);
+		// the numbers above all values count the whole prefix
+		size_t nlow = std::upper_bound(num.begin(), num.end(), max_val) - num.begin();
+		for (size_t i = nlow; i < num.size(); ++i)
+			std::copy(pos.begin(), pos.end(), result->begin() + i * npos);
+		if (nlow == 0) return;
+
+		// one group per node: the numbers [nbeg, nend) share its prefix,
+		// qpos are the ends of the prefixes inside the node, rank_lt their counts
+		struct Group {
+			uint64_t beg;
+			size_t nbeg, nend;
+			std::vector<uint64_t> qpos, rank_lt;
+		};
+		std::vector<Group> cur(1), next;
+		cur[0].beg = 0;
+		cur[0].nbeg = 0;
+		cur[0].nend = nlow;
+		cur[0].qpos.assign(pos.begin(), pos.end());
+		cur[0].rank_lt.assign(npos, 0);
+		std::vector<uint64_t> r0(npos);
+		for (unsigned int l = 0; l < bitwidth; ++l) {
+			next.clear();
+			const unsigned int sh = bitwidth - 1 - l;
+			for (size_t g = 0; g < cur.size(); ++g) {
+				const Group& q = cur[g];
+				size_t nmid = q.nbeg;
+				while (nmid < q.nend && (((uint64_t)num[nmid] >> sh) & 1) == 0) ++nmid;
+				const uint64_t r0beg = rank0(l, q.beg);
+				for (size_t j = 0; j < npos; ++j)
+					r0[j] = (j > 0 && q.qpos[j] == q.qpos[j - 1]) ? r0[j - 1] : rank0(l, q.qpos[j]);
+				if (nmid > q.nbeg) {
+					next.push_back(Group());
+					Group& z = next.back();
+					z.beg = r0beg;
+					z.nbeg = q.nbeg;
+					z.nend = nmid;
+					z.qpos.assign(r0.begin(), r0.end());
+					z.rank_lt = q.rank_lt;
+				}
+				if (nmid < q.nend) {
+					next.push_back(Group());
+					Group& o = next.back();
+					o.beg = nzeros(l) + q.beg - r0beg;
+					o.nbeg = nmid;
+					o.nend = q.nend;
+					o.qpos.resize(npos);
+					o.rank_lt.resize(npos);
+					for (size_t j = 0; j < npos; ++j) {
+						o.qpos[j] = nzeros(l) + q.qpos[j] - r0[j];
+						o.rank_lt[j] = q.rank_lt[j] + r0[j] - r0beg;
+					}
+				}
+			}
+			cur.swap(next);
+		}
+		for (size_t g = 0; g < cur.size(); ++g)
+			for (size_t i = cur[g].nbeg; i < cur[g].nend; ++i)
+				for (size_t j = 0; j < npos; ++j)
+					(*result)[i * npos + j] = (unsigned int) cur[g].rank_lt[j];
+	}
+
+	template<typename RankSelect>
+	std::string WatMatrixQueryGen<RankSelect>::to_str() const {
+		std::ostringstream ss;
+		ss << '{';
+		if (length() > 0)
+			ss << access(0);
+		for (unsigned int i = 1; i < length(); ++i)
+			ss << ',' << access(i);
+		ss << '}';
+		return ss.str();
+	}
+
+}//namespace
+
+#endif // __WAVELET_MATRIX_IMPL_
@@ -0,0 +1,194 @@
+#include "wat_matrix.h"
+#include "wat_array.h"
+#include "utils/utest.h"
+#include "mem/file_archive2.h"
+#include "mem/info_archive.h"
+
+#include <vector>
+#include <utility>
+#include <algorithm>
+
+namespace tests {
+
+using namespace std;
+using namespace mscds;
+
+static bool push_matrix_item(void * context, uint64_t c, uint64_t pos) {
+	vector<pair<uint64_t, uint64_t> > * v = (vector<pair<uint64_t, uint64_t> > *) context;
+	v->push_back(make_pair(c, pos));
+	return true;
+}
+
+template<typename WM>
+void check_matrix(const vector<uint64_t>& v, const WM& wm, unsigned int nq) {
+	uint64_t maxv = v.empty() ? 0 : *max_element(v.begin(), v.end());
+	ASSERT_EQ(v.size(), wm.length());
+	for (size_t i = 0; i < v.size(); ++i)
+		ASSERT_EQ(v[i], wm.access(i));
+	// rank and select of every value
+	vector<vector<uint64_t> > occ(maxv + 1);
+	for (size_t i = 0; i < v.size(); ++i)
+		occ[v[i]].push_back(i);
+	for (uint64_t c = 0; c <= maxv; ++c) {
+		for (size_t r = 0; r < occ[c].size(); ++r) {
+			ASSERT_EQ(occ[c][r], wm.select(c, r));
+			ASSERT_EQ(r, wm.rank(c, occ[c][r]));
+		}
+		ASSERT_EQ(WM::NOTFOUND, wm.select(c, occ[c].size()));
+	}
+	ASSERT_EQ(WM::NOTFOUND, wm.select(maxv + 1, 0));
+	for (unsigned int k = 0; k < nq; ++k) {
+		uint64_t c = rand() % (maxv + 2);
+		uint64_t b = rand() % (v.size() + 1), e = rand() % (v.size() + 1);
+		if (b > e) swap(b, e);
+		uint64_t lt = 0, eq = 0, gt = 0;
+		for (size_t i = 0; i < e; ++i)
+			if (v[i] < c) lt++;
+			else if (v[i] == c) eq++;
+			else gt++;
+		uint64_t r, rl, rm;
+		wm.rankAll(c, e, r, rl, rm);
+		ASSERT_EQ(eq, r);
+		ASSERT_EQ(lt, rl);
+		ASSERT_EQ(gt, rm);
+		ASSERT_EQ(lt, wm.rankLessThan(c, e));
+		ASSERT_EQ(gt, wm.rankMoreThan(c, e));
+
+		uint64_t c2 = c + rand() % 8, cnt = 0;
+		for (size_t i = b; i < e; ++i)
+			if (v[i] >= c && v[i] < c2) cnt++;
+		ASSERT_EQ(cnt, wm.count2d(c, c2, b, e));
+
+		vector<pair<uint64_t, uint64_t> > exp, rs;
+		for (size_t i = b; i < e; ++i)
+			if (v[i] >= c && v[i] < c2) exp.push_back(make_pair(v[i], i));
+		sort(exp.begin(), exp.end());
+		wm.list_each(c, c2, b, e, push_matrix_item, &rs);
+		ASSERT_EQ(exp, rs);
+
+		if (b < e) {
+			vector<uint64_t> sub(v.begin() + b, v.begin() + e);
+			sort(sub.begin(), sub.end());
+			uint64_t kk = rand() % (e - b), pos;
+			uint64_t val = wm.kthValue(b, e, kk, pos);
+			ASSERT_EQ(sub[kk], val);
+			ASSERT_EQ((size_t)(find(v.begin() + b, v.begin() + e, val) - v.begin()), pos);
+			ASSERT_EQ(sub.front(), wm.minValue(b, e, pos));
+			ASSERT_EQ(sub.back(), wm.maxValue(b, e, pos));
+		}
+	}
+}
+
+TEST(wat_matrix, handmade) {
+	uint64_t arr[8] = {2, 7, 1, 7, 3, 0, 4, 4};
+	vector<uint64_t> v(arr, arr + 8);
+	WatMatrixQuery wm;
+	WatMatrixBuilder::build(v, &wm);
+	// level 1 is sorted by the first bit, level 2 by the first two bits (stable)
+	ASSERT_EQ("01010011" "10101100" "10000111", wm.bit_layers().to_str());
+	ASSERT_EQ("{2,7,1,7,3,0,4,4}", wm.to_str());
+	check_matrix(v, wm, 200);
+}
+
+TEST(wat_matrix, random) {
+	unsigned int ranges[] = {2, 18, 100, 1000, 100000};
+	for (unsigned int k = 0; k < 5; ++k) {
+		vector<uint64_t> v;
+		for (int i = 0; i < 2000; ++i)
+			v.push_back(rand() % ranges[k]);
+		WatMatrixQuery wm;
+		WatMatrixBuilder::build(v, &wm);
+		check_matrix(v, wm, 1000);
+
+		vector<uint32_t> v32(v.begin(), v.end());
+		WatMatrixRRRQuery wr;
+		WatMatrixRRRBuilder::build(v32, &wr);
+		check_matrix(v, wr, 200);
+	}
+}
+
+TEST(wat_matrix, same_as_tree) {
+	vector<uint64_t> v;
+	for (int i = 0; i < 5000; ++i)
+		v.push_back(rand() % 300);
+	WatQuery wt;
+	WatBuilder::build(v, &wt);
+	WatMatrixQuery wm;
+	WatMatrixBuilder::build(v, &wm);
+	for (int k = 0; k < 2000; ++k) {
+		uint64_t c = rand() % 300, b = rand() % v.size(), e = rand() % (v.size() + 1);
+		if (b >= e) { b = 0; e = v.size(); }
+		ASSERT_EQ(wt.rankLessThan(c, e), wm.rankLessThan(c, e));
+		uint64_t p1, p2;
+		ASSERT_EQ(wt.kthValue(b, e, (e - b) / 2, p1), wm.kthValue(b, e, (e - b) / 2, p2));
+		ASSERT_EQ(p1, p2);
+	}
+}
+
+TEST(wat_matrix, parallel_build) {
+	uint64_t ranges[] = {2, 1000, 1ULL << 40};
+	for (unsigned int k = 0; k < 3; ++k) {
+		vector<uint64_t> v(300000 + rand() % 1000);
+		for (size_t i = 0; i < v.size(); ++i)
+			v[i] = (((uint64_t)rand() << 31) ^ rand()) % ranges[k];
+		WatMatrixQuery w1, w3;
+		WatMatrixBuilder::build(v, &w1, 1);
+		WatMatrixBuilder::build(v, &w3, 3);
+		const BitArrayInterface* b1 = w1.bit_layers().getBitArray(), * b3 = w3.bit_layers().getBitArray();
+		ASSERT_EQ(b1->length(), b3->length());
+		for (size_t i = 0; i < b1->word_count(); ++i)
+			ASSERT_EQ(b1->word(i), b3->word(i));
+		for (size_t i = 0; i < v.size(); i += 997)
+			ASSERT_EQ(v[i], w3.access(i));
+	}
+}
+
+TEST(wat_matrix, degenerate) {
+	WatMatrixQuery wm;
+	vector<uint64_t> v;
+	WatMatrixBuilder::build(v, &wm);
+	ASSERT_EQ(0u, wm.length());
+	ASSERT_EQ(0u, wm.rankLessThan(5, 0));
+	v.assign(100, 0);
+	WatMatrixBuilder::build(v, &wm);
+	check_matrix(v, wm, 100);
+	v.assign(100, 1);
+	WatMatrixBuilder::build(v, &wm);
+	check_matrix(v, wm, 100);
+}
+
+TEST(wat_matrix, count_grid) {
+	vector<uint64_t> v;
+	for (int i = 0; i < 3000; ++i)
+		v.push_back(rand() % 500);
+	WatMatrixQuery wm;
+	WatMatrixBuilder::build(v, &wm);
+	vector<unsigned int> X, Y, result;
+	for (int i = 0; i < 30; ++i) X.push_back(rand() % (v.size() + 1));
+	for (int i = 0; i < 20; ++i) Y.push_back(rand() % 520);
+	X.push_back(X[0]);
+	Y.push_back(Y[0]);
+	sort(X.begin(), X.end());
+	sort(Y.begin(), Y.end());
+	wm.count_grid(X, Y, &result);
+	ASSERT_EQ(X.size() * Y.size(), result.size());
+	for (size_t j = 0; j < Y.size(); ++j)
+		for (size_t i = 0; i < X.size(); ++i)
+			ASSERT_EQ(wm.rankLessThan(Y[j], X[i]), result[j * X.size() + i]);
+}
+
+TEST(wat_matrix, saveload) {
+	vector<uint64_t> v;
+	for (int i = 0; i < 3000; ++i)
+		v.push_back(rand() % 1000);
+	OMemArchive out;
+	WatMatrixBuilder::build(v, out);
+	out.close();
+	IMemArchive inp(out);
+	WatMatrixQuery wm;
+	wm.load(inp);
+	inp.close();
+	check_matrix(v, wm, 200);
+}
+
+}//namespace